@@ -0,0 +1,64 @@
+/**
+ * @file AllocationTracker.cpp
+ * @author John Korreck
+ */
+
+#include "AllocationTracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Plain data, so using it from operator new needs no thread-local constructor
+static thread_local AllocationCounts tCounts;
+static std::atomic<bool> gCounting{false};
+
+AllocationCounts ThreadAllocations() {
+    return tCounts;
+}
+
+bool AllocationTrackingEnabled() {
+    return gCounting.load(std::memory_order_relaxed);
+}
+
+void CountAllocation(size_t bytes) {
+    tCounts.allocations++;
+    tCounts.bytes += bytes;
+    if (!gCounting.load(std::memory_order_relaxed)) gCounting.store(true, std::memory_order_relaxed);
+}
+
+#ifdef CHESS_TRACK_ALLOCATIONS
+
+// The other forms (arrays, nothrow) go through these by default
+
+void* operator new(std::size_t size) {
+    CountAllocation(size);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    CountAllocation(size);
+    size_t align = static_cast<size_t>(alignment);
+    size_t rounded = (size + align - 1) / align * align;
+    if (void* p = std::aligned_alloc(align, rounded ? rounded : align)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+#endif
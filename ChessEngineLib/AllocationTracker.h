@@ -0,0 +1,41 @@
+/**
+ * @file AllocationTracker.h
+ * @author John Korreck
+ *
+ * Heap allocation counters, per thread. The instrumentation build
+ * (-DCHESS_TRACK_ALLOCATIONS=ON) replaces the global operator new and delete
+ * with versions that count here; otherwise nothing is counted and the hot path
+ * pays nothing. Searches report what they allocated in their stats, which is
+ * how allocations creeping back into the hot path get noticed.
+ */
+
+#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+
+struct AllocationCounts {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+
+    AllocationCounts operator-(const AllocationCounts& other) const {
+        return {allocations - other.allocations, bytes - other.bytes};
+    }
+    AllocationCounts& operator+=(const AllocationCounts& other) {
+        allocations += other.allocations;
+        bytes += other.bytes;
+        return *this;
+    }
+};
+
+/// Everything this thread has allocated since it started
+AllocationCounts ThreadAllocations();
+
+/// Whether allocations are being counted at all
+bool AllocationTrackingEnabled();
+
+/// Called by the operator new hooks
+void CountAllocation(size_t bytes);
+
+#endif //ALLOCATIONTRACKER_H
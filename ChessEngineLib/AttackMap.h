@@ -0,0 +1,81 @@
+/**
+ * @file AttackMap.h
+ * @author John Korreck
+ *
+ * Attack information for one position, computed once and shared by move
+ * legality, check detection and evaluation.
+ */
+
+#ifndef ATTACKMAP_H
+#define ATTACKMAP_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/// Bitboard bit for a square in Board layout (bit = rank * 8 + file)
+constexpr uint64_t SquareBit(int square) {
+    return 1ULL << square;
+}
+
+using SquareTable = std::array<uint64_t, 64>;
+
+/// Squares reached by single {file, rank} steps from each square
+template <size_t N>
+constexpr SquareTable GenerateStepAttacks(const int (&steps)[N][2]) {
+    SquareTable table{};
+    for (int square = 0; square < 64; square++) {
+        for (size_t i = 0; i < N; i++) {
+            int file = square % 8 + steps[i][0];
+            int rank = square / 8 + steps[i][1];
+            if (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+                table[square] |= SquareBit(rank * 8 + file);
+            }
+        }
+    }
+    return table;
+}
+
+constexpr int KnightSteps[8][2] = {{-2,-1},{-2,1},{-1,-2},{-1,2},{1,-2},{1,2},{2,-1},{2,1}};
+constexpr int KingSteps[8][2] = {{-1,-1},{-1,0},{-1,1},{0,-1},{0,1},{1,-1},{1,0},{1,1}};
+constexpr int WhitePawnSteps[2][2] = {{-1,-1},{1,-1}}; // white pawns move toward rank index 0
+constexpr int BlackPawnSteps[2][2] = {{-1,1},{1,1}};
+
+inline constexpr SquareTable KnightAttacks = GenerateStepAttacks(KnightSteps);
+inline constexpr SquareTable KingAttacks = GenerateStepAttacks(KingSteps);
+inline constexpr std::array<SquareTable, 2> PawnAttacks = {
+    GenerateStepAttacks(WhitePawnSteps), GenerateStepAttacks(BlackPawnSteps)
+};
+
+/// Squares strictly between two squares on a shared rank, file or diagonal; empty otherwise
+constexpr std::array<SquareTable, 64> GenerateBetween() {
+    std::array<SquareTable, 64> table{};
+    for (int from = 0; from < 64; from++) {
+        for (int i = 0; i < 8; i++) {
+            uint64_t path = 0;
+            for (int dist = 1; dist < 8; dist++) {
+                int file = from % 8 + KingSteps[i][0] * dist;
+                int rank = from / 8 + KingSteps[i][1] * dist;
+                if (file < 0 || file >= 8 || rank < 0 || rank >= 8) break;
+                table[from][rank * 8 + file] = path;
+                path |= SquareBit(rank * 8 + file);
+            }
+        }
+    }
+    return table;
+}
+
+inline constexpr std::array<SquareTable, 64> BetweenSquares = GenerateBetween();
+
+/// Index 0 is white, 1 is black. Attack sets include the first blocker of each ray.
+struct AttackMap {
+    uint64_t occupied[2] = {0, 0};
+    uint64_t bySide[2] = {0, 0};
+    uint64_t byPiece[2][7] = {};  // indexed by piece type
+    uint64_t checkers = 0;        // pieces giving check to the side to move
+    uint64_t pinned[2] = {0, 0};  // pieces pinned to their own king
+    uint64_t pinners[2] = {0, 0}; // enemy sliders doing the pinning
+    bool valid = false;
+};
+
+#endif //ATTACKMAP_H
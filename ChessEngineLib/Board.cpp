@@ -7,24 +7,27 @@
 
 #include "Board.h"
 #include "Engine.h"
+#include "Zobrist.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <bit>
 #include <cctype>
+#include <cstring>
 
 Board::Board(std::string& name, std::string& position) {
-    mChessPosition = position;
     mEngine = std::make_shared<Engine>();
-    FenParser(mChessPosition);
+    mHistory.reserve(512);
+    mKeyHistory.reserve(512);
+    mAttacks.reserve(512);
+    FenParser(position);
     GeneratePossibleMoves(false);
 }
 
-std::vector<std::vector<int>> Board::FenParser(std::string &fenString) {
+const BoardArray& Board::FenParser(std::string &fenString) {
     // Clear the board
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            mBoard[i][j] = 0;
-        }
+    for (auto& row : mBoard) {
+        row.fill(0);
     }
 
     std::stringstream ss(fenString);
@@ -69,13 +72,9 @@ std::vector<std::vector<int>> Board::FenParser(std::string &fenString) {
                 mBoard[rank][file] = pieceNum;
 
                 if (pieceNum == 6) {
-                    char fileChar = 'a' + file;
-                    char rankChar = '8' - rank;
-                    mWhiteKingSquare = std::string(1, fileChar) + std::string(1, rankChar);
+                    mWhiteKingSquare = rank * 8 + file;
                 } else if (pieceNum == -6) {
-                    char fileChar = 'a' + file;
-                    char rankChar = '8' - rank;
-                    mBlackKingSquare = std::string(1, fileChar) + std::string(1, rankChar);
+                    mBlackKingSquare = rank * 8 + file;
                 }
             }
             file++;
@@ -87,14 +86,71 @@ std::vector<std::vector<int>> Board::FenParser(std::string &fenString) {
     mWhiteCastlingQueensideRights = castlingRights.find('Q') != std::string::npos;
     mBlackCastlingKingsideRights = castlingRights.find('k') != std::string::npos;
     mBlackCastlingQueensideRights = castlingRights.find('q') != std::string::npos;
-    mEnPassantSquare = (enPassant == "-") ? "" : enPassant;
-
-    // Update check status after parsing FEN
-    UpdateCheckStatus();
+    mEnPassantSquare = ParseSquare(enPassant);
+    mHalfMoveClock = halfmove.empty() ? 0 : std::atoi(halfmove.c_str());
+    mFullMoveNumber = fullmove.empty() ? 1 : std::max(1, std::atoi(fullmove.c_str()));
 
+    ResetHistory();
     return mBoard;
 }
 
+PackedPosition Board::Pack() const {
+    PackedPosition packed;
+    for (int square = 0; square < 64; square++) {
+        packed.occupied |= uint64_t{mBoard[square / 8][square % 8] != 0} << square;
+    }
+    uint64_t occupied = packed.occupied;
+    for (int i = 0; occupied && i < 32; i++, occupied &= occupied - 1) {
+        int square = std::countr_zero(occupied);
+        packed.pieces[i / 2] |= PackPiece(mBoard[square / 8][square % 8]) << (i % 2 * 4);
+    }
+    packed.occupied ^= occupied;  // any pieces past the 32nd
+    packed.flags = (mWhiteTurn ? 0 : 1) | (CastlingMask() << 1);
+    packed.enPassant = mEnPassantSquare < 0 ? 64 : mEnPassantSquare;
+    packed.halfMoveClock = std::min(mHalfMoveClock, 65535);
+    packed.fullMoveNumber = mFullMoveNumber;
+    return packed;
+}
+
+void Board::Unpack(const PackedPosition& packed) {
+    for (auto& row : mBoard) {
+        row.fill(0);
+    }
+    mWhiteKingSquare = mBlackKingSquare = -1;
+    uint64_t occupied = packed.occupied;
+    for (int i = 0; occupied && i < 32; i++, occupied &= occupied - 1) {
+        int square = std::countr_zero(occupied);
+        int piece = UnpackPiece(packed.pieces[i / 2] >> (i % 2 * 4));
+        mBoard[square / 8][square % 8] = piece;
+        if (piece == 6) mWhiteKingSquare = square;
+        if (piece == -6) mBlackKingSquare = square;
+    }
+
+    mWhiteTurn = !(packed.flags & 1);
+    mWhiteCastlingKingsideRights = packed.flags & 2;
+    mWhiteCastlingQueensideRights = packed.flags & 4;
+    mBlackCastlingKingsideRights = packed.flags & 8;
+    mBlackCastlingQueensideRights = packed.flags & 16;
+    mEnPassantSquare = packed.enPassant < 64 ? packed.enPassant : -1;
+    mHalfMoveClock = packed.halfMoveClock;
+    mFullMoveNumber = std::max<uint32_t>(packed.fullMoveNumber, 1);
+
+    ResetHistory();
+}
+
+void Board::ResetHistory() {
+    mHistory.clear();
+    mKey = ComputeKey();
+    mPawnKey = ComputePawnKey();
+    mKeyHistory.assign(1, mKey);
+    mAttacks.assign(1, AttackMap());
+
+    // Accumulators describe the old position
+    if (mNetwork) {
+        SetNetwork(mNetwork);
+    }
+}
+
 std::string Board::GenerateFen() {
     std::string fen = "";
 
@@ -134,230 +190,416 @@ std::string Board::GenerateFen() {
     fen += " ";
 
     // En passant
-    fen += mEnPassantSquare.empty() ? "-" : mEnPassantSquare;
+    fen += mEnPassantSquare < 0 ? "-" : SquareName(mEnPassantSquare);
 
     // Halfmove and fullmove clocks
-    fen += " 0 1";
+    fen += " " + std::to_string(mHalfMoveClock) + " " + std::to_string(mFullMoveNumber);
 
     return fen;
 }
 
 bool Board::IsSquareAttacked(const std::string& square, bool byWhite) {
-    int targetFile = square[0] - 'a';
-    int targetRank = 8 - (square[1] - '0');
-
-    // Pawns
-    int pawnDir = byWhite ? 1 : -1; // white pawns attack upwards (rank -1), so they come from below
-    int pawnPiece = byWhite ? 1 : -1;
-    for (int i = 0; i < 2; i++) {
-        int file = targetFile + (i == 0 ? -1 : 1);
-        int rank = targetRank + pawnDir;
-        if (CheckBounds(file, rank)) {
-            int piece = mBoard[rank][file];
-            if (piece == pawnPiece)
-                return true;
-        }
-    }
+    int index = ParseSquare(square);
+    return index >= 0 && IsSquareAttacked(index, byWhite);
+}
 
-    // Knights
-    static const int knightMoves[8][2] = {{-2,-1},{-2,1},{-1,-2},{-1,2},{1,-2},{1,2},{2,-1},{2,1}};
-    for (const auto& move : knightMoves) {
-        int file = targetFile + move[0];
-        int rank = targetRank + move[1];
-        if (CheckBounds(file, rank) && mBoard[rank][file] == (byWhite ? 2 : -2))
-            return true;
-    }
+bool Board::IsSquareAttacked(int square, bool byWhite) const {
+    return (GetAttacks().bySide[byWhite ? 0 : 1] & SquareBit(square)) != 0;
+}
+
+bool Board::IsWhiteInCheck() const {
+    return mWhiteKingSquare >= 0 && IsSquareAttacked(mWhiteKingSquare, false);
+}
 
-    // King (only need to check adjacent squares)
-    static const int kingMoves[8][2] = {{-1,-1},{-1,0},{-1,1},{0,-1},{0,1},{1,-1},{1,0},{1,1}};
-    for (const auto& move : kingMoves) {
-        int file = targetFile + move[0];
-        int rank = targetRank + move[1];
-        if (CheckBounds(file, rank) && mBoard[rank][file] == (byWhite ? 6 : -6))
-            return true;
+bool Board::IsBlackInCheck() const {
+    return mBlackKingSquare >= 0 && IsSquareAttacked(mBlackKingSquare, true);
+}
+
+const AttackMap& Board::GetAttacks() const {
+    AttackMap& attacks = mAttacks.back();
+    if (!attacks.valid) {
+        ComputeAttacks(attacks);
     }
+    return attacks;
+}
 
-    // Sliding pieces
-    static const int bishopDirs[4][2] = {{1,1},{1,-1},{-1,1},{-1,-1}};
-    static const int rookDirs[4][2] = {{1,0},{-1,0},{0,1},{0,-1}};
+// Slider directions as {file, rank} steps
+static const int bishopSteps[4][2] = {{1,1},{1,-1},{-1,1},{-1,-1}};
+static const int rookSteps[4][2] = {{1,0},{-1,0},{0,1},{0,-1}};
 
-    // Check bishops/queens
-    for (const auto& dir : bishopDirs) {
+static uint64_t RayAttacks(const BoardArray& board, int file, int rank, const int (*steps)[2], int count) {
+    uint64_t attacks = 0;
+    for (int i = 0; i < count; i++) {
         for (int dist = 1; dist < 8; dist++) {
-            int file = targetFile + dir[0] * dist;
-            int rank = targetRank + dir[1] * dist;
-            if (!CheckBounds(file, rank)) break;
+            int newFile = file + steps[i][0] * dist;
+            int newRank = rank + steps[i][1] * dist;
+            if (newFile < 0 || newFile >= 8 || newRank < 0 || newRank >= 8) break;
+            attacks |= SquareBit(newRank * 8 + newFile);
+            if (board[newRank][newFile] != 0) break;
+        }
+    }
+    return attacks;
+}
 
-            int piece = mBoard[rank][file];
-            if (piece != 0) {
-                if ((byWhite && (piece == 3 || piece == 5)) ||
-                    (!byWhite && (piece == -3 || piece == -5)))
-                    return true;
+// True when c lies on the line through a and b
+static bool Aligned(int a, int b, int c) {
+    return (b % 8 - a % 8) * (c / 8 - a / 8) == (b / 8 - a / 8) * (c % 8 - a % 8);
+}
+
+void Board::ComputeAttacks(AttackMap& attacks) const {
+    attacks = AttackMap();
+    for (int square = 0; square < 64; square++) {
+        int piece = mBoard[square / 8][square % 8];
+        if (piece != 0) {
+            attacks.occupied[piece > 0 ? 0 : 1] |= SquareBit(square);
+        }
+    }
+
+    ComputeSideAttacks<true>(attacks);
+    ComputeSideAttacks<false>(attacks);
+    attacks.valid = true;
+}
+
+template <bool White>
+void Board::ComputeSideAttacks(AttackMap& attacks) const {
+    constexpr int side = White ? 0 : 1;
+    constexpr int sign = White ? 1 : -1;
+
+    // Only the side to move can be in check
+    int enemyKing = White != mWhiteTurn ? GetKingSquare(!White) : -1;
+    uint64_t enemyKingBit = enemyKing >= 0 ? SquareBit(enemyKing) : 0;
+
+    for (uint64_t pieces = attacks.occupied[side]; pieces; pieces &= pieces - 1) {
+        int square = std::countr_zero(pieces);
+        int file = square % 8;
+        int rank = square / 8;
+        int pieceType = mBoard[rank][file] * sign;
+
+        uint64_t pieceAttacks = 0;
+        switch (pieceType) {
+            case 1: pieceAttacks = PawnAttacks[side][square]; break;
+            case 2: pieceAttacks = KnightAttacks[square]; break;
+            case 3: pieceAttacks = RayAttacks(mBoard, file, rank, bishopSteps, 4); break;
+            case 4: pieceAttacks = RayAttacks(mBoard, file, rank, rookSteps, 4); break;
+            case 5:
+                pieceAttacks = RayAttacks(mBoard, file, rank, bishopSteps, 4) |
+                               RayAttacks(mBoard, file, rank, rookSteps, 4);
                 break;
-            }
+            case 6: pieceAttacks = KingAttacks[square]; break;
+        }
+
+        attacks.byPiece[side][pieceType] |= pieceAttacks;
+        attacks.bySide[side] |= pieceAttacks;
+        if (pieceAttacks & enemyKingBit) {
+            attacks.checkers |= SquareBit(square);
         }
     }
 
-    // Check rooks/queens
-    for (const auto& dir : rookDirs) {
+    // Pins: walk out from our king, an own piece followed by a matching enemy slider
+    int king = GetKingSquare(White);
+    if (king < 0) return;
+
+    for (int i = 0; i < 8; i++) {
+        const int* step = i < 4 ? bishopSteps[i] : rookSteps[i - 4];
+        int slider = i < 4 ? 3 : 4;
+        int candidate = -1;
         for (int dist = 1; dist < 8; dist++) {
-            int file = targetFile + dir[0] * dist;
-            int rank = targetRank + dir[1] * dist;
-            if (!CheckBounds(file, rank)) break;
+            int file = king % 8 + step[0] * dist;
+            int rank = king / 8 + step[1] * dist;
+            if (file < 0 || file >= 8 || rank < 0 || rank >= 8) break;
 
-            int piece = mBoard[rank][file];
-            if (piece != 0) {
-                if ((byWhite && (piece == 4 || piece == 5)) ||
-                    (!byWhite && (piece == -4 || piece == -5)))
-                    return true;
-                break;
+            int piece = mBoard[rank][file] * sign;
+            if (piece == 0) continue;
+            if (candidate < 0) {
+                if (piece < 0) break;
+                candidate = rank * 8 + file;
+                continue;
+            }
+            if (piece == -slider || piece == -5) {
+                attacks.pinned[side] |= SquareBit(candidate);
+                attacks.pinners[side] |= SquareBit(rank * 8 + file);
             }
+            break;
         }
     }
+}
 
-    return false;
+template <bool ByWhite>
+bool Board::ScanForAttack(int square) const {
+    constexpr int sign = ByWhite ? 1 : -1;
+    auto anyPiece = [&](uint64_t squares, int pieceType) {
+        for (; squares; squares &= squares - 1) {
+            int from = std::countr_zero(squares);
+            if (mBoard[from / 8][from % 8] == sign * pieceType) return true;
+        }
+        return false;
+    };
+
+    // A pawn of ours attacks the squares from which an enemy pawn would attack us
+    if (anyPiece(PawnAttacks[ByWhite ? 1 : 0][square], 1) ||
+        anyPiece(KnightAttacks[square], 2) ||
+        anyPiece(KingAttacks[square], 6)) {
+        return true;
+    }
+
+    int file = square % 8;
+    int rank = square / 8;
+    uint64_t diagonals = RayAttacks(mBoard, file, rank, bishopSteps, 4);
+    uint64_t lines = RayAttacks(mBoard, file, rank, rookSteps, 4);
+    return anyPiece(diagonals, 3) || anyPiece(lines, 4) || anyPiece(diagonals | lines, 5);
+}
+
+void Board::GenerateMoves(MoveList& moves) {
+    moves.Clear();
+    GeneratePseudoLegalMoves(moves, GetAttacks().checkers ? GenType::Evasions : GenType::All);
+
+    // Drop moves that leave our king attacked, compacting the list in place
+    int legalCount = 0;
+    for (int i = 0; i < moves.Size(); i++) {
+        if (IsLegal(moves[i])) {
+            moves[legalCount++] = moves[i];
+        }
+    }
+    moves.Resize(legalCount);
 }
 
 void Board::GeneratePossibleMoves(bool response) {
+    // Responses skip the legality filter
+    MoveList moves;
     if (response) {
-        mResponses.clear();
+        GeneratePseudoLegalMoves(moves);
     } else {
-        mPossibleMoves.clear();
+        GenerateMoves(moves);
     }
 
-    // Check for draw conditions first
-    // if (IsDraw()) {
-    //     return;
-    // }
+    mPossibleMoves.clear();
+    for (Move move : moves) {
+        mPossibleMoves.push_back(move.ToString());
+    }
+}
 
-    for (int rank = 0; rank < 8; rank++) {
-        for (int file = 0; file < 8; file++) {
-            int piece = mBoard[rank][file];
-            if (piece == 0) continue;
+void Board::GeneratePseudoLegalMoves(MoveList& moves, GenType type) {
+    // Dispatch once; everything below is specialised at compile time
+    switch (type) {
+        case GenType::All:
+            mWhiteTurn ? GeneratePseudoLegal<true, GenType::All>(moves)
+                       : GeneratePseudoLegal<false, GenType::All>(moves);
+            break;
+        case GenType::Captures:
+            mWhiteTurn ? GeneratePseudoLegal<true, GenType::Captures>(moves)
+                       : GeneratePseudoLegal<false, GenType::Captures>(moves);
+            break;
+        case GenType::Quiets:
+            mWhiteTurn ? GeneratePseudoLegal<true, GenType::Quiets>(moves)
+                       : GeneratePseudoLegal<false, GenType::Quiets>(moves);
+            break;
+        case GenType::Evasions:
+            mWhiteTurn ? GeneratePseudoLegal<true, GenType::Evasions>(moves)
+                       : GeneratePseudoLegal<false, GenType::Evasions>(moves);
+            break;
+    }
+}
 
-            bool isWhitePiece = piece > 0;
-            if (response || (isWhitePiece == mWhiteTurn)) {
-                char fileChar = 'a' + file;
-                char rankChar = '8' - rank;
-                std::string currentSquare = std::string(1, fileChar) + std::string(1, rankChar);
-
-                int pieceType = std::abs(piece);
-                switch (pieceType) {
-                case 1: GeneratePawnMoves(piece, file, rank, currentSquare, response); break;
-                case 2: GenerateKnightMoves(piece, file, rank, currentSquare, response); break;
-                case 3: GenerateDiagonalMoves(piece, file, rank, currentSquare, response); break;
-                case 4: GenerateSlidingMoves(piece, file, rank, currentSquare, response); break;
-                case 5:
-                    GenerateSlidingMoves(piece, file, rank, currentSquare, response);
-                    GenerateDiagonalMoves(piece, file, rank, currentSquare, response);
-                    break;
-                case 6: GenerateKingMoves(piece, file, rank, currentSquare, response); break;
+static void AddMoves(int from, uint64_t targets, MoveList& moves) {
+    for (; targets; targets &= targets - 1) {
+        moves.Add(Move(from, std::countr_zero(targets)));
+    }
+}
+
+template <bool White, GenType Type>
+void Board::GeneratePseudoLegal(MoveList& moves) {
+    constexpr int us = White ? 0 : 1;
+    constexpr int sign = White ? 1 : -1;
+
+    const AttackMap& attacks = GetAttacks();
+    uint64_t own = attacks.occupied[us];
+    uint64_t enemy = attacks.occupied[1 - us];
+    uint64_t empty = ~(own | enemy);
+    int king = GetKingSquare(White);
+
+    // Squares a non-king move may land on
+    uint64_t targets = Type == GenType::Captures ? enemy : Type == GenType::Quiets ? empty : ~own;
+    uint64_t kingTargets = targets;
+    if constexpr (Type == GenType::Evasions) {
+        if (attacks.checkers & (attacks.checkers - 1)) {
+            targets = 0; // Double check: only the king can move
+        } else if (attacks.checkers) {
+            int checker = std::countr_zero(attacks.checkers);
+            targets = attacks.checkers | BetweenSquares[king][checker];
+        }
+    }
+
+    for (uint64_t pieces = own; pieces; pieces &= pieces - 1) {
+        int square = std::countr_zero(pieces);
+        int file = square % 8;
+        int rank = square / 8;
+        switch (mBoard[rank][file] * sign) {
+            case 1: GeneratePawnMoves<White, Type>(square, Type == GenType::Evasions ? targets : ~0ULL,
+                                                   enemy, empty, moves); break;
+            case 2: AddMoves(square, KnightAttacks[square] & targets, moves); break;
+            case 3: AddMoves(square, RayAttacks(mBoard, file, rank, bishopSteps, 4) & targets, moves); break;
+            case 4: AddMoves(square, RayAttacks(mBoard, file, rank, rookSteps, 4) & targets, moves); break;
+            case 5:
+                AddMoves(square, (RayAttacks(mBoard, file, rank, bishopSteps, 4) |
+                                  RayAttacks(mBoard, file, rank, rookSteps, 4)) & targets, moves);
+                break;
+            case 6:
+                // Safety is checked by the legality filter
+                AddMoves(square, KingAttacks[square] & kingTargets & ~attacks.bySide[1 - us], moves);
+                if constexpr (Type == GenType::All || Type == GenType::Quiets) {
+                    if (CanCastle(true, White)) moves.Add(Move(square, square + 2));
+                    if (CanCastle(false, White)) moves.Add(Move(square, square - 2));
                 }
-            }
+                break;
         }
     }
+}
 
-    if (!response) {
-        std::vector<std::string> legalMoves;
-        for (const auto& move : mPossibleMoves) {
-            if (IsLegalMove(move)) {
-                legalMoves.push_back(move);
+template <bool White, GenType Type>
+void Board::GeneratePawnMoves(int square, uint64_t allowed, uint64_t enemy, uint64_t empty, MoveList& moves) {
+    constexpr int us = White ? 0 : 1;
+    constexpr int push = White ? -8 : 8;
+    constexpr int startRank = White ? 6 : 1;
+    constexpr int lastRank = White ? 0 : 7;
+
+    // Pawns reaching the last rank produce one move per promotion piece
+    auto add = [&](int to, bool capture) {
+        if (to / 8 == lastRank) {
+            for (int promotion = 5; promotion >= 2; promotion--) {
+                bool tactical = capture || promotion == 5;
+                if (Type == GenType::All || Type == GenType::Evasions || (Type == GenType::Captures) == tactical) {
+                    moves.Add(Move(square, to, promotion));
+                }
             }
+        } else if (Type == GenType::All || Type == GenType::Evasions || (Type == GenType::Captures) == capture) {
+            moves.Add(Move(square, to));
+        }
+    };
+
+    int to = square + push;
+    if (empty & SquareBit(to)) {
+        if (allowed & SquareBit(to)) add(to, false);
+        if (square / 8 == startRank && (empty & allowed & SquareBit(to + push))) {
+            add(to + push, false);
         }
-        mPossibleMoves = legalMoves;
     }
-}
 
-Board::BoardState Board::SaveState() {
-    BoardState state;
-    state.board = mBoard;
-    state.whiteKingSquare = mWhiteKingSquare;
-    state.blackKingSquare = mBlackKingSquare;
-    state.whiteTurn = mWhiteTurn;
-    state.whiteCastlingKingside = mWhiteCastlingKingsideRights;
-    state.whiteCastlingQueenside = mWhiteCastlingQueensideRights;
-    state.blackCastlingKingside = mBlackCastlingKingsideRights;
-    state.blackCastlingQueenside = mBlackCastlingQueensideRights;
-    state.enPassant = mEnPassantSquare;
-    return state;
+    for (uint64_t captures = PawnAttacks[us][square] & enemy & allowed; captures; captures &= captures - 1) {
+        add(std::countr_zero(captures), true);
+    }
+
+    // En passant can answer a check from the pushed pawn without landing on its square
+    if (mEnPassantSquare >= 0 && (PawnAttacks[us][square] & SquareBit(mEnPassantSquare))) {
+        add(mEnPassantSquare, true);
+    }
 }
 
-void Board::RestoreState(const BoardState& state) {
-    mBoard = state.board;
-    mWhiteKingSquare = state.whiteKingSquare;
-    mBlackKingSquare = state.blackKingSquare;
-    mWhiteTurn = state.whiteTurn;
-    mWhiteCastlingKingsideRights = state.whiteCastlingKingside;
-    mWhiteCastlingQueensideRights = state.whiteCastlingQueenside;
-    mBlackCastlingKingsideRights = state.blackCastlingKingside;
-    mBlackCastlingQueensideRights = state.blackCastlingQueenside;
-    mEnPassantSquare = state.enPassant;
+Move Board::ParseMove(const std::string& move) const {
+    int from = ParseSquare(move.substr(0, 2));
+    int to = move.length() >= 4 ? ParseSquare(move.substr(2, 2)) : -1;
+    if (from < 0 || to < 0) return Move();
+
+    int promotion = 0;
+    if (move.length() >= 5) {
+        switch (std::tolower(move[4])) {
+            case 'n': promotion = 2; break;
+            case 'b': promotion = 3; break;
+            case 'r': promotion = 4; break;
+            case 'q': promotion = 5; break;
+        }
+    }
+
+    // Four-character pawn moves to the last rank promote to a queen
+    int toRank = to / 8;
+    if (!promotion && std::abs(mBoard[from / 8][from % 8]) == 1 && (toRank == 0 || toRank == 7)) {
+        promotion = 5;
+    }
+    return Move(from, to, promotion);
 }
 
 bool Board::IsLegalMove(const std::string& move) {
-    if (move.length() < 4) return false;
+    Move parsed = ParseMove(move);
+    if (parsed.IsNull()) return false;
 
-    // Save state
-    BoardState savedState = SaveState();
+    MoveList moves;
+    GenerateMoves(moves);
+    return moves.Contains(parsed);
+}
 
-    // Make the move temporarily
-    int fromFile = move[0] - 'a';
-    int fromRank = 8 - (move[1] - '0');
-    int toFile = move[2] - 'a';
-    int toRank = 8 - (move[3] - '0');
+bool Board::IsLegal(Move move) {
+    int fromRank = move.From() / 8, fromFile = move.From() % 8;
+    int toRank = move.To() / 8, toFile = move.To() % 8;
     int piece = mBoard[fromRank][fromFile];
-    int captured = mBoard[toRank][toFile];
-
-    // Special case: en passant
-    if (abs(piece) == 1 && !mEnPassantSquare.empty() &&
-        toFile == (mEnPassantSquare[0] - 'a') &&
-        toRank == (8 - (mEnPassantSquare[1] - '0'))) {
-        captured = mBoard[fromRank][toFile]; // Captured pawn is on same file
+    int side = piece > 0 ? 0 : 1;
+    int kingSquare = GetKingSquare(piece > 0);
+    const AttackMap& attacks = GetAttacks();
+
+    if (std::abs(piece) == 6) {
+        // CanCastle has already checked every square the king crosses
+        if (std::abs(toFile - fromFile) == 2) return true;
+        if (attacks.bySide[1 - side] & SquareBit(move.To())) return false;
+
+        // Stepping back along a checking ray is still check, as the king no longer blocks it
+        for (uint64_t checkers = attacks.checkers; checkers; checkers &= checkers - 1) {
+            int checker = std::countr_zero(checkers);
+            int checkerType = std::abs(mBoard[checker / 8][checker % 8]);
+            if (checkerType >= 3 && checkerType <= 5 && move.To() != checker &&
+                Aligned(checker, kingSquare, move.To())) {
+                return false;
+            }
         }
-
-    // Make the move on board
-    mBoard[fromRank][fromFile] = 0;
-    mBoard[toRank][toFile] = piece;
-
-    // Update king position if moving king
-    std::string kingSquare;
-    if (abs(piece) == 6) {
-        kingSquare = move.substr(2, 2);
-        if (piece > 0) mWhiteKingSquare = kingSquare;
-        else mBlackKingSquare = kingSquare;
-    } else {
-        kingSquare = (piece > 0) ? mWhiteKingSquare : mBlackKingSquare;
+        return true;
     }
 
-    // Check if king is in check
-    bool inCheck = IsSquareAttacked(kingSquare, piece < 0);
+    // En passant removes a pawn that isn't on the target square, which can
+    // expose the king along the rank; try it on the board
+    if (std::abs(piece) == 1 && move.To() == mEnPassantSquare && fromFile != toFile) {
+        int captured = mBoard[toRank][toFile];
+        int epPiece = mBoard[fromRank][toFile];
+        mBoard[fromRank][toFile] = 0;
+        mBoard[fromRank][fromFile] = 0;
+        mBoard[toRank][toFile] = piece;
+
+        bool inCheck = piece > 0 ? ScanForAttack<false>(kingSquare) : ScanForAttack<true>(kingSquare);
+
+        mBoard[fromRank][fromFile] = piece;
+        mBoard[toRank][toFile] = captured;
+        mBoard[fromRank][toFile] = epPiece;
+        return !inCheck;
+    }
 
-    // Restore state
-    RestoreState(savedState);
+    // Pinned pieces may only move along the pin
+    if ((attacks.pinned[side] & SquareBit(move.From())) && !Aligned(kingSquare, move.From(), move.To())) {
+        return false;
+    }
 
-    return !inCheck;
+    // In check: capture the checker or block it; double check leaves only king moves
+    if (attacks.checkers) {
+        if (attacks.checkers & (attacks.checkers - 1)) return false;
+        int checker = std::countr_zero(attacks.checkers);
+        return ((attacks.checkers | BetweenSquares[kingSquare][checker]) & SquareBit(move.To())) != 0;
+    }
+    return true;
 }
 
 void Board::UpdateCheckStatus() {
-    mWhiteInCheck = false;
-    mBlackInCheck = false;
-
-    // Check white king attacks
-    std::string kingSquare = mWhiteKingSquare;
-    if (IsSquareAttacked(kingSquare, false)) {  // false = by black
-        mWhiteInCheck = true;
-    }
+    // Recomputed with the rest of the attack map on next use
+    mAttacks.back().valid = false;
+}
 
-    // Check black king attacks
-    kingSquare = mBlackKingSquare;
-    if (IsSquareAttacked(kingSquare, true)) {   // true = by white
-        mBlackInCheck = true;
-    }
+int Board::CastlingMask() const {
+    return (mWhiteCastlingKingsideRights ? 1 : 0) | (mWhiteCastlingQueensideRights ? 2 : 0) |
+           (mBlackCastlingKingsideRights ? 4 : 0) | (mBlackCastlingQueensideRights ? 8 : 0);
 }
 
 void Board::MakeMove(const std::string& move) {
     if (move.length() < 4) return;
+    Move parsed = ParseMove(move);
+    if (parsed.IsNull()) return;
+    MakeMove(parsed);
+}
 
+void Board::MakeMove(Move move) {
     // Save current state to history
     MoveHistory history;
     history.move = move;
@@ -370,33 +612,50 @@ void Board::MakeMove(const std::string& move) {
     history.blackKingSquare = mBlackKingSquare;
     history.halfMoveClock = mHalfMoveClock;
     history.fullMoveNumber = mFullMoveNumber;
+    history.key = mKey;
+    history.pawnKey = mPawnKey;
+
+    int fromSquare = move.From();
+    int toSquare = move.To();
+    int fromFile = fromSquare % 8;
+    int fromRank = fromSquare / 8;
+    int toFile = toSquare % 8;
+    int toRank = toSquare / 8;
+
+    // Remove the old castling/en passant contributions before they change
+    mKey ^= Zobrist.castling[CastlingMask()];
+    if (mEnPassantSquare >= 0) mKey ^= Zobrist.enPassant[mEnPassantSquare % 8];
 
-    int fromFile = move[0] - 'a';
-    int fromRank = 8 - (move[1] - '0');
-    int toFile = move[2] - 'a';
-    int toRank = 8 - (move[3] - '0');
+    // Pieces that changed, for the incremental keys and the NNUE accumulator
+    DirtyPiece dirty[4];
+    int dirtyCount = 0;
 
     // Handle capture (save captured piece)
+    int piece = mBoard[fromRank][fromFile];
+    history.movedPiece = piece;
     history.capturedPiece = mBoard[toRank][toFile];
-    if (history.capturedPiece != 0 || (abs(mBoard[fromRank][fromFile]) == 1 && toFile != fromFile)) {
+    if (history.capturedPiece != 0 || abs(piece) == 1) {
         mHalfMoveClock = 0; // Reset on capture or pawn move
     } else {
         mHalfMoveClock++;
     }
+    if (history.capturedPiece != 0) {
+        dirty[dirtyCount++] = {history.capturedPiece, toSquare, -1};
+    }
 
     // Move the piece
-    int piece = mBoard[fromRank][fromFile];
     mBoard[fromRank][fromFile] = 0;
     mBoard[toRank][toFile] = piece;
+    int movedIndex = dirtyCount;
+    dirty[dirtyCount++] = {piece, fromSquare, toSquare};
 
     // Handle special moves
     if (abs(piece) == 6) { // King moved
         // Update king position
-        std::string newSquare = move.substr(2, 2);
         if (piece > 0) {
-            mWhiteKingSquare = newSquare;
+            mWhiteKingSquare = toSquare;
         } else {
-            mBlackKingSquare = newSquare;
+            mBlackKingSquare = toSquare;
         }
 
         // Remove castling rights
@@ -418,6 +677,7 @@ void Board::MakeMove(const std::string& move) {
             int rookPiece = mBoard[rookRank][rookFromFile];
             mBoard[rookRank][rookFromFile] = 0;
             mBoard[rookRank][rookToFile] = rookPiece;
+            dirty[dirtyCount++] = {rookPiece, rookRank * 8 + rookFromFile, rookRank * 8 + rookToFile};
         }
     }
     else if (abs(piece) == 4) { // Rook moved
@@ -431,25 +691,34 @@ void Board::MakeMove(const std::string& move) {
         }
     }
 
+    // A rook captured on its starting square takes its castling right with it
+    if (toRank == 7 && toFile == 0) mWhiteCastlingQueensideRights = false;
+    if (toRank == 7 && toFile == 7) mWhiteCastlingKingsideRights = false;
+    if (toRank == 0 && toFile == 0) mBlackCastlingQueensideRights = false;
+    if (toRank == 0 && toFile == 7) mBlackCastlingKingsideRights = false;
+
     // Handle en passant
-    mEnPassantSquare = "";
+    int previousEnPassant = mEnPassantSquare;
+    mEnPassantSquare = -1;
     if (abs(piece) == 1 && abs(fromRank - toRank) == 2) {
         int epRank = (piece > 0) ? toRank + 1 : toRank - 1;
-        mEnPassantSquare = move.substr(0, 1) + std::to_string(8 - epRank);
+        mEnPassantSquare = epRank * 8 + toFile;
     }
-    else if (abs(piece) == 1 && !history.enPassantSquare.empty() &&
-             toFile == (history.enPassantSquare[0] - 'a') &&
-             toRank == (8 - (history.enPassantSquare[1] - '0'))) {
+    else if (abs(piece) == 1 && toSquare == previousEnPassant && fromFile != toFile) {
         // Handle en passant capture
         int capturedPawnRank = (piece > 0) ? toRank + 1 : toRank - 1;
         history.capturedPiece = mBoard[capturedPawnRank][toFile];
         mBoard[capturedPawnRank][toFile] = 0;
+        dirty[dirtyCount++] = {history.capturedPiece, capturedPawnRank * 8 + toFile, -1};
     }
 
-    // Handle promotion (auto-queen)
+    // Handle promotion (queen unless the move says otherwise)
     if (abs(piece) == 1 && (toRank == 0 || toRank == 7)) {
-        int promoPiece = (piece > 0) ? 5 : -5; // Auto-queen
+        int promoType = move.Promotion() ? move.Promotion() : 5;
+        int promoPiece = (piece > 0) ? promoType : -promoType;
         mBoard[toRank][toFile] = promoPiece;
+        dirty[movedIndex].toSquare = -1;
+        dirty[dirtyCount++] = {promoPiece, -1, toSquare};
     }
 
     // Update move counters
@@ -458,24 +727,40 @@ void Board::MakeMove(const std::string& move) {
     }
 
     mWhiteTurn = !mWhiteTurn;
-    mChessPosition = GenerateFen();
+
+    // Incremental hash keys
+    for (int i = 0; i < dirtyCount; i++) {
+        const DirtyPiece& d = dirty[i];
+        uint64_t from = d.fromSquare >= 0 ? Zobrist.pieces[d.piece + 6][d.fromSquare] : 0;
+        uint64_t to = d.toSquare >= 0 ? Zobrist.pieces[d.piece + 6][d.toSquare] : 0;
+        mKey ^= from ^ to;
+        if (abs(d.piece) == 1) mPawnKey ^= from ^ to;
+    }
+    mKey ^= Zobrist.side ^ Zobrist.castling[CastlingMask()];
+    if (mEnPassantSquare >= 0) mKey ^= Zobrist.enPassant[mEnPassantSquare % 8];
+
     mHistory.push_back(history);
-    mPositionHistory[mChessPosition]++;
+    mKeyHistory.push_back(mKey);
+    mAttacks.emplace_back();
+
+    if (mNetwork) {
+        UpdateAccumulator(dirty, dirtyCount, piece);
+    }
 }
 
 void Board::UndoMove() {
     if (mHistory.empty()) return;
 
     const MoveHistory& history = mHistory.back();
-    std::string move = history.move;
+    Move move = history.move;
 
-    int fromFile = move[0] - 'a';
-    int fromRank = 8 - (move[1] - '0');
-    int toFile = move[2] - 'a';
-    int toRank = 8 - (move[3] - '0');
+    int fromFile = move.From() % 8;
+    int fromRank = move.From() / 8;
+    int toFile = move.To() % 8;
+    int toRank = move.To() / 8;
 
-    // Move piece back
-    int piece = mBoard[toRank][toFile];
+    // Move piece back (the original piece, in case it was promoted)
+    int piece = history.movedPiece;
     mBoard[fromRank][fromFile] = piece;
     mBoard[toRank][toFile] = history.capturedPiece;
 
@@ -501,10 +786,9 @@ void Board::UndoMove() {
     }
 
     // Handle en passant undo
-    if (abs(piece) == 1 && !history.enPassantSquare.empty() &&
-        toFile == (history.enPassantSquare[0] - 'a') &&
-        toRank == (8 - (history.enPassantSquare[1] - '0'))) {
+    if (abs(piece) == 1 && move.To() == history.enPassantSquare && fromFile != toFile) {
         int capturedPawnRank = (piece > 0) ? toRank + 1 : toRank - 1;
+        mBoard[toRank][toFile] = 0;
         mBoard[capturedPawnRank][toFile] = history.capturedPiece;
     }
 
@@ -514,324 +798,352 @@ void Board::UndoMove() {
     mBlackCastlingKingsideRights = history.blackCastlingKingside;
     mBlackCastlingQueensideRights = history.blackCastlingQueenside;
     mEnPassantSquare = history.enPassantSquare;
+    mHalfMoveClock = history.halfMoveClock;
+    mFullMoveNumber = history.fullMoveNumber;
+    mKey = history.key;
+    mPawnKey = history.pawnKey;
     mWhiteTurn = !mWhiteTurn;
-    mChessPosition = GenerateFen();
 
     mHistory.pop_back();
+    mKeyHistory.pop_back();
+    mAttacks.pop_back();
+
+    if (mNetwork) {
+        if (mAccumulators.size() > 1) {
+            mAccumulators.pop_back();
+        } else {
+            // Undoing past the point the network was attached
+            RefreshAccumulator(0);
+            RefreshAccumulator(1);
+        }
+    }
 }
 
+bool Board::IsRepetition(int times) const {
+    // Only positions since the last capture or pawn move can recur, with the same side to move
+    int last = static_cast<int>(mKeyHistory.size()) - 1;
+    int oldest = std::max(0, last - mHalfMoveClock);
+    int count = 0;
+    for (int i = last - 2; i >= oldest; i -= 2) {
+        if (mKeyHistory[i] == mKey && ++count >= times) return true;
+    }
+    return false;
+}
 
-bool Board::IsPinned(int file, int rank) {
-    BoardState savedState = SaveState();
-    int piece = mBoard[rank][file];
-    mBoard[rank][file] = 0; // Temporarily remove piece
+int Board::CountMoves(int depth) {
+    if (depth == 0) return 1;
 
-    bool inCheck = (piece > 0) ?
-        IsSquareAttacked(mWhiteKingSquare, false) :
-        IsSquareAttacked(mBlackKingSquare, true);
+    MoveList moves;
+    GenerateMoves(moves);
+    if (depth == 1) return moves.Size();
 
-    RestoreState(savedState);
-    return inCheck;
+    int count = 0;
+    for (Move move : moves) {
+        MakeMove(move);
+        count += CountMoves(depth - 1);
+        UndoMove();
+    }
+    return count;
 }
 
-bool Board::CanCastle(bool kingside, bool white) {
-    if (white) {
-        if (kingside && !mWhiteCastlingKingsideRights) return false;
-        if (!kingside && !mWhiteCastlingQueensideRights) return false;
-    } else {
-        if (kingside && !mBlackCastlingKingsideRights) return false;
-        if (!kingside && !mBlackCastlingQueensideRights) return false;
+uint64_t Board::ComputeKey() const {
+    uint64_t key = 0;
+    for (int rank = 0; rank < 8; rank++) {
+        for (int file = 0; file < 8; file++) {
+            key ^= Zobrist.pieces[mBoard[rank][file] + 6][rank * 8 + file];
+        }
     }
+    if (!mWhiteTurn) key ^= Zobrist.side;
+    key ^= Zobrist.castling[CastlingMask()];
+    if (mEnPassantSquare >= 0) key ^= Zobrist.enPassant[mEnPassantSquare % 8];
+    return key;
+}
 
-    int rank = white ? 7 : 0;
-    std::string kingPos = white ? mWhiteKingSquare : mBlackKingSquare;
-    int kingFile = kingPos[0] - 'a';
-
-    // Check squares between king and rook aren't under attack
-    for (int file = kingside ? kingFile+1 : kingFile-1;
-         file != (kingside ? 7 : 0);
-         kingside ? file++ : file--) {
-        std::string square = std::string(1, 'a'+file) + std::to_string(8-rank);
-        if (mBoard[rank][file] != 0 || IsSquareAttacked(square, !white)) {
-            return false;
+uint64_t Board::ComputePawnKey() const {
+    uint64_t key = 0;
+    for (int rank = 0; rank < 8; rank++) {
+        for (int file = 0; file < 8; file++) {
+            int piece = mBoard[rank][file];
+            if (abs(piece) == 1) {
+                key ^= Zobrist.pieces[piece + 6][rank * 8 + file];
+            }
         }
     }
-    return true;
+    return key;
 }
 
-bool Board::CheckBounds(int file, int rank) {
-    return file >= 0 && file < 8 && rank >= 0 && rank < 8;
-}
+void Board::SetNetwork(const NnueNetwork* network) {
+    // Features are indexed by king square; a position missing a king evaluates classically
+    mNetwork = GetKingSquare(true) >= 0 && GetKingSquare(false) >= 0 ? network : nullptr;
+    mAccumulators.clear();
+    if (!mNetwork) return;
 
-void Board::GeneratePawnMoves(int pieceNum, int file, int rank, std::string currentSquare, bool response) {
-    bool isWhite = pieceNum > 0;
-    bool isPinned = IsPinned(file, rank);
-    auto& moves = response ? mResponses : mPossibleMoves;
-    int direction = isWhite ? -1 : 1;
-    int startRank = isWhite ? 6 : 1;
+    mAccumulators.reserve(256);
+    mAccumulators.emplace_back();
+    RefreshAccumulator(0);
+    RefreshAccumulator(1);
+}
 
-    // Forward moves
-    int newRank = rank + direction;
-    if (CheckBounds(file, newRank) && mBoard[newRank][file] == 0) {
-        if (!isPinned || IsPinnedDirectionValid(file, rank, isWhite, 0, direction)) {
-            if (IsMoveLegal(pieceNum, file, rank, file, newRank)) {
-                AddMove(currentSquare, file, newRank, moves);
+void Board::RefreshAccumulator(int perspective) {
+    int kingIndex = GetKingSquare(perspective == 0);
 
-                // Double push
-                if (rank == startRank && mBoard[rank + 2*direction][file] == 0) {
-                    if (IsMoveLegal(pieceNum, file, rank, file, rank + 2*direction)) {
-                        AddMove(currentSquare, file, rank + 2*direction, moves);
-                    }
-                }
-            }
+    int features[32];
+    int count = 0;
+    for (int rank = 0; rank < 8; rank++) {
+        for (int file = 0; file < 8; file++) {
+            int piece = mBoard[rank][file];
+            if (piece == 0 || abs(piece) == 6 || count == 32) continue;
+            features[count++] = NnueNetwork::FeatureIndex(perspective, kingIndex, piece, rank * 8 + file);
         }
     }
+    mNetwork->RefreshAccumulator(mAccumulators.back(), perspective, features, count);
+}
 
-    // Captures
-    for (int i = -1; i <= 1; i += 2) {
-        int newFile = file + i;
-        if (CheckBounds(newFile, newRank)) {
-            // Normal capture
-            int target = mBoard[newRank][newFile];
-            if (target != 0 && (target > 0) != isWhite) {
-                if (!isPinned || IsPinnedDirectionValid(file, rank, isWhite, i, direction)) {
-                    if (IsMoveLegal(pieceNum, file, rank, newFile, newRank)) {
-                        AddMove(currentSquare, newFile, newRank, moves);
-                    }
-                }
+void Board::UpdateAccumulator(const DirtyPiece* dirty, int count, int movedPiece) {
+    mAccumulators.push_back(mAccumulators.back());
+
+    for (int perspective = 0; perspective < 2; perspective++) {
+        // HalfKP features are relative to our own king, so a king move changes all of them
+        if (abs(movedPiece) == 6 && (movedPiece > 0) == (perspective == 0)) {
+            RefreshAccumulator(perspective);
+            continue;
+        }
+
+        int kingIndex = GetKingSquare(perspective == 0);
+        NnueAccumulator& acc = mAccumulators.back();
+
+        for (int i = 0; i < count; i++) {
+            if (abs(dirty[i].piece) == 6) continue;
+            if (dirty[i].fromSquare >= 0) {
+                mNetwork->SubFeature(acc, perspective,
+                    NnueNetwork::FeatureIndex(perspective, kingIndex, dirty[i].piece, dirty[i].fromSquare));
             }
-            // En passant
-            else if (!mEnPassantSquare.empty() && newFile == (mEnPassantSquare[0]-'a') &&
-                    newRank == (8-(mEnPassantSquare[1]-'0'))) {
-                if (!isPinned || IsPinnedDirectionValid(file, rank, isWhite, i, direction)) {
-                    if (IsMoveLegal(pieceNum, file, rank, newFile, newRank)) {
-                        AddMove(currentSquare, newFile, newRank, moves);
-                    }
-                }
+            if (dirty[i].toSquare >= 0) {
+                mNetwork->AddFeature(acc, perspective,
+                    NnueNetwork::FeatureIndex(perspective, kingIndex, dirty[i].piece, dirty[i].toSquare));
             }
         }
     }
 }
 
-void Board::GenerateKnightMoves(int pieceNum, int file, int rank, std::string currentSquare, bool response) {
-    if (IsPinned(file, rank)) return; // Knights can't move if pinned
 
-    static const int knightMoves[8][2] = {{-2,-1},{-2,1},{-1,-2},{-1,2},{1,-2},{1,2},{2,-1},{2,1}};
-    auto& moves = response ? mResponses : mPossibleMoves;
-    bool isWhite = pieceNum > 0;
-
-    for (const auto& move : knightMoves) {
-        int newFile = file + move[0];
-        int newRank = rank + move[1];
-        if (CheckBounds(newFile, newRank)) {
-            int target = mBoard[newRank][newFile];
-            if (target == 0 || (target > 0) != isWhite) {
-                if (IsMoveLegal(pieceNum, file, rank, newFile, newRank)) {
-                    AddMove(currentSquare, newFile, newRank, moves);
-                }
-            }
-        }
-    }
+bool Board::IsPinned(int file, int rank) {
+    int piece = mBoard[rank][file];
+    if (piece == 0 || abs(piece) == 6) return false;
+    return (GetAttacks().pinned[piece > 0 ? 0 : 1] & SquareBit(rank * 8 + file)) != 0;
 }
 
-void Board::GenerateSlidingMoves(int pieceNum, int file, int rank, std::string currentSquare, bool response) {
-    bool isWhite = pieceNum > 0;
-    bool isPinned = IsPinned(file, rank);
-    auto& moves = response ? mResponses : mPossibleMoves;
-    static const int rookDirs[4][2] = {{1,0},{-1,0},{0,1},{0,-1}};
+bool Board::CanCastle(bool kingside, bool white) {
+    if (white) {
+        if (kingside && !mWhiteCastlingKingsideRights) return false;
+        if (!kingside && !mWhiteCastlingQueensideRights) return false;
+    } else {
+        if (kingside && !mBlackCastlingKingsideRights) return false;
+        if (!kingside && !mBlackCastlingQueensideRights) return false;
+    }
 
-    for (const auto& dir : rookDirs) {
-        if (isPinned && !IsPinnedDirectionValid(file, rank, isWhite, dir[0], dir[1])) continue;
+    int rank = white ? 7 : 0;
+    int kingFile = 4;
+    int rookFile = kingside ? 7 : 0;
+    if (mBoard[rank][kingFile] != (white ? 6 : -6) || mBoard[rank][rookFile] != (white ? 4 : -4)) {
+        return false;
+    }
 
-        for (int dist = 1; dist < 8; dist++) {
-            int newFile = file + dir[0]*dist;
-            int newRank = rank + dir[1]*dist;
-            if (!CheckBounds(newFile, newRank)) break;
-
-            int target = mBoard[newRank][newFile];
-            if (target == 0) {
-                if (IsMoveLegal(pieceNum, file, rank, newFile, newRank)) {
-                    AddMove(currentSquare, newFile, newRank, moves);
-                }
-            } else {
-                if ((target > 0) != isWhite && IsMoveLegal(pieceNum, file, rank, newFile, newRank)) {
-                    AddMove(currentSquare, newFile, newRank, moves);
-                }
-                break;
-            }
+    // Squares between king and rook must be empty
+    for (int file = std::min(kingFile, rookFile) + 1; file < std::max(kingFile, rookFile); file++) {
+        if (mBoard[rank][file] != 0) {
+            return false;
         }
     }
+
+    // The king may not leave, cross or land on an attacked square
+    uint64_t kingPath = kingside ? 0x70ULL : 0x1CULL; // e-g or c-e on the 8th rank
+    return (GetAttacks().bySide[white ? 1 : 0] & (kingPath << (rank * 8))) == 0;
 }
 
-void Board::GenerateDiagonalMoves(int pieceNum, int file, int rank, std::string currentSquare, bool response) {
-    bool isWhite = pieceNum > 0;
-    bool isPinned = IsPinned(file, rank);
-    auto& moves = response ? mResponses : mPossibleMoves;
-    static const int bishopDirs[4][2] = {{1,1},{1,-1},{-1,1},{-1,-1}};
+bool Board::IsTactical(Move move) const {
+    int piece = mBoard[move.From() / 8][move.From() % 8];
+    bool capture = mBoard[move.To() / 8][move.To() % 8] != 0 ||
+                   (std::abs(piece) == 1 && move.From() % 8 != move.To() % 8);
+    return capture || move.Promotion() == 5;
+}
 
-    for (const auto& dir : bishopDirs) {
-        if (isPinned && !IsPinnedDirectionValid(file, rank, isWhite, dir[0], dir[1])) continue;
+// Exchange values for SEE, indexed by piece type
+static const int seeValues[7] = {0, 100, 320, 330, 500, 900, 20000};
 
+static uint64_t SliderAttacks(uint64_t occupied, int square, const int (*steps)[2]) {
+    uint64_t attacks = 0;
+    for (int i = 0; i < 4; i++) {
         for (int dist = 1; dist < 8; dist++) {
-            int newFile = file + dir[0]*dist;
-            int newRank = rank + dir[1]*dist;
-            if (!CheckBounds(newFile, newRank)) break;
-
-            int target = mBoard[newRank][newFile];
-            if (target == 0) {
-                if (IsMoveLegal(pieceNum, file, rank, newFile, newRank)) {
-                    AddMove(currentSquare, newFile, newRank, moves);
-                }
-            } else {
-                if ((target > 0) != isWhite && IsMoveLegal(pieceNum, file, rank, newFile, newRank)) {
-                    AddMove(currentSquare, newFile, newRank, moves);
-                }
-                break;
-            }
+            int file = square % 8 + steps[i][0] * dist;
+            int rank = square / 8 + steps[i][1] * dist;
+            if (file < 0 || file >= 8 || rank < 0 || rank >= 8) break;
+            attacks |= SquareBit(rank * 8 + file);
+            if (occupied & SquareBit(rank * 8 + file)) break;
         }
     }
+    return attacks;
 }
 
-void Board::GenerateKingMoves(int pieceNum, int file, int rank, std::string currentSquare, bool response) {
-    bool isWhite = pieceNum > 0;
-    auto& moves = response ? mResponses : mPossibleMoves;
-    static const int kingMoves[8][2] = {{-1,-1},{-1,0},{-1,1},{0,-1},{0,1},{1,-1},{1,0},{1,1}};
-
-    // Normal king moves
-    for (const auto& move : kingMoves) {
-        int newFile = file + move[0];
-        int newRank = rank + move[1];
-        if (CheckBounds(newFile, newRank)) {
-            int target = mBoard[newRank][newFile];
-            if (target == 0 || (target > 0) != isWhite) {
-                // Temporarily move king to check safety
-                BoardState saved = SaveState();
-                mBoard[rank][file] = 0;
-                mBoard[newRank][newFile] = pieceNum;
-                std::string newKingSquare = std::string(1,'a'+newFile) + std::to_string(8-newRank);
-
-                if (!IsSquareAttacked(newKingSquare, !isWhite)) {
-                    AddMove(currentSquare, newFile, newRank, moves);
-                }
-                RestoreState(saved);
-            }
+uint64_t Board::AttackersTo(int square, uint64_t occupied) const {
+    uint64_t attackers = 0;
+    auto collect = [&](uint64_t squares, auto matches) {
+        for (squares &= occupied; squares; squares &= squares - 1) {
+            int from = std::countr_zero(squares);
+            if (matches(mBoard[from / 8][from % 8])) attackers |= SquareBit(from);
         }
-    }
+    };
+
+    collect(PawnAttacks[1][square], [](int piece) { return piece == 1; });
+    collect(PawnAttacks[0][square], [](int piece) { return piece == -1; });
+    collect(KnightAttacks[square], [](int piece) { return std::abs(piece) == 2; });
+    collect(KingAttacks[square], [](int piece) { return std::abs(piece) == 6; });
+    collect(SliderAttacks(occupied, square, bishopSteps),
+            [](int piece) { return std::abs(piece) == 3 || std::abs(piece) == 5; });
+    collect(SliderAttacks(occupied, square, rookSteps),
+            [](int piece) { return std::abs(piece) == 4 || std::abs(piece) == 5; });
+    return attackers;
+}
 
-    // Castling - only for non-response moves
-    if (!response && !IsPinned(file, rank)) {
-        bool kingsideAllowed = isWhite ? mWhiteCastlingKingsideRights : mBlackCastlingKingsideRights;
-        bool queensideAllowed = isWhite ? mWhiteCastlingQueensideRights : mBlackCastlingQueensideRights;
-        int castlingRank = isWhite ? 7 : 0;
+// Swap algorithm with a threshold: each side recaptures with its least valuable attacker
+// and may stop when carrying on would lose. Removing a capturer from the occupancy uncovers
+// the sliders behind it.
+bool Board::SeeAtLeast(Move move, int threshold) const {
+    int from = move.From();
+    int to = move.To();
+    int moving = std::abs(mBoard[from / 8][from % 8]);
+    int captured = std::abs(mBoard[to / 8][to % 8]);
+
+    // Castling exchanges nothing
+    if (moving == 6 && std::abs(to - from) == 2) return threshold <= 0;
+
+    const AttackMap& attacks = GetAttacks();
+    uint64_t occupied = attacks.occupied[0] | attacks.occupied[1];
+    if (moving == 1 && captured == 0 && from % 8 != to % 8) {
+        // En passant takes the pawn beside us
+        captured = 1;
+        occupied &= ~SquareBit(from / 8 * 8 + to % 8);
+    }
 
-        // Kingside castling
-        if (kingsideAllowed) {
-            bool pathClear = true;
-            // Check squares between king and rook (f1,g1 for white)
-            for (int f = file+1; f <= 6; f++) {
-                if (mBoard[castlingRank][f] != 0) {
-                    pathClear = false;
-                    break;
-                }
-            }
+    int swap = seeValues[captured] - threshold;
+    if (move.Promotion()) {
+        swap += seeValues[move.Promotion()] - seeValues[1];
+        moving = move.Promotion();
+    }
+    if (swap < 0) return false;
 
-            if (pathClear) {
-                bool safePath = true;
-                // Check if squares are under attack (e1,f1,g1 for white)
-                for (int f = file; f <= file+2; f++) {
-                    std::string square = std::string(1,'a'+f) + std::to_string(8-castlingRank);
-                    if (IsSquareAttacked(square, !isWhite)) {
-                        safePath = false;
-                        break;
-                    }
-                }
+    // Even losing the moved piece for nothing keeps the threshold
+    swap = seeValues[moving] - swap;
+    if (swap <= 0) return true;
 
-                if (safePath) {
-                    moves.push_back(isWhite ? "e1g1" : "e8g8");
-                }
+    occupied &= ~SquareBit(from);
+    uint64_t attackers = AttackersTo(to, occupied);
+    int side = mWhiteTurn ? 0 : 1;
+    int result = 1;
+    while (true) {
+        side ^= 1;
+        attackers &= occupied;
+        uint64_t ours = attackers & attacks.occupied[side];
+
+        // Pinned pieces can't join in while their pinner is still there
+        if (attacks.pinners[side] & occupied) ours &= ~attacks.pinned[side];
+        if (!ours) break;
+        result ^= 1;
+
+        int attacker = 7;
+        int square = -1;
+        for (uint64_t pieces = ours; pieces; pieces &= pieces - 1) {
+            int candidate = std::countr_zero(pieces);
+            int type = std::abs(mBoard[candidate / 8][candidate % 8]);
+            if (type < attacker) {
+                attacker = type;
+                square = candidate;
             }
         }
 
-        // Queenside castling
-        if (queensideAllowed) {
-            bool pathClear = true;
-            // Check squares between king and rook (b1,c1,d1 for white)
-            for (int f = file-1; f >= 1; f--) {
-                if (mBoard[castlingRank][f] != 0) {
-                    pathClear = false;
-                    break;
-                }
-            }
+        // The king can only take if nothing takes it back
+        if (attacker == 6) {
+            return (attackers & attacks.occupied[side ^ 1]) ? !result : result;
+        }
 
-            if (pathClear && mBoard[castlingRank][0] == (isWhite ? 4 : -4)) { // Rook still there
-                bool safePath = true;
-                // Check if squares are under attack (e1,d1,c1 for white)
-                for (int f = file; f >= file-2; f--) {
-                    std::string square = std::string(1,'a'+f) + std::to_string(8-castlingRank);
-                    if (IsSquareAttacked(square, !isWhite)) {
-                        safePath = false;
-                        break;
-                    }
-                }
+        swap = seeValues[attacker] - swap;
+        if (swap < result) break;
 
-                if (safePath) {
-                    moves.push_back(isWhite ? "e1c1" : "e8c8");
-                }
-            }
-        }
+        occupied &= ~SquareBit(square);
+        attackers = AttackersTo(to, occupied);
     }
+    return result;
 }
 
-// Helper function implementations
-bool Board::IsMoveLegal(int pieceNum, int fromFile, int fromRank, int toFile, int toRank) {
-    BoardState saved = SaveState();
-    int captured = mBoard[toRank][toFile];
-    mBoard[fromRank][fromFile] = 0;
-    mBoard[toRank][toFile] = pieceNum;
-
-    std::string kingSquare = (pieceNum > 0) ? mWhiteKingSquare : mBlackKingSquare;
-    if (abs(pieceNum) == 6) { // Moving king
-        kingSquare = std::string(1,'a'+toFile) + std::to_string(8-toRank);
+bool Board::IsPathClear(int from, int to) const {
+    int fileStep = (to % 8 > from % 8) - (to % 8 < from % 8);
+    int rankStep = (to / 8 > from / 8) - (to / 8 < from / 8);
+    int step = rankStep * 8 + fileStep;
+    for (int square = from + step; square != to; square += step) {
+        if (mBoard[square / 8][square % 8] != 0) return false;
     }
-
-    bool legal = !IsSquareAttacked(kingSquare, pieceNum < 0);
-    RestoreState(saved);
-    return legal;
+    return true;
 }
 
-bool Board::IsPinnedDirectionValid(int file, int rank, bool isWhite, int dx, int dy) {
-    std::string kingSquare = isWhite ? mWhiteKingSquare : mBlackKingSquare;
-    int kingFile = kingSquare[0]-'a';
-    int kingRank = 8-(kingSquare[1]-'0');
-
-    // Check if movement direction aligns with king
-    int fileDiff = file - kingFile;
-    int rankDiff = rank - kingRank;
-
-    // Same file/rank/diagonal check
-    if (fileDiff == 0) return dx == 0; // Vertical movement only
-    if (rankDiff == 0) return dy == 0; // Horizontal movement only
-    if (abs(fileDiff) == abs(rankDiff)) return dx == (fileDiff > 0 ? 1 : -1) &&
-                                             dy == (rankDiff > 0 ? 1 : -1);
+bool Board::IsPseudoLegal(Move move) {
+    if (move.IsNull()) return false;
+
+    int from = move.From(), to = move.To();
+    int piece = mBoard[from / 8][from % 8];
+    int target = mBoard[to / 8][to % 8];
+    if (piece == 0 || (piece > 0) != mWhiteTurn) return false;
+    if (target != 0 && (target > 0) == (piece > 0)) return false;
+
+    int fileDiff = to % 8 - from % 8;
+    int rankDiff = to / 8 - from / 8;
+    int pieceType = std::abs(piece);
+
+    // Promotions must be spelled out exactly the way the generator does
+    bool promotes = pieceType == 1 && (to / 8 == 0 || to / 8 == 7);
+    if (promotes != (move.Promotion() != 0)) return false;
+
+    switch (pieceType) {
+        case 1: {
+            int direction = piece > 0 ? -1 : 1;
+            int startRank = piece > 0 ? 6 : 1;
+            if (fileDiff == 0) {
+                if (target != 0) return false;
+                if (rankDiff == direction) return true;
+                return rankDiff == 2 * direction && from / 8 == startRank &&
+                       mBoard[from / 8 + direction][from % 8] == 0;
+            }
+            return std::abs(fileDiff) == 1 && rankDiff == direction &&
+                   (target != 0 || to == mEnPassantSquare);
+        }
+        case 2:
+            return (KnightAttacks[from] & SquareBit(to)) != 0;
+        case 3:
+            return std::abs(fileDiff) == std::abs(rankDiff) && fileDiff != 0 && IsPathClear(from, to);
+        case 4:
+            return (fileDiff == 0) != (rankDiff == 0) && IsPathClear(from, to);
+        case 5:
+            return (std::abs(fileDiff) == std::abs(rankDiff) || fileDiff == 0 || rankDiff == 0) &&
+                   (fileDiff != 0 || rankDiff != 0) && IsPathClear(from, to);
+        case 6:
+            if (KingAttacks[from] & SquareBit(to)) return true;
+            return rankDiff == 0 && std::abs(fileDiff) == 2 && from % 8 == 4 &&
+                   CanCastle(fileDiff > 0, piece > 0);
+    }
     return false;
 }
 
-void Board::AddMove(const std::string& from, int toFile, int toRank, std::vector<std::string>& moves) {
-    moves.push_back(from + std::string(1,'a'+toFile) + std::to_string(8-toRank));
-}
-
 void Board::displayWinner() {
     GeneratePossibleMoves(false);
 
     if (mPossibleMoves.empty()) {
         if (mWhiteTurn) {
-            if (mWhiteInCheck) {
+            if (IsWhiteInCheck()) {
                 std::cout << "Checkmate! Black wins!" << std::endl;
             } else {
                 std::cout << "Stalemate! It's a draw!" << std::endl;
             }
         } else {
-            if (mBlackInCheck) {
+            if (IsBlackInCheck()) {
                 std::cout << "Checkmate! White wins!" << std::endl;
             } else {
                 std::cout << "Stalemate! It's a draw!" << std::endl;
@@ -902,7 +1214,7 @@ void Board::PlayHuman()
     while (true) {
         PrintInternalBoard();
 
-        std::cout << "Current position: " << mChessPosition << std::endl;
+        std::cout << "Current position: " << GenerateFen() << std::endl;
         std::cout << (mWhiteTurn ? "White" : "Black") << " to move." << std::endl;
 
         GeneratePossibleMoves(false);
@@ -952,7 +1264,7 @@ void Board::PlayEngine() {
         if (!mWhiteTurn) {
             // Player's turn
             PrintInternalBoard();
-            std::cout << "Current position: " << mChessPosition << std::endl;
+            std::cout << "Current position: " << GenerateFen() << std::endl;
             std::cout << "Possible moves: ";
             for (const auto& move : mPossibleMoves) {
                 std::cout << move << " ";
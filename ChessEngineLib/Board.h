@@ -1,36 +1,63 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <memory>
-#include <unordered_map>
+
+#include "AttackMap.h"
+#include "Move.h"
+#include "Nnue.h"
+#include "PackedPosition.h"
 
 class Engine;
 
+/// Pieces indexed [rank][file], rank 0 being the 8th rank
+using BoardArray = std::array<std::array<int, 8>, 8>;
+
 class Board {
 public:
     Board(std::string& name, std::string& position);
 
     // Core game functions
     void MakeMove(const std::string& move);
+    void MakeMove(Move move);
     bool IsPinned(int file, int rank);
     bool CanCastle(bool kingside, bool white);
     // bool IsDraw();
     void UndoMove();
     bool IsLegalMove(const std::string& move);
     int CountMoves(int depth);
+    Move ParseMove(const std::string& move) const;
 
     // Move generation
+    void GenerateMoves(MoveList& moves);
+    void GeneratePseudoLegalMoves(MoveList& moves, GenType type = GenType::All);
+    bool IsLegal(Move move);
+    bool IsPseudoLegal(Move move);
+    bool IsTactical(Move move) const;
+    /// Static exchange evaluation: true if the move gains at least `threshold` once the
+    /// captures on its target square, x-rays included, have played out
+    bool SeeAtLeast(Move move, int threshold = 0) const;
+    /// Pieces of either side attacking a square, with only `occupied` on the board
+    uint64_t AttackersTo(int square, uint64_t occupied) const;
     void GeneratePossibleMoves(bool response);
-    std::vector<std::string> GetPossibleMoves() const { return mPossibleMoves; }
+    const std::vector<std::string>& GetPossibleMoves() const { return mPossibleMoves; }
 
     // Board state
-    std::vector<std::vector<int>> FenParser(std::string& fenString);
+    const BoardArray& FenParser(std::string& fenString);
     std::string GenerateFen();
+    /// The position in 32 bytes, and back; unpacking starts a new game as FenParser does
+    PackedPosition Pack() const;
+    void Unpack(const PackedPosition& packed);
     void UpdateCheckStatus();
     bool IsSquareAttacked(const std::string& square, bool byWhite);
-    std::vector<std::vector<int>> &GetBoard() { return mBoard; }
+    bool IsSquareAttacked(int square, bool byWhite) const;
+    const AttackMap& GetAttacks() const;
+    BoardArray &GetBoard() { return mBoard; }
+    const BoardArray& GetBoard() const { return mBoard; }
 
     // Utility functions
     void PrintInternalBoard();
@@ -41,49 +68,56 @@ public:
 
     // Getters
     bool IsWhiteTurn() const { return mWhiteTurn; }
-    bool IsWhiteInCheck() const { return mWhiteInCheck; }
-    bool IsBlackInCheck() const { return mBlackInCheck; }
+    bool IsWhiteInCheck() const;
+    bool IsBlackInCheck() const;
+    uint64_t GetKey() const { return mKey; }
+    uint64_t GetPawnKey() const { return mPawnKey; }
+    int GetKingSquare(bool white) const { return white ? mWhiteKingSquare : mBlackKingSquare; }
+    int GetPly() const { return static_cast<int>(mHistory.size()); }
+    Move GetLastMove() const { return mHistory.empty() ? Move() : mHistory.back().move; }
+    int GetHalfMoveClock() const { return mHalfMoveClock; }
+    int GetFullMoveNumber() const { return mFullMoveNumber; }
+    int GetEnPassantSquare() const { return mEnPassantSquare; }
+    /// Castling rights as bits: 1 white kingside, 2 white queenside, 4 black kingside, 8 black queenside
+    int CastlingMask() const;
+
+    // Draws by rule; a position repeated twice before is a threefold repetition
+    bool IsRepetition(int times = 1) const;
+    bool IsFiftyMoveDraw() const { return mHalfMoveClock >= 100; }
+
+    // NNUE accumulators (maintained by MakeMove/UndoMove while a network is attached)
+    void SetNetwork(const NnueNetwork* network);
+    const NnueNetwork* GetNetwork() const { return mNetwork; }
+    const NnueAccumulator& GetAccumulator() const { return mAccumulators.back(); }
 
 private:
-    struct BoardState {
-        std::vector<std::vector<int>> board;
-        std::string whiteKingSquare;
-        std::string blackKingSquare;
-        bool whiteTurn;
-        bool whiteCastlingKingside;
-        bool whiteCastlingQueenside;
-        bool blackCastlingKingside;
-        bool blackCastlingQueenside;
-        bool whiteInCheck;
-        bool blackInCheck;
-        std::string enPassant;
-    };
-
     struct MoveHistory {
-        std::string move;
+        Move move;
+        int movedPiece;
         int capturedPiece;
         bool whiteCastlingKingside;
         bool whiteCastlingQueenside;
         bool blackCastlingKingside;
         bool blackCastlingQueenside;
-        std::string enPassantSquare;
-        std::string whiteKingSquare;
-        std::string blackKingSquare;
+        int enPassantSquare;
+        int whiteKingSquare;
+        int blackKingSquare;
         int halfMoveClock;
         int fullMoveNumber;
+        uint64_t key;
+        uint64_t pawnKey;
     };
 
     // Board state
-    std::vector<std::vector<int>> mBoard = std::vector<std::vector<int>>(8, std::vector<int>(8, 0));
-    std::string mChessPosition;
-    std::string mWhiteKingSquare;
-    std::string mBlackKingSquare;
+    BoardArray mBoard{};
+    int mWhiteKingSquare = -1;
+    int mBlackKingSquare = -1;
     bool mWhiteTurn;
-    bool mWhiteInCheck;
-    bool mBlackInCheck;
     int mHalfMoveClock = 0;
-    int mFullMoveNumber = 0;
-    std::unordered_map<std::string, int> mPositionHistory;
+    int mFullMoveNumber = 1;
+    uint64_t mKey = 0;      // Zobrist key of the whole position
+    uint64_t mPawnKey = 0;  // Zobrist key of the pawns only
+    std::vector<uint64_t> mKeyHistory;
 
     // Castling rights
     bool mWhiteCastlingKingsideRights;
@@ -92,29 +126,45 @@ private:
     bool mBlackCastlingQueensideRights;
 
     // Move data
-    std::string mEnPassantSquare;
+    int mEnPassantSquare = -1; // -1 if no en passant available
     std::vector<std::string> mPossibleMoves;
-    std::vector<std::string> mResponses;
     std::vector<MoveHistory> mHistory;
 
+    // Attack maps, one per ply and computed on first use
+    mutable std::vector<AttackMap> mAttacks;
+
     // Engine
     std::shared_ptr<Engine> mEngine;
 
+    // NNUE state
+    struct DirtyPiece {
+        int piece;
+        int fromSquare; // -1 when the piece is added
+        int toSquare;   // -1 when the piece is removed
+    };
+    const NnueNetwork* mNetwork = nullptr;
+    std::vector<NnueAccumulator> mAccumulators;
+
     // Private methods
-    BoardState SaveState();
-    void RestoreState(const BoardState& state);
-    bool CheckBounds(int file, int rank);
     std::string PieceToString(int pieceNum);
-
-    // Move generation helpers
-    void GeneratePawnMoves(int pieceNum, int file, int rank, std::string currentSquare, bool response);
-    void GenerateKnightMoves(int pieceNum, int file, int rank, std::string currentSquare, bool response);
-    void GenerateSlidingMoves(int pieceNum, int file, int rank, std::string currentSquare, bool response);
-    void GenerateDiagonalMoves(int pieceNum, int file, int rank, std::string currentSquare, bool response);
-    void GenerateKingMoves(int pieceNum, int file, int rank, std::string currentSquare, bool response);
-    bool IsMoveLegal(int pieceNum, int fromFile, int fromRank, int toFile, int toRank);
-    void AddMove(const std::string& from, int toFile, int toRank, std::vector<std::string>& moves);
-    bool IsPinnedDirectionValid(int file, int rank, bool isWhite, int dx, int dy);
+    uint64_t ComputeKey() const;
+    uint64_t ComputePawnKey() const;
+    /// Forget the moves played, for a position just set up
+    void ResetHistory();
+    void ComputeAttacks(AttackMap& attacks) const;
+    template <bool White> void ComputeSideAttacks(AttackMap& attacks) const;
+    template <bool ByWhite> bool ScanForAttack(int square) const;
+
+    // Move generation, specialised per side to move and generation type
+    // (pseudo-legal; GenerateMoves filters with IsLegal)
+    template <bool White, GenType Type> void GeneratePseudoLegal(MoveList& moves);
+    template <bool White, GenType Type> void GeneratePawnMoves(int square, uint64_t allowed, uint64_t enemy,
+                                                               uint64_t empty, MoveList& moves);
+    bool IsPathClear(int from, int to) const;
+
+    // NNUE helpers
+    void RefreshAccumulator(int perspective);
+    void UpdateAccumulator(const DirtyPiece* dirty, int count, int movedPiece);
 };
 
-#endif // BOARD_H
\ No newline at end of file
+#endif // BOARD_H
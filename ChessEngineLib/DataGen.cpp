@@ -0,0 +1,186 @@
+/**
+ * @file DataGen.cpp
+ * @author John Korreck
+ */
+
+#include "DataGen.h"
+#include "Board.h"
+#include "Engine.h"
+#include "Match.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+
+static const char shardMagic[8] = {'C', 'E', 'D', 'A', 'T', 'A', '1', '\0'};
+const uint32_t shardVersion = 2;
+
+ShardWriter::ShardWriter(std::string prefix, uint64_t shardRecords)
+    : mPrefix(std::move(prefix)), mShardRecords(std::max<uint64_t>(shardRecords, 1)) {
+    mBuffer.reserve(BufferRecords);
+}
+
+ShardWriter::~ShardWriter() {
+    Flush();
+    if (mFile) std::fclose(mFile);
+}
+
+bool ShardWriter::OpenShard() {
+    if (mFile && std::fclose(mFile) != 0) mFailed = true;
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "-%04d.bin", mShard++);
+    mFile = std::fopen((mPrefix + suffix).c_str(), "wb");
+    mInShard = 0;
+    if (!mFile) return !(mFailed = true);
+
+    ShardHeader header{};
+    std::memcpy(header.magic, shardMagic, sizeof(header.magic));
+    header.version = shardVersion;
+    header.recordBytes = sizeof(TrainingRecord);
+    if (std::fwrite(&header, sizeof(header), 1, mFile) != 1) mFailed = true;
+    return !mFailed;
+}
+
+bool ShardWriter::Write(const TrainingRecord& record) {
+    if (mFailed) return false;
+    if (!mFile || mInShard == mShardRecords) {
+        if (!Flush() || !OpenShard()) return false;
+    }
+    mBuffer.push_back(record);
+    mInShard++;
+    mRecords++;
+    if (mBuffer.size() == BufferRecords) return Flush();
+    return true;
+}
+
+bool ShardWriter::Flush() {
+    if (mFailed) return false;
+    if (mBuffer.empty()) return true;
+    if (std::fwrite(mBuffer.data(), sizeof(TrainingRecord), mBuffer.size(), mFile) != mBuffer.size() ||
+        std::fflush(mFile) != 0) {
+        mFailed = true;
+    }
+    mBuffer.clear();
+    return !mFailed;
+}
+
+DataGenerator::DataGenerator(DataGenSettings settings) : mSettings(std::move(settings)) {
+}
+
+bool DataGenerator::Run(const Progress& progress) {
+    std::mutex progressMutex;
+    Progress serialised;
+    if (progress) {
+        serialised = [&](uint64_t positions, uint64_t games) {
+            std::lock_guard<std::mutex> lock(progressMutex);
+            progress(positions, games);
+        };
+    }
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < mSettings.threads; i++) {
+        workers.emplace_back(&DataGenerator::Worker, this, i, std::cref(serialised));
+    }
+    Worker(0, serialised);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    // The last games claimed more room than was left
+    mPositions = std::min<uint64_t>(mPositions, mSettings.positions);
+    return !mFailed;
+}
+
+void DataGenerator::Worker(int index, const Progress& progress) {
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "-%02d", index);
+    ShardWriter writer(mSettings.output + suffix, mSettings.shardRecords);
+
+    std::seed_seq seed{mSettings.seed, static_cast<uint64_t>(index)};
+    std::mt19937_64 random(seed);
+
+    // One board and one engine for every game; a Board brings its own engine and tables,
+    // which would cost more to set up than a short game takes to play
+    std::string name = "DataGen";
+    std::string startFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    Board board(name, startFen);
+    Engine engine;
+    SearchLimits limits;
+    limits.nodes = mSettings.nodes;
+
+    std::vector<TrainingRecord> game;
+    MoveList moves;
+
+    while (mPositions < mSettings.positions && !mFailed) {
+        // A random opening, replayed if it ends the game or leaves one side well ahead
+        board.FenParser(startFen);
+        int plies = mSettings.randomPlies + static_cast<int>(random() & 1);
+        bool playable = true;
+        for (int ply = 0; ply < plies && playable; ply++) {
+            board.GenerateMoves(moves);
+            playable = !moves.Empty();
+            if (playable) board.MakeMove(moves[static_cast<int>(random() % moves.Size())]);
+        }
+        board.GenerateMoves(moves);
+        if (!playable || moves.Empty()) continue;
+
+        engine.NewGame();
+        SearchResult opening = engine.Search(board, limits);
+        if (std::abs(opening.score) > mSettings.openingScore) continue;
+
+        // Play it out, keeping the quiet positions with their scores seen from white
+        game.clear();
+        int result = 0;
+        int resignSide = 0;
+        int resignPlies = 0;
+        for (int ply = 0;; ply++) {
+            board.GenerateMoves(moves);
+            int white = board.IsWhiteTurn() ? 1 : -1;
+            if (moves.Empty()) {
+                result = board.GetAttacks().checkers ? -white : 0;
+                break;
+            }
+            if (board.IsRepetition(2) || board.IsFiftyMoveDraw() || InsufficientMaterial(board) ||
+                ply >= mSettings.maxMoves * 2) {
+                break;
+            }
+
+            SearchResult searched = engine.Search(board, limits);
+            if (searched.bestMove.IsNull()) break;
+            int score = searched.score * white;
+
+            bool quiet = !board.GetAttacks().checkers && !board.IsTactical(searched.bestMove) &&
+                         std::abs(score) < mSettings.maxScore;
+            if (quiet && ply >= mSettings.minPly) {
+                TrainingRecord record;
+                record.position = board.Pack();
+                record.score = std::clamp(score, -32767, 32767);
+                record.move = searched.bestMove.Raw();
+                game.push_back(record);
+            }
+
+            int ahead = score >= mSettings.resignScore ? 1 : score <= -mSettings.resignScore ? -1 : 0;
+            resignPlies = ahead != 0 && ahead == resignSide ? resignPlies + 1 : ahead != 0 ? 1 : 0;
+            resignSide = ahead;
+            if (mSettings.resignMoves > 0 && resignPlies >= mSettings.resignMoves * 2) {
+                result = ahead;
+                break;
+            }
+            board.MakeMove(searched.bestMove);
+        }
+
+        // Claim room under the target so the total comes out exact
+        uint64_t before = mPositions.fetch_add(game.size());
+        uint64_t room = before < mSettings.positions ? mSettings.positions - before : 0;
+        size_t keep = std::min<uint64_t>(game.size(), room);
+        for (size_t i = 0; i < keep; i++) {
+            game[i].result = result;
+            if (!writer.Write(game[i])) mFailed = true;
+        }
+        uint64_t games = ++mGames;
+        if (progress) progress(std::min(before + game.size(), mSettings.positions), games);
+    }
+    if (!writer.Flush()) mFailed = true;
+}
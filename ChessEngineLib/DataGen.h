@@ -0,0 +1,109 @@
+/**
+ * @file DataGen.h
+ * @author John Korreck
+ *
+ * Training data from self-play. Each worker plays short fixed-node games from
+ * randomised openings, keeps the quiet positions with their search scores, and
+ * when a game ends appends them with its result to shard files of its own, so
+ * workers never wait on each other.
+ *
+ * A shard is a ShardHeader followed by 40-byte TrainingRecords.
+ */
+
+#ifndef DATAGEN_H
+#define DATAGEN_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "PackedPosition.h"
+
+/// One position with its score, the move the search chose and the game's result
+struct TrainingRecord {
+    PackedPosition position;
+    int16_t score = 0;       // search score in centipawns, from white's point of view
+    uint16_t move = 0;       // Move::Raw()
+    int8_t result = 0;       // 1 white won, 0 drawn, -1 black won
+    uint8_t reserved[3] = {};
+};
+static_assert(sizeof(TrainingRecord) == 40);
+
+struct ShardHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordBytes;
+};
+static_assert(sizeof(ShardHeader) == 16);
+
+/// Appends records to <prefix>-0000.bin, <prefix>-0001.bin, ..., starting a new shard
+/// every shardRecords records. Not thread-safe; give each thread its own.
+class ShardWriter {
+public:
+    static constexpr size_t BufferRecords = 4096;
+
+    ShardWriter(std::string prefix, uint64_t shardRecords);
+    ~ShardWriter();
+    ShardWriter(const ShardWriter&) = delete;
+    ShardWriter& operator=(const ShardWriter&) = delete;
+
+    bool Write(const TrainingRecord& record);
+    bool Flush();
+    uint64_t Records() const { return mRecords; }
+    int Shards() const { return mShard; }
+
+private:
+    std::string mPrefix;
+    uint64_t mShardRecords;
+    int mShard = 0;            // shards opened so far
+    uint64_t mInShard = 0;
+    uint64_t mRecords = 0;
+    std::FILE* mFile = nullptr;
+    std::vector<TrainingRecord> mBuffer;
+    bool mFailed = false;
+
+    bool OpenShard();
+};
+
+struct DataGenSettings {
+    uint64_t positions = 1000000;  // stop once this many are written
+    int threads = 1;
+    uint64_t nodes = 5000;         // per move
+    int randomPlies = 8;           // random moves from the start position, plus 0 or 1 more
+    int openingScore = 400;        // openings searched as further out than this are replayed
+    int maxMoves = 200;
+    int resignScore = 2000;        // adjudicate a win once both sides see this for resignMoves moves
+    int resignMoves = 3;
+    int maxScore = 3000;           // positions scored beyond this, or mates, are skipped
+    int minPly = 0;                // positions before this ply of the game are skipped
+    uint64_t shardRecords = 1 << 20;
+    std::string output = "data";   // shards are <output>-<thread>-<shard>.bin
+    uint64_t seed = 1;
+};
+
+class DataGenerator {
+public:
+    /// Totals so far; called from the worker threads after each game, one at a time
+    using Progress = std::function<void(uint64_t positions, uint64_t games)>;
+
+    explicit DataGenerator(DataGenSettings settings);
+
+    /// Play until settings.positions are written; false if a shard couldn't be written
+    bool Run(const Progress& progress = {});
+
+    uint64_t Positions() const { return mPositions; }
+    uint64_t Games() const { return mGames; }
+
+private:
+    DataGenSettings mSettings;
+    std::atomic<uint64_t> mPositions{0};
+    std::atomic<uint64_t> mGames{0};
+    std::atomic<bool> mFailed{false};
+
+    void Worker(int index, const Progress& progress);
+};
+
+#endif //DATAGEN_H
@@ -5,265 +5,555 @@
  
 #include "Engine.h"
 #include "Board.h"
+#include "EvalWeights.h"
+#include "MovePicker.h"
+#include "Nnue.h"
+#include "Snapshot.h"
 
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
 #include <limits>
 
-// Piece definitions (same as your current code)
+// Piece definitions (same encoding as Board: positive = white, negative = black)
 const int EMPTY = 0;
-const int KING = 1;
-const int PAWN = 2;
-const int KNIGHT = 3;
-const int BISHOP = 4;
-const int ROOK = 5;
-const int QUEEN = 6;
-
-const int WHITE = 8;
-const int BLACK = 16;
-
-const int WHITE_KING = WHITE + KING;
-const int WHITE_PAWN = WHITE + PAWN;
-const int WHITE_KNIGHT = WHITE + KNIGHT;
-const int WHITE_BISHOP = WHITE + BISHOP;
-const int WHITE_ROOK = WHITE + ROOK;
-const int WHITE_QUEEN = WHITE + QUEEN;
-
-const int BLACK_KING = BLACK + KING;
-const int BLACK_PAWN = BLACK + PAWN;
-const int BLACK_KNIGHT = BLACK + KNIGHT;
-const int BLACK_BISHOP = BLACK + BISHOP;
-const int BLACK_ROOK = BLACK + ROOK;
-const int BLACK_QUEEN = BLACK + QUEEN;
+const int PAWN = 1;
+const int KNIGHT = 2;
+const int BISHOP = 3;
+const int ROOK = 4;
+const int QUEEN = 5;
+const int KING = 6;
+
+// Game phase weights (24 = all minor and major pieces on the board)
+const int phaseWeights[7] = {0, 0, 1, 1, 2, 4, 0};
+const int maxPhase = 24;
+
+// d4, e4, d5 and e5, where control earns EvalWeights::centreWeights on top
+const uint64_t centreSquares = 0x0000001818000000ULL;
+
+// Piece-square bonuses by piece type, for the pieces that have them
+const int* const squareTables[7] = {nullptr, EvalWeights::pawnSquares, EvalWeights::knightSquares,
+                                    EvalWeights::bishopSquares, nullptr, nullptr, nullptr};
+
+// Quiet moves losing this much per ply of depth by static exchange are pruned near the leaves
+const int quietSeeDepth = 3;
+const int quietSeeMargin = 60;
+
+// Scores beyond this are mates; the table stores them relative to the node, not the root
+const int mateBound = Engine::MateScore - Engine::MaxPly;
+
+static int ScoreToTT(int score, int ply) {
+    if (score >= mateBound) return score + ply;
+    if (score <= -mateBound) return score - ply;
+    return score;
+}
+
+static int ScoreFromTT(int score, int ply) {
+    if (score >= mateBound) return score - ply;
+    if (score <= -mateBound) return score + ply;
+    return score;
+}
+
+bool Engine::SetOption(const std::string& name, const std::string& value) {
+    if (name == "EvalFile") {
+        auto network = std::make_shared<NnueNetwork>();
+        if (!network->Load(value)) {
+            return false;
+        }
+        mNetwork = network;
+        return true;
+    }
+    if (name == "UseNNUE") {
+        mUseNnue = (value == "true" || value == "1");
+        return !mUseNnue || mNetwork != nullptr;
+    }
+    if (name == "Hash") {
+        char* end = nullptr;
+        unsigned long megabytes = std::strtoul(value.c_str(), &end, 10);
+        if (end == value.c_str() || megabytes == 0) {
+            return false;
+        }
+        mTT->Resize(megabytes);
+        return true;
+    }
+    if (name == "SharedHash") {
+        // Name of a shared-memory segment such as "/chess-tt"; empty goes back to private memory
+        if (value.empty()) {
+            mTT->Resize(mTT->Megabytes());
+            return true;
+        }
+        return mTT->AttachShared(value, mHugePages);
+    }
+    if (name == "HugePages") {
+        mHugePages = (value == "true" || value == "1");
+        return true;
+    }
+    if (name == "TraceFile") {
+        // Record every node of the following searches there; empty stops tracing
+        if (value.empty()) {
+            mTrace.reset();
+            return true;
+        }
+        auto trace = std::make_shared<SearchTrace>();
+        if (!trace->Open(value)) {
+            return false;
+        }
+        mTrace = trace;
+        return true;
+    }
+    return false;
+}
+
+bool Engine::SaveSnapshot(const std::string& path) const {
+    return ::SaveSnapshot(path, *mTT, *mResults);
+}
+
+bool Engine::LoadSnapshot(const std::string& path) {
+    return ::LoadSnapshot(path, *mTT, *mResults);
+}
+
+void Engine::ShareTables(std::shared_ptr<TranspositionTable> table, std::shared_ptr<ResultCache> results) {
+    mTT = std::move(table);
+    mResults = std::move(results);
+}
+
+bool Engine::IsNnueActive() const {
+    return mUseNnue && mNetwork;
+}
 
 int Engine::EvaluateBoard(Board& board) {
-    std::vector<std::vector<int>> boardArray = board.GetBoard();
+    if (board.GetNetwork()) {
+        // The network scores the side to move; Minimax wants white's point of view
+        int eval = board.GetNetwork()->Evaluate(board.GetAccumulator(), board.IsWhiteTurn());
+        return board.IsWhiteTurn() ? eval : -eval;
+    }
+
+    const auto& boardArray = board.GetBoard();
     int materialEval = 0;
     int controlEval = 0;
+    int phase = 0;
 
-    // Piece square tables for positional evaluation
-    const int pawnTable[8][8] = {
-        { 0,  0,  0,  0,  0,  0,  0,  0},
-        {50, 50, 50, 50, 50, 50, 50, 50},
-        {10, 10, 20, 30, 30, 20, 10, 10},
-        { 5,  5, 10, 25, 25, 10,  5,  5},
-        { 0,  0,  0, 20, 20,  0,  0,  0},
-        { 5, -5,-10,  0,  0,-10, -5,  5},
-        { 5, 10, 10,-20,-20, 10, 10,  5},
-        { 0,  0,  0,  0,  0,  0,  0,  0}
-    };
-
-    const int knightTable[8][8] = {
-        {-50,-40,-30,-30,-30,-30,-40,-50},
-        {-40,-20,  0,  0,  0,  0,-20,-40},
-        {-30,  0, 10, 15, 15, 10,  0,-30},
-        {-30,  5, 15, 20, 20, 15,  5,-30},
-        {-30,  0, 15, 20, 20, 15,  0,-30},
-        {-30,  5, 10, 15, 15, 10,  5,-30},
-        {-40,-20,  0,  5,  5,  0,-20,-40},
-        {-50,-40,-30,-30,-30,-30,-40,-50}
-    };
-
-    const int bishopTable[8][8] = {
-        {-20,-10,-10,-10,-10,-10,-10,-20},
-        {-10,  0,  0,  0,  0,  0,  0,-10},
-        {-10,  0,  5, 10, 10,  5,  0,-10},
-        {-10,  5,  5, 10, 10,  5,  5,-10},
-        {-10,  0, 10, 10, 10, 10,  0,-10},
-        {-10, 10, 10, 10, 10, 10, 10,-10},
-        {-10,  5,  0,  0,  0,  0,  5,-10},
-        {-20,-10,-10,-10,-10,-10,-10,-20}
-    };
-
-    // Central control bonus (squares e4,e5,d4,d5)
-    const int centralControlBonus = 10;
-
-    for (int rank = 0; rank < boardArray.size(); rank++) {
-        for (int file = 0; file < boardArray[0].size(); file++) {
+    for (int rank = 0; rank < 8; rank++) {
+        for (int file = 0; file < 8; file++) {
             int piece = boardArray[rank][file];
             if (piece == EMPTY) continue;
 
-            bool isWhite = (piece & WHITE);
+            bool isWhite = piece > 0;
             int sign = isWhite ? 1 : -1;
-            int pieceType = piece & 7; // Get piece type without color
-
-            // Material evaluation
-            switch (pieceType) {
-                case PAWN:
-                    materialEval += sign * 100;
-                    materialEval += sign * pawnTable[isWhite ? rank : 7-rank][file];
-                    break;
-                case KNIGHT:
-                    materialEval += sign * 300;
-                    materialEval += sign * knightTable[isWhite ? rank : 7-rank][file];
-                    break;
-                case BISHOP:
-                    materialEval += sign * 300;
-                    materialEval += sign * bishopTable[isWhite ? rank : 7-rank][file];
-                    break;
-                case ROOK: materialEval += sign * 500; break;
-                case QUEEN: materialEval += sign * 900; break;
-            }
+            int pieceType = std::abs(piece); // Get piece type without color
+            phase += phaseWeights[pieceType];
 
-            // Control evaluation
-            int controlValue = 0;
-            switch (pieceType) {
-                case PAWN: {
-                    // Pawns control diagonally forward
-                    int forward = isWhite ? -1 : 1;
-                    for (int i = -1; i <= 1; i += 2) {
-                        int newFile = file + i;
-                        int newRank = rank + forward;
-                        if (newFile >= 0 && newFile < 8 && newRank >= 0 && newRank < 8) {
-                            controlValue += 5; // Base control value
-                            // Bonus for controlling center
-                            if ((newFile >= 3 && newFile <= 4) && (newRank >= 3 && newRank <= 4)) {
-                                controlValue += centralControlBonus;
-                            }
-                        }
-                    }
-                    break;
-                }
-                case KNIGHT: {
-                    // Knight moves
-                    const int knightMoves[8][2] = {{-2,-1},{-2,1},{-1,-2},{-1,2},{1,-2},{1,2},{2,-1},{2,1}};
-                    for (const auto& move : knightMoves) {
-                        int newFile = file + move[0];
-                        int newRank = rank + move[1];
-                        if (newFile >= 0 && newFile < 8 && newRank >= 0 && newRank < 8) {
-                            controlValue += 10;
-                            if ((newFile >= 3 && newFile <= 4) && (newRank >= 3 && newRank <= 4)) {
-                                controlValue += centralControlBonus * 2;
-                            }
-                        }
-                    }
-                    break;
-                }
-                case BISHOP:
-                case ROOK:
-                case QUEEN: {
-                    // Sliding pieces
-                    const int bishopDirs[4][2] = {{1,1},{1,-1},{-1,1},{-1,-1}};
-                    const int rookDirs[4][2] = {{1,0},{-1,0},{0,1},{0,-1}};
-                    const int* dirs = (pieceType == BISHOP) ? *bishopDirs :
-                                      (pieceType == ROOK) ? *rookDirs : nullptr;
-                    int dirCount = (pieceType == BISHOP) ? 4 :
-                                  (pieceType == ROOK) ? 4 : 8;
-
-                    if (pieceType == QUEEN) {
-                        // Queen combines bishop and rook
-                        for (int i = 0; i < 8; i++) {
-                            const int* dir = (i < 4) ? bishopDirs[i] : rookDirs[i-4];
-                            for (int dist = 1; dist < 8; dist++) {
-                                int newFile = file + dir[0] * dist;
-                                int newRank = rank + dir[1] * dist;
-                                if (newFile < 0 || newFile >= 8 || newRank < 0 || newRank >= 8) break;
-                                controlValue += 5;
-                                if ((newFile >= 3 && newFile <= 4) && (newRank >= 3 && newRank <= 4)) {
-                                    controlValue += centralControlBonus;
-                                }
-                                if (boardArray[newRank][newFile] != EMPTY) break; // Blocked
-                            }
-                        }
-                    } else {
-                        for (int i = 0; i < dirCount; i++) {
-                            const int* dir = (pieceType == BISHOP) ? bishopDirs[i] : rookDirs[i];
-                            for (int dist = 1; dist < 8; dist++) {
-                                int newFile = file + dir[0] * dist;
-                                int newRank = rank + dir[1] * dist;
-                                if (newFile < 0 || newFile >= 8 || newRank < 0 || newRank >= 8) break;
-                                controlValue += 5;
-                                if ((newFile >= 3 && newFile <= 4) && (newRank >= 3 && newRank <= 4)) {
-                                    controlValue += centralControlBonus;
-                                }
-                                if (boardArray[newRank][newFile] != EMPTY) break; // Blocked
-                            }
-                        }
-                    }
-                    break;
-                }
-                case KING: {
-                    // King control (less important)
-                    const int kingMoves[8][2] = {{-1,-1},{-1,0},{-1,1},{0,-1},{0,1},{1,-1},{1,0},{1,1}};
-                    for (const auto& move : kingMoves) {
-                        int newFile = file + move[0];
-                        int newRank = rank + move[1];
-                        if (newFile >= 0 && newFile < 8 && newRank >= 0 && newRank < 8) {
-                            controlValue += 3; // King control is less valuable
-                        }
-                    }
-                    break;
-                }
+            // Material, and placement from white's side of the board
+            materialEval += sign * EvalWeights::pieceValues[pieceType];
+            if (const int* table = squareTables[pieceType]) {
+                materialEval += sign * table[(isWhite ? rank : 7 - rank) * 8 + file];
             }
+        }
+    }
 
-            controlEval += sign * controlValue;
+    // Control from the shared attack map, with a bonus for the centre
+    const AttackMap& attacks = board.GetAttacks();
+    for (int side = 0; side < 2; side++) {
+        int sign = side == 0 ? 1 : -1;
+        for (int pieceType = PAWN; pieceType <= KING; pieceType++) {
+            uint64_t controlled = attacks.byPiece[side][pieceType];
+            controlEval += sign * (EvalWeights::controlWeights[pieceType] * std::popcount(controlled) +
+                                   EvalWeights::centreWeights[pieceType] * std::popcount(controlled & centreSquares));
         }
     }
 
-    // Combine material and control evaluations with weights
-    return materialEval + (controlEval / 5); // Adjust weight as needed
+    // Pawn structure and king shelter, cached by pawn key
+    phase = std::min(phase, maxPhase);
+    PawnEntry& pawns = mPawnTable.Probe(board);
+    int pawnMg = pawns.mg[0] - pawns.mg[1];
+    int pawnEg = pawns.eg[0] - pawns.eg[1];
+    pawnMg += PawnTable::Shelter(pawns, 0, board.GetKingSquare(true)) -
+              PawnTable::Shelter(pawns, 1, board.GetKingSquare(false));
+    int pawnEval = (pawnMg * phase + pawnEg * (maxPhase - phase)) / maxPhase;
+
+    return materialEval + controlEval / EvalWeights::controlScale + pawnEval;
 }
 
-// Modify FindBestMove to use board copies:
+// Search on the caller's board with make/unmake so incremental state (NNUE accumulators) stays valid
 std::string Engine::FindBestMove(Board& board, int depth) {
-    std::string bestMove;
-    int bestEval = std::numeric_limits<int>::min();
+    SearchLimits limits;
+    limits.depth = depth;
+    Move bestMove = Search(board, limits).bestMove;
+    return bestMove.IsNull() ? "" : bestMove.ToString();
+}
 
-    std::vector<std::string> possibleMoves = board.GetPossibleMoves();
+// History changes repetition scores, and the halfmove clock changes fifty-move scores once the
+// search can reach the hundredth ply; neither is in the Zobrist key
+bool Engine::ScoresPositionAlone(const Board& board, int depth) {
+    return board.GetPly() == 0 && board.GetHalfMoveClock() + depth < 100;
+}
 
-    for (const auto& move : possibleMoves) {
-        // Create a copy of the board for simulation
-        Board tempBoard = board;
-        tempBoard.MakeMove(move);  // Use Board's move function
+// Iterative deepening; every completed iteration leaves a move that can be returned if time runs out
+SearchResult Engine::Search(Board& board, const SearchLimits& limits) {
+    SearchResult result;
+    mStopRequested.store(false, std::memory_order_relaxed);
+    mStopped = false;
+    mNodes = 0;
+    mTime.Start(limits.moveTimeMs);
+    mDepthLimit = limits.depth;
+    mNodeLimit = limits.nodes;
+    mAllocated = AllocationCounts();
+    mAllocationMark = ThreadAllocations();
 
-        int eval = Minimax(tempBoard, depth - 1, false,
-                         std::numeric_limits<int>::min(),
-                         std::numeric_limits<int>::max());
+    board.SetNetwork(IsNnueActive() ? mNetwork.get() : nullptr);
+    mRootPly = board.GetPly();
+    std::fill(&mKillers[0][0], &mKillers[0][0] + MaxPly * 2, Move());
 
-        if (eval > bestEval) {
-            bestEval = eval;
-            bestMove = move;
+    MoveList legalMoves;
+    board.GenerateMoves(legalMoves);
+    int multiPv = std::clamp(limits.multiPv, 1, std::max(1, legalMoves.Size()));
+    if (!legalMoves.Empty()) {
+        // Something to play even if the first iteration doesn't finish
+        result.bestMove = legalMoves[0];
+    }
+
+    // A position already searched at least this hard is answered from the cache. The cache is
+    // keyed on the position alone, so a search whose scores could depend on more than that
+    // neither reads nor fills it.
+    bool cacheable = multiPv == 1 && ScoresPositionAlone(board, limits.depth);
+    CachedResult cached;
+    if (cacheable && mResults->Probe(board.GetKey(), limits.depth, limits.moveTimeMs, cached) &&
+        legalMoves.Contains(Move::FromRaw(cached.move))) {
+        result.bestMove = Move::FromRaw(cached.move);
+        result.score = cached.score;
+        result.depth = cached.depth;
+        result.lines.push_back({result.bestMove, result.score, {result.bestMove}});
+        board.SetNetwork(nullptr);
+        if (mIterationHook) mIterationHook(result);
+        result.allocated = ThreadAllocations() - mAllocationMark;
+        return result;
+    }
+
+    for (int depth = 1; depth <= mDepthLimit && !legalMoves.Empty(); depth++) {
+        bool complete = SearchRoot(board, depth, multiPv, result.lines);
+        if (!result.lines.empty()) {
+            result.bestMove = result.lines[0].move;
+            result.score = result.lines[0].score;
+        }
+        if (!complete) break;
+
+        result.depth = depth;
+        mTime.OnIteration(result.bestMove.Raw());
+        if (mIterationHook) {
+            result.nodes = mNodes;
+            result.timeMs = mTime.ElapsedMs();
+            mIterationHook(result);
+        }
+        bool outOfNodes = mNodeLimit && mNodes >= mNodeLimit;
+        if (mTime.SoftLimitReached() || outOfNodes || (multiPv == 1 && std::abs(result.score) >= mateBound)) break;
+    }
+
+    result.stopped = mStopped;
+    result.nodes = mNodes;
+    result.timeMs = mTime.ElapsedMs();
+    board.SetNetwork(nullptr);
+
+    // Searches cut short by Stop() or a node budget didn't get the time the entry would claim
+    bool cancelled = mStopRequested.load(std::memory_order_relaxed);
+    bool outOfNodes = mNodeLimit && mNodes >= mNodeLimit;
+    if (cacheable && result.depth > 0 && !cancelled && !outOfNodes) {
+        CachedResult entry;
+        entry.key = board.GetKey();
+        entry.score = result.score;
+        entry.budgetMs = static_cast<uint32_t>(limits.moveTimeMs);
+        entry.move = result.bestMove.Raw();
+        entry.depth = static_cast<int16_t>(result.depth);
+        mResults->Store(entry);
+    }
+    mAllocated += ThreadAllocations() - mAllocationMark;
+    result.allocated = mAllocated;
+    if (mTrace) mTrace->Flush();
+    return result;
+}
+
+void Engine::NewGame() {
+    mTT->Clear();
+    mResults->Clear();
+}
+
+void Engine::Retarget(const SearchLimits& limits) {
+    mDepthLimit = limits.depth;
+    mNodeLimit = limits.nodes;
+    mTime.SetBudget(limits.moveTimeMs);
+}
+
+// Searches every root move, keeping the best multiPv of them with exact scores. The window
+// is opened only as far as the worst line kept, so moves that can't enter the list fail low
+// cheaply. The lines passed in (the previous iteration's) are searched first; they are
+// replaced when the iteration completes, or with a single line, by whatever a stopped
+// iteration finished, since it searched the previous best move first.
+bool Engine::SearchRoot(Board& board, int depth, int multiPv, std::vector<PvLine>& lines) {
+    bool maximizing = board.IsWhiteTurn();
+
+    // The first iteration starts from the table's move, often the previous search's PV
+    Move firstMove;
+    TTEntry entry;
+    if (!lines.empty()) {
+        firstMove = lines[0].move;
+    } else if (mTT->Probe(board.GetKey(), entry)) {
+        firstMove = Move::FromRaw(entry.move);
+    }
+
+    MoveList rootMoves;
+    MovePicker picker(board, firstMove, mKillers[0]);
+    for (Move move = picker.Next(); !move.IsNull(); move = picker.Next()) {
+        rootMoves.Add(move);
+    }
+    int front = 0;
+    for (const PvLine& line : lines) {
+        Move* found = std::find(rootMoves.begin() + front, rootMoves.end(), line.move);
+        if (found != rootMoves.end()) {
+            std::rotate(rootMoves.begin() + front, found, found + 1);
+            front++;
+        }
+    }
+
+    uint64_t startNodes = mNodes;
+    std::vector<PvLine> found;
+    found.reserve(multiPv + 1);
+    for (Move move : rootMoves) {
+        // Scores here are from the side to move's point of view
+        bool full = static_cast<int>(found.size()) == multiPv;
+        int worst = full ? found.back().score : -std::numeric_limits<int>::max();
+        int alpha = maximizing ? worst : std::numeric_limits<int>::min();
+        int beta = maximizing ? std::numeric_limits<int>::max() : -worst;
+
+        board.MakeMove(move);
+        int eval = Minimax(board, depth - 1, !maximizing, alpha, beta);
+        board.UndoMove();
+        if (mStopped) {
+            if (multiPv == 1 && !found.empty()) lines = std::move(found);
+            return false;
+        }
+
+        int score = maximizing ? eval : -eval;
+        if (full && score <= worst) continue;
+
+        PvLine line{move, score, {move}};
+        line.pv.insert(line.pv.end(), mPv[1], mPv[1] + mPvLength[1]);
+        auto position = std::find_if(found.begin(), found.end(),
+                                     [score](const PvLine& other) { return other.score < score; });
+        found.insert(position, std::move(line));
+        if (static_cast<int>(found.size()) > multiPv) found.pop_back();
+    }
+
+    int bestEval = maximizing ? found[0].score : -found[0].score;
+    mTT->Store(board.GetKey(), found[0].move, ScoreToTT(bestEval, 0), depth, Bound::Exact);
+    if (mTrace) {
+        TraceNode(board, TraceKind::Root, depth, maximizing, std::numeric_limits<int>::min(),
+                  std::numeric_limits<int>::max(), bestEval, startNodes, rootMoves.Size());
+    }
+    lines = std::move(found);
+    return true;
+}
+
+void Engine::CountNode() {
+    if (++mNodes % StopCheckInterval == 0) {
+        if (mYieldHook) {
+            mAllocated += ThreadAllocations() - mAllocationMark;
+            mYieldHook();
+            mAllocationMark = ThreadAllocations();
+        }
+        if (mStopRequested.load(std::memory_order_relaxed) || mTime.HardLimitReached() ||
+            (mNodeLimit && mNodes >= mNodeLimit)) {
+            mStopped = true;
         }
     }
-    return bestMove;
 }
 
 int Engine::Minimax(Board& board, int depth, bool maximizingPlayer, int alpha, int beta) {
+    uint64_t startNodes = mNodes;
+    CountNode();
+    if (mStopped) {
+        return 0;
+    }
+
+    int ply = board.GetPly() - mRootPly;
+    bool trackPv = ply < MaxPly - 1;
+    if (ply < MaxPly) mPvLength[ply] = 0;
+
+    // Steering into a repetition or the fifty-move rule is a draw
+    if (board.IsRepetition() || board.IsFiftyMoveDraw()) {
+        if (mTrace) TraceNode(board, TraceKind::Draw, depth, maximizingPlayer, alpha, beta, 0, startNodes);
+        return 0;
+    }
+
     if (depth == 0) {
-        return EvaluateBoard(board);
+        int eval = Quiesce(board, maximizingPlayer, alpha, beta);
+        if (mTrace && !mStopped) {
+            TraceNode(board, TraceKind::Quiescence, depth, maximizingPlayer, alpha, beta, eval, startNodes);
+        }
+        return eval;
     }
 
-    board.GeneratePossibleMoves(false);
-    std::vector<std::string> possibleMoves = board.GetPossibleMoves();
+    uint64_t key = board.GetKey();
 
-    if (possibleMoves.empty()) {
-        bool inCheck = board.IsWhiteTurn() ? board.IsWhiteInCheck() : board.IsBlackInCheck();
+    TTEntry entry;
+    Move ttMove;
+    if (mTT->Probe(key, entry)) {
+        ttMove = Move::FromRaw(entry.move);
+        int ttScore = ScoreFromTT(entry.score, ply);
+        if (entry.depth >= depth &&
+            (entry.bound == Bound::Exact ||
+             (entry.bound == Bound::Lower && ttScore >= beta) ||
+             (entry.bound == Bound::Upper && ttScore <= alpha))) {
+            if (mTrace) {
+                TraceNode(board, TraceKind::TableHit, depth, maximizingPlayer, alpha, beta, ttScore, startNodes);
+            }
+            return ttScore;
+        }
+    }
 
-            return maximizingPlayer ? std::numeric_limits<int>::min()
-                                    : std::numeric_limits<int>::max();
+    static const Move noKillers[2] = {};
+    MovePicker picker(board, ttMove, ply < MaxPly ? mKillers[ply] : noKillers);
+
+    int alphaOrig = alpha;
+    int betaOrig = beta;
+    int bestEval = maximizingPlayer ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+    Move bestMove;
+    int legalMoves = 0;
+    int searchedMoves = 0;
+    int cutoff = 0;
+    bool inCheck = board.GetAttacks().checkers != 0;
+
+    for (Move move = picker.Next(); !move.IsNull(); move = picker.Next()) {
+        legalMoves++;
+        bool quiet = !board.IsTactical(move);
+
+        // Near the leaves, once a move has been searched, skip quiets that hang material
+        if (quiet && depth <= quietSeeDepth && !inCheck && legalMoves > 1 && std::abs(bestEval) < mateBound &&
+            !board.SeeAtLeast(move, -quietSeeMargin * depth)) {
+            if (mTrace) {
+                mTrace->Write({alpha, beta, 0, 0, move.Raw(), 0, 0, static_cast<uint8_t>(ply + 1),
+                               static_cast<int8_t>(depth - 1), TraceKind::SeePruned,
+                               static_cast<uint8_t>(maximizingPlayer ? 0 : TraceMaximizing)});
+            }
+            continue;
         }
 
-    if (maximizingPlayer) {
-        int maxEval = std::numeric_limits<int>::min();
-        for (const auto& move : possibleMoves) {
-            Board tempBoard = board;
-            tempBoard.MakeMove(move);
-            int eval = Minimax(tempBoard, depth - 1, false, alpha, beta);
-            maxEval = std::max(maxEval, eval);
+        board.MakeMove(move);
+        int eval = Minimax(board, depth - 1, !maximizingPlayer, alpha, beta);
+        board.UndoMove();
+        if (mStopped) return 0;
+        searchedMoves++;
+
+        if (maximizingPlayer ? eval > bestEval : eval < bestEval) {
+            bestEval = eval;
+            bestMove = move;
+            if (trackPv) {
+                mPv[ply][0] = move;
+                std::copy(mPv[ply + 1], mPv[ply + 1] + mPvLength[ply + 1], mPv[ply] + 1);
+                mPvLength[ply] = mPvLength[ply + 1] + 1;
+            }
+        }
+        if (maximizingPlayer) {
             alpha = std::max(alpha, eval);
-            if (beta <= alpha)
-                break; // Beta cutoff
+        } else {
+            beta = std::min(beta, eval);
+        }
+        if (beta <= alpha) {
+            if (quiet) StoreKiller(ply, move);
+            cutoff = legalMoves;
+            break;
+        }
+    }
+
+    if (legalMoves == 0) {
+        // Prefer the quickest mate, and the slowest when being mated
+        bool inCheck = board.IsWhiteTurn() ? board.IsWhiteInCheck() : board.IsBlackInCheck();
+        int eval = !inCheck ? 0 : board.IsWhiteTurn() ? -(MateScore - ply) : MateScore - ply;
+        if (mTrace) TraceNode(board, TraceKind::Terminal, depth, maximizingPlayer, alpha, beta, eval, startNodes);
+        return eval;
+    }
+
+    Bound bound = bestEval <= alphaOrig ? Bound::Upper
+                : bestEval >= betaOrig ? Bound::Lower
+                : Bound::Exact;
+    mTT->Store(key, bestMove, ScoreToTT(bestEval, ply), depth, bound);
+    if (mTrace) {
+        TraceNode(board, TraceKind::Searched, depth, maximizingPlayer, alphaOrig, betaOrig, bestEval, startNodes,
+                  searchedMoves, cutoff);
+    }
+    return bestEval;
+}
+
+// Captures only, until the position is quiet. The side to move may stand pat on the static
+// evaluation; in check every evasion is searched instead.
+int Engine::Quiesce(Board& board, bool maximizingPlayer, int alpha, int beta) {
+    CountNode();
+    if (mStopped) {
+        return 0;
+    }
+
+    int ply = board.GetPly() - mRootPly;
+    if (ply < MaxPly) mPvLength[ply] = 0;
+    bool inCheck = board.GetAttacks().checkers != 0;
+    if (ply >= MaxPly - 1) {
+        return EvaluateBoard(board);
+    }
+
+    int bestEval = maximizingPlayer ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+    if (!inCheck) {
+        bestEval = EvaluateBoard(board);
+        if (maximizingPlayer ? bestEval >= beta : bestEval <= alpha) return bestEval;
+        if (maximizingPlayer) {
+            alpha = std::max(alpha, bestEval);
+        } else {
+            beta = std::min(beta, bestEval);
         }
-        return maxEval;
-    } else {
-        int minEval = std::numeric_limits<int>::max();
-        for (const auto& move : possibleMoves) {
-            Board tempBoard = board;
-            tempBoard.MakeMove(move);
-            int eval = Minimax(tempBoard, depth - 1, true, alpha, beta);
-            minEval = std::min(minEval, eval);
+    }
+
+    static const Move noKillers[2] = {};
+    MovePicker picker = inCheck ? MovePicker(board, Move(), noKillers) : MovePicker(board);
+    int legalMoves = 0;
+
+    for (Move move = picker.Next(); !move.IsNull(); move = picker.Next()) {
+        legalMoves++;
+        board.MakeMove(move);
+        int eval = Quiesce(board, !maximizingPlayer, alpha, beta);
+        board.UndoMove();
+        if (mStopped) return 0;
+
+        if (maximizingPlayer) {
+            bestEval = std::max(bestEval, eval);
+            alpha = std::max(alpha, eval);
+        } else {
+            bestEval = std::min(bestEval, eval);
             beta = std::min(beta, eval);
-            if (beta <= alpha)
-                break; // Alpha cutoff
         }
-        return minEval;
+        if (beta <= alpha) break;
     }
-}
\ No newline at end of file
+
+    if (inCheck && legalMoves == 0) {
+        return board.IsWhiteTurn() ? -(MateScore - ply) : MateScore - ply;
+    }
+    return bestEval;
+}
+
+void Engine::TraceNode(const Board& board, TraceKind kind, int depth, bool maximizingPlayer, int alpha, int beta,
+                       int result, uint64_t startNodes, int moves, int cutoff) {
+    TraceRecord record;
+    record.alpha = alpha;
+    record.beta = beta;
+    record.result = result;
+    record.nodes = static_cast<uint32_t>(std::min<uint64_t>(mNodes - startNodes, UINT32_MAX));
+    record.move = kind == TraceKind::Root ? 0 : board.GetLastMove().Raw();
+    record.moves = static_cast<uint8_t>(std::min(moves, 255));
+    record.cutoff = static_cast<uint8_t>(std::min(cutoff, 255));
+    record.ply = static_cast<uint8_t>(std::min(board.GetPly() - mRootPly, 255));
+    record.depth = static_cast<int8_t>(depth);
+    record.kind = kind;
+    record.flags = (maximizingPlayer ? TraceMaximizing : 0) | (board.GetAttacks().checkers ? TraceInCheck : 0);
+    mTrace->Write(record);
+}
+
+void Engine::StoreKiller(int ply, Move move) {
+    if (ply >= MaxPly || mKillers[ply][0] == move) return;
+    mKillers[ply][1] = mKillers[ply][0];
+    mKillers[ply][0] = move;
+}
@@ -6,10 +6,23 @@
 #ifndef ENGINE_H
 #define ENGINE_H
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "AllocationTracker.h"
+#include "Move.h"
+#include "PawnTable.h"
+#include "ResultCache.h"
+#include "SearchTrace.h"
+#include "TimeManager.h"
+#include "TranspositionTable.h"
+
 class Board;
+class NnueNetwork;
 
 struct MoveData
 {
@@ -23,7 +36,51 @@ struct MoveData
  int previousFullMoveNumber;
 };
 
+struct SearchLimits
+{
+ int depth = 64;          // deepest iteration
+ int64_t moveTimeMs = 0;  // wall-clock budget, 0 for none
+ int multiPv = 1;         // number of best lines to report
+ uint64_t nodes = 0;      // node budget, 0 for none
+};
+
+/// How a load controller chose a search's limits
+struct LimitDecision
+{
+ bool adaptive = false;   // false when the caller set the limits
+ int64_t moveTimeMs = 0;
+ uint64_t nodes = 0;
+ size_t queued = 0;       // searches pending when it was admitted
+ double nps = 0;          // per-thread nodes per second the node budget assumed
+ double p99Ms = 0;        // recent latency it was steering by
+};
+
+/// A root move with its score and principal variation (starting with the move itself)
+struct PvLine
+{
+ Move move;
+ int score = 0;           // centipawns from the side to move's point of view
+ std::vector<Move> pv;
+};
+
+struct SearchResult
+{
+ Move bestMove;           // null only when there is no legal move
+ int score = 0;           // centipawns from the side to move's point of view
+ std::vector<PvLine> lines; // best first, up to SearchLimits::multiPv of them
+ int depth = 0;           // deepest completed iteration
+ uint64_t nodes = 0;
+ int64_t timeMs = 0;
+ bool stopped = false;    // cut short by Stop(), the time limit or the node budget
+ LimitDecision decision;
+ AllocationCounts allocated; // heap use by the search; counted only in the instrumentation build
+};
+
 class Engine {
+public:
+ static constexpr int MateScore = 100000;
+ static constexpr int MaxPly = 128;
+
 private:
  std::vector<MoveData> moveHistory;
 
@@ -32,10 +89,76 @@ private:
  int halfMoveClock = 0;
  int fullMoveNumber = 1;
 
+ // Evaluator selection ("UseNNUE" / "EvalFile" options)
+ bool mUseNnue = false;
+ std::shared_ptr<NnueNetwork> mNetwork;
+
+ PawnTable mPawnTable;
+
+ // Search state ("Hash" / "SharedHash" / "HugePages" options), shareable between engines
+ std::shared_ptr<TranspositionTable> mTT = std::make_shared<TranspositionTable>();
+ bool mHugePages = false;
+ std::shared_ptr<ResultCache> mResults = std::make_shared<ResultCache>();
+ Move mKillers[MaxPly][2];
+ int mRootPly = 0;
+
+ // Triangular principal variation table, indexed by ply
+ Move mPv[MaxPly][MaxPly];
+ int mPvLength[MaxPly] = {};
+
+ // Stopping: Stop() may be called from any thread; the search polls every StopCheckInterval nodes
+ static constexpr uint64_t StopCheckInterval = 1024;
+ std::atomic<bool> mStopRequested{false};
+ bool mStopped = false;
+ int mDepthLimit = 0;
+ uint64_t mNodeLimit = 0;
+ std::function<void()> mYieldHook; // called at every poll, e.g. to hand the thread to another search
+ std::function<void(const SearchResult&)> mIterationHook;
+ uint64_t mNodes = 0;
+ TimeManager mTime;
+
+ // Allocations so far this search; sampled around the yield hook, since the search may
+ // resume on another thread
+ AllocationCounts mAllocated;
+ AllocationCounts mAllocationMark;
+
+ // Node-by-node record of the search ("TraceFile" option); null when not tracing
+ std::shared_ptr<SearchTrace> mTrace;
+
+ bool SearchRoot(Board& board, int depth, int multiPv, std::vector<PvLine>& lines);
+ int Quiesce(Board& board, bool maximizingPlayer, int alpha, int beta);
+ void CountNode();
+ void StoreKiller(int ply, Move move);
+ void TraceNode(const Board& board, TraceKind kind, int depth, bool maximizingPlayer, int alpha, int beta,
+                int result, uint64_t startNodes, int moves = 0, int cutoff = 0);
+
 public:
  std::string FindBestMove(Board& board, int depth);
+ SearchResult Search(Board& board, const SearchLimits& limits);
+ /// Whether a search to this depth scores the position alone, free of repetition and fifty-move
+ /// rules, so its answer can be cached or shared with other requests for the same key
+ static bool ScoresPositionAlone(const Board& board, int depth);
+ void Stop() { mStopRequested.store(true, std::memory_order_relaxed); }
+ /// Forget what earlier games taught the tables
+ void NewGame();
+ void SetYieldHook(std::function<void()> hook) { mYieldHook = std::move(hook); }
+ /// Called on the searching thread after each completed iteration, with the result so far
+ void SetIterationHook(std::function<void(const SearchResult&)> hook) { mIterationHook = std::move(hook); }
+ /// New depth and time limits for the running search, from its own thread (the yield hook).
+ /// Time already searched counts against the new budget.
+ void Retarget(const SearchLimits& limits);
  int Minimax(Board& board, int depth, bool maximizingPlayer, int alpha, int beta);
  int EvaluateBoard(Board& board);
+
+ bool SetOption(const std::string& name, const std::string& value);
+ bool SaveSnapshot(const std::string& path) const;
+ bool LoadSnapshot(const std::string& path);
+ bool IsNnueActive() const;
+ const PawnTable& GetPawnTable() const { return mPawnTable; }
+ TranspositionTable& GetTranspositionTable() { return *mTT; }
+
+ /// Search with another engine's tables; the transposition table must already be allocated
+ void ShareTables(std::shared_ptr<TranspositionTable> table, std::shared_ptr<ResultCache> results);
 };
 
 #endif //ENGINE_H
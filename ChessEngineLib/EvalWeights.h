@@ -0,0 +1,60 @@
+/**
+ * @file EvalWeights.h
+ * @author John Korreck
+ *
+ * Weights of the hand-written evaluation. Written by the tune tool; regenerate
+ * it rather than editing by hand.
+ */
+
+#ifndef EVALWEIGHTS_H
+#define EVALWEIGHTS_H
+
+namespace EvalWeights {
+
+// Material by piece type: none, pawn, knight, bishop, rook, queen, king
+inline constexpr int pieceValues[7] = {0, 100, 300, 300, 500, 900, 0};
+
+// Piece-square bonuses for white, square = rank * 8 + file with rank 0 the eighth rank.
+// Black uses the square mirrored top to bottom.
+inline constexpr int pawnSquares[64] = {
+       0,    0,    0,    0,    0,    0,    0,    0,
+      50,   50,   50,   50,   50,   50,   50,   50,
+      10,   10,   20,   30,   30,   20,   10,   10,
+       5,    5,   10,   25,   25,   10,    5,    5,
+       0,    0,    0,   20,   20,    0,    0,    0,
+       5,   -5,  -10,    0,    0,  -10,   -5,    5,
+       5,   10,   10,  -20,  -20,   10,   10,    5,
+       0,    0,    0,    0,    0,    0,    0,    0,
+};
+
+inline constexpr int knightSquares[64] = {
+     -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+     -40,  -20,    0,    0,    0,    0,  -20,  -40,
+     -30,    0,   10,   15,   15,   10,    0,  -30,
+     -30,    5,   15,   20,   20,   15,    5,  -30,
+     -30,    0,   15,   20,   20,   15,    0,  -30,
+     -30,    5,   10,   15,   15,   10,    5,  -30,
+     -40,  -20,    0,    5,    5,    0,  -20,  -40,
+     -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+};
+
+inline constexpr int bishopSquares[64] = {
+     -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+     -10,    0,    0,    0,    0,    0,    0,  -10,
+     -10,    0,    5,   10,   10,    5,    0,  -10,
+     -10,    5,    5,   10,   10,    5,    5,  -10,
+     -10,    0,   10,   10,   10,   10,    0,  -10,
+     -10,   10,   10,   10,   10,   10,   10,  -10,
+     -10,    5,    0,    0,    0,    0,    5,  -10,
+     -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+};
+
+// Control per attacked square by piece type, and the extra for d4, e4, d5 and e5,
+// in units of 1/controlScale centipawn
+inline constexpr int controlScale = 5;
+inline constexpr int controlWeights[7] = {0, 5, 10, 5, 5, 5, 3};
+inline constexpr int centreWeights[7] = {0, 10, 20, 10, 10, 10, 0};
+
+} // namespace EvalWeights
+
+#endif //EVALWEIGHTS_H
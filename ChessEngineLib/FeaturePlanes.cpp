@@ -0,0 +1,140 @@
+/**
+ * @file FeaturePlanes.cpp
+ * @author John Korreck
+ */
+
+#include "FeaturePlanes.h"
+#include "Board.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace {
+
+const int sidePlane = 12;
+const int castlingPlane = 13;
+const int enPassantPlane = 17;
+
+// Batches smaller than this per thread aren't worth a thread
+const size_t minPositionsPerThread = 256;
+
+int PiecePlane(int piece) {
+    return piece > 0 ? piece - 1 : 5 - piece;
+}
+
+template <typename T> void FillPlane(T* out, int plane) {
+    std::fill(out + plane * 64, out + (plane + 1) * 64, T(1));
+}
+
+} // namespace
+
+template <typename T> bool EncodeFen(const std::string& fen, T* out) {
+    std::fill(out, out + FeatureSize, T(0));
+
+    // Piece placement
+    size_t i = 0;
+    int rank = 0;
+    int file = 0;
+    for (; i < fen.size() && fen[i] != ' '; i++) {
+        char c = fen[i];
+        if (c == '/') {
+            if (file != 8) break;
+            rank++;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else {
+            static const std::string pieces = "PNBRQKpnbrqk";
+            size_t piece = pieces.find(c);
+            if (piece == std::string::npos || file > 7 || rank > 7) break;
+            out[piece * 64 + rank * 8 + file] = T(1);
+            file++;
+        }
+    }
+    // Side to move is a lone w or b, as PackFen reads it
+    size_t side = i + 1;
+    bool sideRead = side < fen.size() && (fen[side] == 'w' || fen[side] == 'b') &&
+                    (side + 1 == fen.size() || fen[side + 1] == ' ');
+    if (rank != 7 || file != 8 || !sideRead) {
+        std::fill(out, out + FeatureSize, T(0));
+        return false;
+    }
+
+    // Side to move, castling rights and en passant square
+    if (fen[side] == 'w') FillPlane(out, sidePlane);
+    size_t castling = fen.find(' ', side);
+    if (castling == std::string::npos) return true;
+    size_t castlingEnd = std::min(fen.find(' ', castling + 1), fen.size());
+    for (size_t j = castling + 1; j < castlingEnd; j++) {
+        switch (fen[j]) {
+            case 'K': FillPlane(out, castlingPlane); break;
+            case 'Q': FillPlane(out, castlingPlane + 1); break;
+            case 'k': FillPlane(out, castlingPlane + 2); break;
+            case 'q': FillPlane(out, castlingPlane + 3); break;
+        }
+    }
+    if (castlingEnd < fen.size()) {
+        int square = ParseSquare(fen.substr(castlingEnd + 1, 2));
+        if (square >= 0) out[enPassantPlane * 64 + square] = T(1);
+    }
+    return true;
+}
+
+template <typename T> void EncodeBoard(const Board& board, T* out) {
+    std::fill(out, out + FeatureSize, T(0));
+
+    const BoardArray& pieces = board.GetBoard();
+    for (int rank = 0; rank < 8; rank++) {
+        for (int file = 0; file < 8; file++) {
+            int piece = pieces[rank][file];
+            if (piece != 0) {
+                out[PiecePlane(piece) * 64 + rank * 8 + file] = T(1);
+            }
+        }
+    }
+
+    if (board.IsWhiteTurn()) FillPlane(out, sidePlane);
+    int castling = board.CastlingMask();
+    for (int right = 0; right < 4; right++) {
+        if (castling & (1 << right)) FillPlane(out, castlingPlane + right);
+    }
+    if (board.GetEnPassantSquare() >= 0) {
+        out[enPassantPlane * 64 + board.GetEnPassantSquare()] = T(1);
+    }
+}
+
+template <typename T> size_t EncodeFens(const std::vector<std::string>& fens, T* out, int threads) {
+    size_t count = fens.size();
+    size_t workers = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::clamp<size_t>(count / minPositionsPerThread, 1, workers);
+
+    // Contiguous chunks, so each thread writes its own stretch of the tensor
+    std::atomic<size_t> invalid{0};
+    auto encodeRange = [&](size_t begin, size_t end) {
+        size_t bad = 0;
+        for (size_t i = begin; i < end; i++) {
+            if (!EncodeFen(fens[i], out + i * FeatureSize)) bad++;
+        }
+        invalid.fetch_add(bad, std::memory_order_relaxed);
+    };
+
+    std::vector<std::thread> pool;
+    size_t chunk = (count + workers - 1) / workers;
+    for (size_t begin = chunk; begin < count; begin += chunk) {
+        pool.emplace_back(encodeRange, begin, std::min(count, begin + chunk));
+    }
+    encodeRange(0, std::min(count, chunk));
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    return invalid.load();
+}
+
+template bool EncodeFen<uint8_t>(const std::string&, uint8_t*);
+template bool EncodeFen<float>(const std::string&, float*);
+template void EncodeBoard<uint8_t>(const Board&, uint8_t*);
+template void EncodeBoard<float>(const Board&, float*);
+template size_t EncodeFens<uint8_t>(const std::vector<std::string>&, uint8_t*, int);
+template size_t EncodeFens<float>(const std::vector<std::string>&, float*, int);
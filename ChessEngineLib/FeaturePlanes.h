@@ -0,0 +1,37 @@
+/**
+ * @file FeaturePlanes.h
+ * @author John Korreck
+ *
+ * Positions encoded as stacks of 8x8 planes for machine learning. Planes are
+ * indexed [plane][rank][file] with rank 0 the 8th rank, as in Board:
+ *
+ *   0-5    white pawn, knight, bishop, rook, queen, king
+ *   6-11   black pawn, knight, bishop, rook, queen, king
+ *   12     side to move (all ones when white is to move)
+ *   13-16  castling rights: white kingside, white queenside, black kingside, black queenside
+ *   17     en passant target square
+ *
+ * FENs are encoded straight from the text, without building a Board.
+ */
+
+#ifndef FEATUREPLANES_H
+#define FEATUREPLANES_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class Board;
+
+constexpr int FeaturePlaneCount = 18;
+constexpr int FeatureSize = FeaturePlaneCount * 64;
+
+/// Fill FeatureSize values; false (and all zeros) if the FEN can't be read
+template <typename T> bool EncodeFen(const std::string& fen, T* out);
+template <typename T> void EncodeBoard(const Board& board, T* out);
+
+/// Fill fens.size() consecutive positions, split across threads (0 for one per core).
+/// Returns how many FENs couldn't be read.
+template <typename T> size_t EncodeFens(const std::vector<std::string>& fens, T* out, int threads = 0);
+
+#endif //FEATUREPLANES_H
@@ -0,0 +1,115 @@
+/**
+ * @file GameSession.cpp
+ * @author John Korreck
+ */
+
+#include "GameSession.h"
+#include "SearchScheduler.h"
+
+static Board MakeBoard(const std::string& fen) {
+    std::string name = "Session";
+    std::string position = fen;
+    return Board(name, position);
+}
+
+GameSession::GameSession(SearchScheduler& scheduler, const std::string& fen)
+    : mScheduler(scheduler), mBoard(MakeBoard(fen)) {
+}
+
+GameSession::~GameSession() {
+    StopPonder();
+}
+
+void GameSession::SetPondering(bool enabled) {
+    mPonderEnabled = enabled;
+    if (!enabled) StopPonder();
+}
+
+bool GameSession::Push(const std::string& move) {
+    Move parsed = mBoard.ParseMove(move);
+    MoveList legalMoves;
+    mBoard.GenerateMoves(legalMoves);
+    if (parsed.IsNull() || !legalMoves.Contains(parsed)) return false;
+
+    mBoard.MakeMove(parsed);
+    mMoves.push_back(parsed);
+
+    // Still on the expected line, or off it for good; the ponder's table entries stay useful
+    if (!mExpected.empty() && mExpected.front() == parsed) {
+        mExpected.erase(mExpected.begin());
+    } else {
+        mExpected.clear();
+        StopPonder();
+    }
+    return true;
+}
+
+bool GameSession::Pop() {
+    if (mMoves.empty()) return false;
+    mBoard.UndoMove();
+    mMoves.pop_back();
+    mExpected.clear();
+    StopPonder();
+    return true;
+}
+
+std::shared_ptr<SearchJob> GameSession::Go(const SearchLimits& limits, int priority,
+                                           const LimitDecision& decision) {
+    if (mPonder && mBoard.GetKey() == mPonderKey) {
+        // The predicted reply came: carry on from the ponder, counting the time it has had
+        mScheduler.Promote(mPonder, limits, priority, decision);
+        mSearch = std::move(mPonder);
+        return mSearch;
+    }
+
+    StopPonder();
+    mSearch = mScheduler.Submit(mBoard, limits, priority, decision);
+    return mSearch;
+}
+
+SearchResult GameSession::Result() {
+    if (!mSearch) return SearchResult();
+
+    SearchResult result = mSearch->Result();
+    mSearch.reset();
+    mExpected = result.lines.empty() ? std::vector<Move>() : result.lines[0].pv;
+    StartPonder();
+    return result;
+}
+
+SearchResult GameSession::BestMove(const SearchLimits& limits) {
+    Go(limits);
+    return Result();
+}
+
+void GameSession::StartPonder() {
+    if (!mPonderEnabled || mExpected.size() < 2) return;
+
+    // Our move and the reply the search expects
+    Board board = mBoard;
+    board.MakeMove(mExpected[0]);
+    board.MakeMove(mExpected[1]);
+
+    SearchLimits limits;
+    limits.moveTimeMs = PonderLimitMs;
+    mPonder = mScheduler.Submit(board, limits, PonderPriority);
+    mPonderKey = board.GetKey();
+}
+
+void GameSession::StopPonder() {
+    if (!mPonder) return;
+    mPonder->Cancel();
+    mPonder.reset();
+}
+
+GameState GameSession::State() {
+    MoveList legalMoves;
+    mBoard.GenerateMoves(legalMoves);
+    if (legalMoves.Empty()) {
+        bool inCheck = mBoard.IsWhiteTurn() ? mBoard.IsWhiteInCheck() : mBoard.IsBlackInCheck();
+        return inCheck ? GameState::Checkmate : GameState::Stalemate;
+    }
+    if (mBoard.IsRepetition(2)) return GameState::Repetition;
+    if (mBoard.IsFiftyMoveDraw()) return GameState::FiftyMoves;
+    return GameState::Ongoing;
+}
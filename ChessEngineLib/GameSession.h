@@ -0,0 +1,82 @@
+/**
+ * @file GameSession.h
+ * @author John Korreck
+ *
+ * One game searched through the scheduler. The session keeps the board with its
+ * whole move history, so searches see repetitions and the fifty-move rule, and
+ * follows the last search's principal variation as moves are played. Searches
+ * share the scheduler's transposition table, whose entries along that line start
+ * the next search.
+ *
+ * With pondering on, the session keeps searching at low priority after each
+ * result, in the position the principal variation expects after our move and the
+ * reply. If that position arrives, the next search takes over the ponder.
+ */
+
+#ifndef GAMESESSION_H
+#define GAMESESSION_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Board.h"
+#include "Engine.h"
+#include "Move.h"
+
+class SearchJob;
+class SearchScheduler;
+
+enum class GameState { Ongoing, Checkmate, Stalemate, Repetition, FiftyMoves };
+
+class GameSession {
+public:
+    static constexpr const char* StartPosition = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    static constexpr int PonderPriority = -1;
+    static constexpr int64_t PonderLimitMs = 30000; // so an abandoned game doesn't ponder forever
+
+    explicit GameSession(SearchScheduler& scheduler, const std::string& fen = StartPosition);
+    ~GameSession();
+    GameSession(const GameSession&) = delete;
+    GameSession& operator=(const GameSession&) = delete;
+
+    void SetPondering(bool enabled);
+    bool IsPondering() const { return mPonder != nullptr; }
+
+    /// Play a move in long algebraic notation; false if it isn't legal here
+    bool Push(const std::string& move);
+    /// Take back the last move; false at the start of the session
+    bool Pop();
+
+    /// Start searching the current position
+    std::shared_ptr<SearchJob> Go(const SearchLimits& limits, int priority = 0,
+                                  const LimitDecision& decision = LimitDecision());
+    /// Wait for the search started by Go and remember the line it expects
+    SearchResult Result();
+    /// Go and Result together
+    SearchResult BestMove(const SearchLimits& limits);
+
+    GameState State();
+    std::string Fen() { return mBoard.GenerateFen(); }
+    const Board& GetBoard() const { return mBoard; }
+    SearchScheduler& GetScheduler() { return mScheduler; }
+    const std::vector<Move>& Moves() const { return mMoves; }
+    /// What is left of the last search's principal variation, given the moves played since
+    const std::vector<Move>& ExpectedLine() const { return mExpected; }
+
+private:
+    SearchScheduler& mScheduler;
+    Board mBoard;
+    std::vector<Move> mMoves;
+    std::vector<Move> mExpected;
+    std::shared_ptr<SearchJob> mSearch;
+
+    bool mPonderEnabled = false;
+    std::shared_ptr<SearchJob> mPonder;
+    uint64_t mPonderKey = 0;
+
+    void StartPonder();
+    void StopPonder();
+};
+
+#endif //GAMESESSION_H
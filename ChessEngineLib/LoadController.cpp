@@ -0,0 +1,92 @@
+/**
+ * @file LoadController.cpp
+ * @author John Korreck
+ */
+
+#include "LoadController.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Budgets leave a tenth of the target for queueing and answering the request
+const double budgetHeadroom = 0.9;
+// Speed samples from very short runs are mostly noise
+const int64_t minSampleMs = 5;
+const double npsSmoothing = 0.1;
+
+LoadController::LoadController(int64_t targetMs, int64_t minBudgetMs) {
+    SetTarget(targetMs, minBudgetMs);
+}
+
+void LoadController::SetTarget(int64_t targetMs, int64_t minBudgetMs) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTargetMs = std::max<int64_t>(1, targetMs);
+    mMinBudgetMs = std::clamp<int64_t>(minBudgetMs, 1, mTargetMs);
+}
+
+int64_t LoadController::TargetMs() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTargetMs;
+}
+
+bool LoadController::Decide(size_t queued, int threads, LimitDecision& decision) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto budget = static_cast<int64_t>(mTargetMs * mScale * budgetHeadroom);
+    budget = std::clamp(budget, mMinBudgetMs, mTargetMs);
+
+    // Time slicing splits the threads between everything pending
+    double share = std::min(1.0, std::max(1, threads) / (queued + 1.0));
+
+    decision = LimitDecision();
+    decision.adaptive = true;
+    decision.moveTimeMs = budget;
+    decision.queued = queued;
+    decision.nps = mNps;
+    decision.p99Ms = P99Locked();
+    if (budget * share < mMinBudgetMs) return false;
+
+    // Idle searches use the whole budget; shared ones stop once they've had their share
+    if (share < 1.0 && mNps > 0) {
+        decision.nodes = std::max<uint64_t>(1, static_cast<uint64_t>(mNps * budget / 1000.0 * share));
+    }
+    return true;
+}
+
+void LoadController::Record(int64_t latencyMs, bool controlled, uint64_t nodes, int64_t runMs) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (runMs >= minSampleMs) {
+        double nps = nodes * 1000.0 / runMs;
+        mNps = mNps == 0 ? nps : mNps + npsSmoothing * (nps - mNps);
+    }
+    if (!controlled) return;
+
+    mLatencies[mRecorded++ % Window] = latencyMs;
+
+    // Back off while the tail is over target, and creep back up once it's comfortably under
+    double p99 = P99Locked();
+    if (p99 > mTargetMs) {
+        mScale = std::max(0.25, mScale * 0.9);
+    } else if (p99 < mTargetMs * 0.75) {
+        mScale = std::min(1.0, mScale * 1.05);
+    }
+}
+
+double LoadController::Nps() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mNps;
+}
+
+double LoadController::P99Ms() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return P99Locked();
+}
+
+double LoadController::P99Locked() const {
+    size_t count = std::min(mRecorded, Window);
+    if (count == 0) return 0;
+
+    std::array<int64_t, Window> sorted = mLatencies;
+    size_t rank = static_cast<size_t>(std::ceil(count * 0.99)) - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + count);
+    return static_cast<double>(sorted[rank]);
+}
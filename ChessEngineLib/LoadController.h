@@ -0,0 +1,55 @@
+/**
+ * @file LoadController.h
+ * @author John Korreck
+ *
+ * Chooses search limits from the load. It tracks the per-thread search speed and
+ * the latency of recent requests, and gives each new request a time budget
+ * inside the latency target plus a node budget for its share of the threads.
+ * When idle a search gets the whole target; under a burst the node budgets
+ * shrink so the queue drains, and requests that couldn't get a useful share are
+ * refused.
+ */
+
+#ifndef LOADCONTROLLER_H
+#define LOADCONTROLLER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "Engine.h"
+
+class LoadController {
+public:
+    static constexpr size_t Window = 256; // latencies the p99 is taken over
+
+    explicit LoadController(int64_t targetMs = 1000, int64_t minBudgetMs = 20);
+
+    void SetTarget(int64_t targetMs, int64_t minBudgetMs);
+    int64_t TargetMs() const;
+
+    /// Limits for a request arriving with `queued` searches already pending on `threads`
+    /// threads; false if it can't be answered well within the target
+    bool Decide(size_t queued, int threads, LimitDecision& decision);
+
+    /// A finished search: its latency from submission (if it was controlled), the nodes it
+    /// searched and the time it spent on a thread
+    void Record(int64_t latencyMs, bool controlled, uint64_t nodes, int64_t runMs);
+
+    double Nps() const;
+    double P99Ms() const;
+
+private:
+    mutable std::mutex mMutex;
+    int64_t mTargetMs;
+    int64_t mMinBudgetMs;
+    double mNps = 0;          // per thread, smoothed
+    double mScale = 1.0;      // share of the target budgets get, steered by the p99
+    std::array<int64_t, Window> mLatencies{};
+    size_t mRecorded = 0;
+
+    double P99Locked() const;
+};
+
+#endif //LOADCONTROLLER_H
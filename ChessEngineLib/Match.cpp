@@ -0,0 +1,464 @@
+/**
+ * @file Match.cpp
+ * @author John Korreck
+ */
+
+#include "Match.h"
+#include "Board.h"
+#include "TimeManager.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <poll.h>
+#include <signal.h>
+#include <sstream>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+// How long a UCI engine gets to start up, and to answer beyond its clock
+const int64_t handshakeTimeoutMs = 10000;
+const int64_t moveGraceMs = 1000;
+// Untimed moves (fixed depth or nodes) still can't hang the match forever
+const int64_t untimedMoveTimeoutMs = 600000;
+
+static int64_t ElapsedMs(std::chrono::steady_clock::time_point start) {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+bool EnginePlayer::Configure(const Options& options) {
+    for (const auto& [name, value] : options) {
+        if (!mEngine.SetOption(name, value)) return false;
+    }
+    return true;
+}
+
+void EnginePlayer::NewGame() {
+    mEngine.NewGame();
+}
+
+PlayerMove EnginePlayer::Play(Board& board, const std::string&, const std::vector<Move>&,
+                              const MoveRequest& request) {
+    SearchLimits limits;
+    if (request.depth > 0) limits.depth = request.depth;
+    limits.nodes = request.nodes;
+    int side = board.IsWhiteTurn() ? 0 : 1;
+    if (request.timeMs[side] > 0) {
+        limits.moveTimeMs = TimeManager::FromClock(request.timeMs[side], request.incrementMs[side]);
+    }
+
+    SearchResult result = mEngine.Search(board, limits);
+    return {result.bestMove, result.score};
+}
+
+UciPlayer::~UciPlayer() {
+    Stop();
+}
+
+bool UciPlayer::Start(const std::string& command) {
+    Stop();
+    mCommand = command;
+
+    // An engine that dies mid-write mustn't take the match down with it
+    signal(SIGPIPE, SIG_IGN);
+
+    int toEngine[2];
+    int fromEngine[2];
+    if (pipe(toEngine) != 0) return false;
+    if (pipe(fromEngine) != 0) {
+        close(toEngine[0]);
+        close(toEngine[1]);
+        return false;
+    }
+    // Engines started by other workers mustn't inherit our ends
+    for (int fd : {toEngine[1], fromEngine[0]}) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    mPid = fork();
+    if (mPid == 0) {
+        dup2(toEngine[0], STDIN_FILENO);
+        dup2(fromEngine[1], STDOUT_FILENO);
+        close(toEngine[0]);
+        close(fromEngine[1]);
+        execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    close(toEngine[0]);
+    close(fromEngine[1]);
+    mToEngine = toEngine[1];
+    mFromEngine = fromEngine[0];
+    if (mPid < 0) {
+        Stop();
+        return false;
+    }
+
+    mBroken = !(Send("uci") && WaitFor("uciok", handshakeTimeoutMs) &&
+                Send("isready") && WaitFor("readyok", handshakeTimeoutMs));
+    return !mBroken;
+}
+
+void UciPlayer::Stop() {
+    if (mToEngine >= 0) {
+        Send("quit");
+        close(mToEngine);
+    }
+    if (mPid > 0) {
+        // A moment to quit cleanly, then the hard way
+        auto start = std::chrono::steady_clock::now();
+        while (waitpid(mPid, nullptr, WNOHANG) == 0) {
+            if (ElapsedMs(start) > 500) {
+                kill(mPid, SIGKILL);
+                waitpid(mPid, nullptr, 0);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    if (mFromEngine >= 0) close(mFromEngine);
+    mPid = -1;
+    mToEngine = -1;
+    mFromEngine = -1;
+    mBuffer.clear();
+}
+
+bool UciPlayer::Send(const std::string& line) {
+    std::string text = line + "\n";
+    size_t sent = 0;
+    while (sent < text.size()) {
+        ssize_t written = write(mToEngine, text.data() + sent, text.size() - sent);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        sent += written;
+    }
+    return true;
+}
+
+bool UciPlayer::ReadLine(std::string& line, int64_t timeoutMs) {
+    auto start = std::chrono::steady_clock::now();
+    while (true) {
+        size_t end = mBuffer.find('\n');
+        if (end != std::string::npos) {
+            line = mBuffer.substr(0, end);
+            mBuffer.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            return true;
+        }
+
+        int64_t left = timeoutMs - ElapsedMs(start);
+        if (left <= 0) return false;
+        pollfd fd{mFromEngine, POLLIN, 0};
+        int ready = poll(&fd, 1, static_cast<int>(std::min<int64_t>(left, INT_MAX)));
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) return false;
+
+        char chunk[4096];
+        ssize_t count = read(mFromEngine, chunk, sizeof(chunk));
+        if (count <= 0) return false;
+        mBuffer.append(chunk, count);
+    }
+}
+
+bool UciPlayer::WaitFor(const std::string& reply, int64_t timeoutMs) {
+    auto start = std::chrono::steady_clock::now();
+    std::string line;
+    while (ReadLine(line, timeoutMs - ElapsedMs(start))) {
+        if (line == reply) return true;
+    }
+    return false;
+}
+
+void UciPlayer::NewGame() {
+    // An engine that stopped answering gets a fresh process
+    if (mBroken && !Start(mCommand)) return;
+    mBroken = !(Send("ucinewgame") && Send("isready") && WaitFor("readyok", handshakeTimeoutMs));
+}
+
+PlayerMove UciPlayer::Play(Board& board, const std::string& fen, const std::vector<Move>& moves,
+                           const MoveRequest& request) {
+    if (mBroken) return {};
+
+    std::string position = "position fen " + fen;
+    if (!moves.empty()) {
+        position += " moves";
+        for (Move move : moves) {
+            position += " " + move.ToString();
+        }
+    }
+
+    std::ostringstream go;
+    go << "go";
+    int64_t timeoutMs = untimedMoveTimeoutMs;
+    int side = board.IsWhiteTurn() ? 0 : 1;
+    if (request.timeMs[side] > 0) {
+        go << " wtime " << request.timeMs[0] << " btime " << request.timeMs[1]
+           << " winc " << request.incrementMs[0] << " binc " << request.incrementMs[1];
+        timeoutMs = request.timeMs[side] + moveGraceMs;
+    }
+    if (request.depth > 0) go << " depth " << request.depth;
+    if (request.nodes > 0) go << " nodes " << request.nodes;
+
+    if (!Send(position) || !Send(go.str())) {
+        mBroken = true;
+        return {};
+    }
+
+    // The last score reported before bestmove is the one the move was chosen on
+    PlayerMove answer;
+    auto start = std::chrono::steady_clock::now();
+    std::string line;
+    while (ReadLine(line, timeoutMs - ElapsedMs(start))) {
+        std::istringstream words(line);
+        std::string word;
+        words >> word;
+        if (word == "bestmove") {
+            words >> word;
+            answer.move = board.ParseMove(word);
+            return answer;
+        }
+        while (word == "info" && words >> word) {
+            if (word != "score") continue;
+            std::string kind;
+            int value = 0;
+            words >> kind >> value;
+            if (kind == "cp") {
+                answer.score = value;
+            } else if (kind == "mate") {
+                int plies = std::abs(value) * 2 - 1;
+                answer.score = value > 0 ? Engine::MateScore - plies : -(Engine::MateScore - plies);
+            }
+        }
+    }
+
+    mBroken = true;
+    return {};
+}
+
+PlayerFactory ParsePlayer(const std::string& spec) {
+    size_t colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+    std::string rest = colon == std::string::npos ? "" : spec.substr(colon + 1);
+
+    if (kind == "uci") {
+        if (rest.empty()) return {};
+        return [rest]() -> std::unique_ptr<Player> {
+            auto player = std::make_unique<UciPlayer>();
+            if (!player->Start(rest)) return nullptr;
+            return player;
+        };
+    }
+
+    if (kind == "engine") {
+        EnginePlayer::Options options;
+        std::istringstream list(rest);
+        std::string option;
+        while (std::getline(list, option, ',')) {
+            size_t equals = option.find('=');
+            if (equals == std::string::npos) return {};
+            options.emplace_back(option.substr(0, equals), option.substr(equals + 1));
+        }
+        return [options]() -> std::unique_ptr<Player> {
+            auto player = std::make_unique<EnginePlayer>();
+            if (!player->Configure(options)) return nullptr;
+            return player;
+        };
+    }
+    return {};
+}
+
+std::vector<std::string> DefaultOpenings() {
+    return {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+        "rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+        "rnbqkbnr/pppp1ppp/4p3/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+        "rnbqkbnr/pp1ppppp/2p5/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+        "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+        "r1bqkbnr/pppp1ppp/2n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 3 3",
+        "rnbqkbnr/ppp1pppp/8/3p4/3P4/8/PPP1PPPP/RNBQKBNR w KQkq - 0 2",
+        "rnbqkbnr/ppp1pppp/8/3p4/2PP4/8/PP2PPPP/RNBQKBNR b KQkq - 0 2",
+        "rnbqkb1r/pppppppp/5n2/8/3P4/8/PPP1PPPP/RNBQKBNR w KQkq - 1 2",
+        "rnbqkbnr/pppp1ppp/8/4p3/2P5/8/PP1PPPPP/RNBQKBNR w KQkq - 0 2",
+        "rnbqkbnr/ppp1pppp/8/3p4/8/5N2/PPPPPPPP/RNBQKB1R w KQkq - 0 2",
+    };
+}
+
+std::vector<std::string> LoadOpenings(const std::string& path) {
+    std::vector<std::string> openings;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string field;
+        std::vector<std::string> parts;
+        while (parts.size() < 6 && fields >> field) {
+            parts.push_back(field);
+        }
+        if (parts.size() < 4 || parts[0][0] == '#') continue;
+
+        // EPD stops after the en passant square, or carries opcodes instead of the counters
+        auto number = [](const std::string& text) {
+            return std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isdigit(c); });
+        };
+        bool counters = parts.size() == 6 && number(parts[4]) && number(parts[5]);
+        std::string fen = parts[0] + " " + parts[1] + " " + parts[2] + " " + parts[3];
+        fen += counters ? " " + parts[4] + " " + parts[5] : " 0 1";
+        openings.push_back(fen);
+    }
+    return openings;
+}
+
+bool InsufficientMaterial(const Board& board) {
+    int minors = 0;
+    for (const auto& rank : board.GetBoard()) {
+        for (int piece : rank) {
+            int type = std::abs(piece);
+            if (type == 1 || type == 4 || type == 5) return false;
+            if (type == 2 || type == 3) minors++;
+        }
+    }
+    return minors <= 1;
+}
+
+GameRecord PlayGame(Player& white, Player& black, const std::string& fen, const MatchSettings& settings) {
+    GameRecord record;
+    record.fen = fen;
+    std::string name = "Match";
+    std::string position = fen;
+    Board board(name, position);
+    white.NewGame();
+    black.NewGame();
+
+    MoveRequest request;
+    bool timed = settings.baseMs > 0;
+    if (timed) {
+        request.timeMs[0] = request.timeMs[1] = settings.baseMs;
+        request.incrementMs[0] = request.incrementMs[1] = settings.incrementMs;
+    }
+    request.depth = settings.depth;
+    request.nodes = settings.nodes;
+
+    auto finish = [&record](GameOutcome outcome, const char* reason) {
+        record.outcome = outcome;
+        record.reason = reason;
+        return record;
+    };
+
+    int resignSide = 0;
+    int resignPlies = 0;
+    int drawPlies = 0;
+    while (true) {
+        MoveList legalMoves;
+        board.GenerateMoves(legalMoves);
+        int side = board.IsWhiteTurn() ? 0 : 1;
+        GameOutcome loss = side == 0 ? GameOutcome::BlackWins : GameOutcome::WhiteWins;
+        if (legalMoves.Empty()) {
+            return board.GetAttacks().checkers ? finish(loss, "checkmate") : finish(GameOutcome::Draw, "stalemate");
+        }
+        if (board.IsRepetition(2)) return finish(GameOutcome::Draw, "repetition");
+        if (board.IsFiftyMoveDraw()) return finish(GameOutcome::Draw, "fifty moves");
+        if (InsufficientMaterial(board)) return finish(GameOutcome::Draw, "insufficient material");
+        if (static_cast<int>(record.moves.size()) >= settings.maxMoves * 2) {
+            return finish(GameOutcome::Draw, "move limit");
+        }
+
+        Player& player = side == 0 ? white : black;
+        auto start = std::chrono::steady_clock::now();
+        PlayerMove answer = player.Play(board, fen, record.moves, request);
+        if (timed) {
+            request.timeMs[side] -= ElapsedMs(start);
+            if (request.timeMs[side] <= 0) return finish(loss, "time forfeit");
+            request.timeMs[side] += settings.incrementMs;
+        }
+        if (answer.move.IsNull()) return finish(loss, "no move");
+        if (!legalMoves.Contains(answer.move)) return finish(loss, "illegal move");
+
+        board.MakeMove(answer.move);
+        record.moves.push_back(answer.move);
+
+        // Adjudicate on what the engines agree, seen from white
+        int score = side == 0 ? answer.score : -answer.score;
+        int ahead = score >= settings.resignScore ? 1 : score <= -settings.resignScore ? -1 : 0;
+        resignPlies = ahead != 0 && ahead == resignSide ? resignPlies + 1 : ahead != 0 ? 1 : 0;
+        resignSide = ahead;
+        if (settings.resignMoves > 0 && resignPlies >= settings.resignMoves * 2) {
+            return finish(ahead > 0 ? GameOutcome::WhiteWins : GameOutcome::BlackWins, "adjudicated win");
+        }
+
+        drawPlies = std::abs(score) <= settings.drawScore ? drawPlies + 1 : 0;
+        if (settings.drawMoves > 0 && drawPlies >= settings.drawMoves * 2 &&
+            static_cast<int>(record.moves.size()) >= settings.drawFromMove * 2) {
+            return finish(GameOutcome::Draw, "adjudicated draw");
+        }
+    }
+}
+
+Match::Match(PlayerFactory first, PlayerFactory second, MatchSettings settings)
+    : mFirst(std::move(first)), mSecond(std::move(second)), mSettings(std::move(settings)),
+      mSprt(mSettings.elo0, mSettings.elo1, mSettings.alpha, mSettings.beta) {
+    if (mSettings.openings.empty()) mSettings.openings = DefaultOpenings();
+}
+
+MatchScore Match::Run(const Progress& progress) {
+    std::vector<std::thread> workers;
+    for (int i = 1; i < mSettings.concurrency; i++) {
+        workers.emplace_back(&Match::Worker, this, std::cref(progress));
+    }
+    Worker(progress);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mScore;
+}
+
+SprtDecision Match::Decision() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mDecision;
+}
+
+void Match::Worker(const Progress& progress) {
+    std::unique_ptr<Player> first = mFirst();
+    std::unique_ptr<Player> second = mSecond();
+    if (!first || !second) {
+        mFailedWorkers++;
+        return;
+    }
+
+    while (!mFinished) {
+        int game = mNextGame++;
+        if (game >= mSettings.games) break;
+
+        // Both colours of an opening, so neither side gets the better openings
+        bool firstWhite = game % 2 == 0;
+        const std::string& fen = mSettings.openings[(game / 2) % mSettings.openings.size()];
+        GameRecord record = firstWhite ? PlayGame(*first, *second, fen, mSettings)
+                                       : PlayGame(*second, *first, fen, mSettings);
+        record.firstPlayedWhite = firstWhite;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        // Games still running when the test decided don't change its verdict
+        if (mFinished) break;
+        if (record.outcome == GameOutcome::Draw) {
+            mScore.draws++;
+        } else if ((record.outcome == GameOutcome::WhiteWins) == firstWhite) {
+            mScore.wins++;
+        } else {
+            mScore.losses++;
+        }
+
+        if (mSettings.sprt) {
+            mDecision = mSprt.Decide(mScore);
+            if (mDecision != SprtDecision::Continue) mFinished = true;
+        }
+        if (progress) progress(record, mScore);
+    }
+}
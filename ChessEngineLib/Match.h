@@ -0,0 +1,176 @@
+/**
+ * @file Match.h
+ * @author John Korreck
+ *
+ * Engine-vs-engine matches for measuring strength at a time control. A player
+ * is either this engine in-process with its own options, or any engine program
+ * driven over UCI, such as another build of this one run with --uci. Each
+ * opening is played twice with the colours reversed, games run concurrently,
+ * and the match stops early once the SPRT decides.
+ */
+
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Engine.h"
+#include "Move.h"
+#include "Sprt.h"
+
+class Board;
+
+/// What a player is given for one move: the clocks (0 when untimed) or fixed limits
+struct MoveRequest {
+    int64_t timeMs[2] = {0, 0};       // indexed 0 for white, 1 for black
+    int64_t incrementMs[2] = {0, 0};
+    int depth = 0;
+    uint64_t nodes = 0;
+};
+
+/// A player's answer; the score is from the side to move's point of view
+struct PlayerMove {
+    Move move;
+    int score = 0;
+};
+
+class Player {
+public:
+    virtual ~Player() = default;
+    virtual void NewGame() {}
+    /// Choose a move in `board`, reached from `fen` by `moves`; a null move forfeits
+    virtual PlayerMove Play(Board& board, const std::string& fen, const std::vector<Move>& moves,
+                            const MoveRequest& request) = 0;
+};
+
+/// This engine, in-process
+class EnginePlayer : public Player {
+public:
+    using Options = std::vector<std::pair<std::string, std::string>>;
+
+    /// False if the engine refuses one of the options
+    bool Configure(const Options& options);
+    void NewGame() override;
+    PlayerMove Play(Board& board, const std::string& fen, const std::vector<Move>& moves,
+                    const MoveRequest& request) override;
+
+private:
+    Engine mEngine;
+};
+
+/// Another engine program, run through /bin/sh and spoken to over UCI
+class UciPlayer : public Player {
+public:
+    ~UciPlayer() override;
+
+    /// Launch the program and complete the handshake
+    bool Start(const std::string& command);
+    void NewGame() override;
+    PlayerMove Play(Board& board, const std::string& fen, const std::vector<Move>& moves,
+                    const MoveRequest& request) override;
+
+private:
+    std::string mCommand;
+    int mPid = -1;
+    int mToEngine = -1;
+    int mFromEngine = -1;
+    std::string mBuffer;
+    bool mBroken = false;
+
+    void Stop();
+    bool Send(const std::string& line);
+    /// Next line from the engine, or false if none comes within the timeout
+    bool ReadLine(std::string& line, int64_t timeoutMs);
+    bool WaitFor(const std::string& reply, int64_t timeoutMs);
+};
+
+using PlayerFactory = std::function<std::unique_ptr<Player>()>;
+
+/// "engine", "engine:Name=value,Name=value" or "uci:<command>"; empty if the spec is malformed
+PlayerFactory ParsePlayer(const std::string& spec);
+
+enum class GameOutcome { WhiteWins, BlackWins, Draw };
+
+struct GameRecord {
+    std::string fen;
+    std::vector<Move> moves;
+    GameOutcome outcome = GameOutcome::Draw;
+    std::string reason;
+    bool firstPlayedWhite = true;
+};
+
+struct MatchSettings {
+    int games = 1000;            // at most; the SPRT usually stops sooner
+    int concurrency = 1;
+    int64_t baseMs = 10000;      // per side; 0 plays untimed on depth or nodes
+    int64_t incrementMs = 100;
+    int depth = 0;
+    uint64_t nodes = 0;
+    std::vector<std::string> openings;
+
+    // Adjudication. Resign once both engines agree one side is this far ahead for this
+    // many moves each; draw once they agree it's this level for as long, from this move.
+    int resignScore = 1000;
+    int resignMoves = 3;
+    int drawScore = 10;
+    int drawMoves = 8;
+    int drawFromMove = 40;
+    int maxMoves = 300;
+
+    bool sprt = true;
+    double elo0 = 0;
+    double elo1 = 5;
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+/// A handful of balanced openings, used when no suite is given
+std::vector<std::string> DefaultOpenings();
+
+/// One FEN or EPD per line; blank lines and lines starting with # are skipped
+std::vector<std::string> LoadOpenings(const std::string& path);
+
+/// Neither side has a pawn, rook or queen, and there's at most one minor piece on the board
+bool InsufficientMaterial(const Board& board);
+
+GameRecord PlayGame(Player& white, Player& black, const std::string& fen, const MatchSettings& settings);
+
+class Match {
+public:
+    using Progress = std::function<void(const GameRecord& game, const MatchScore& score)>;
+
+    Match(PlayerFactory first, PlayerFactory second, MatchSettings settings);
+
+    /// Play until the game count is reached or the SPRT decides, calling `progress` after
+    /// every game (one at a time). Scores are from the first player's point of view.
+    MatchScore Run(const Progress& progress = {});
+
+    SprtDecision Decision() const;
+    const Sprt& GetSprt() const { return mSprt; }
+    /// Workers whose players couldn't be created, e.g. a UCI command that didn't start
+    int FailedWorkers() const { return mFailedWorkers; }
+
+private:
+    PlayerFactory mFirst;
+    PlayerFactory mSecond;
+    MatchSettings mSettings;
+    Sprt mSprt;
+
+    mutable std::mutex mMutex;
+    MatchScore mScore;
+    SprtDecision mDecision = SprtDecision::Continue;
+    std::atomic<int> mNextGame{0};
+    std::atomic<bool> mFinished{false};
+    std::atomic<int> mFailedWorkers{0};
+
+    void Worker(const Progress& progress);
+};
+
+#endif //MATCH_H
@@ -0,0 +1,93 @@
+/**
+ * @file Move.h
+ * @author John Korreck
+ *
+ * Compact move encoding and a fixed-capacity move list that lives on the stack.
+ */
+
+#ifndef MOVE_H
+#define MOVE_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+/// Square index in Board layout (0 = a8, 63 = h1) to algebraic name
+inline std::string SquareName(int square) {
+    return {static_cast<char>('a' + square % 8), static_cast<char>('8' - square / 8)};
+}
+
+/// Algebraic name to square index, -1 if it isn't a square
+inline int ParseSquare(const std::string& name) {
+    if (name.size() < 2 || name[0] < 'a' || name[0] > 'h' || name[1] < '1' || name[1] > '8') return -1;
+    return (8 - (name[1] - '0')) * 8 + (name[0] - 'a');
+}
+
+/// Which moves a generator produces. Captures include queen promotions;
+/// evasions are the moves that might get the side to move out of check.
+enum class GenType { All, Captures, Quiets, Evasions };
+
+/**
+ * A move packed into 16 bits: from square, to square and promotion piece type
+ * (0 for none, otherwise the Board piece type 2-5).
+ */
+class Move {
+public:
+    constexpr Move() = default;
+    constexpr Move(int from, int to, int promotion = 0)
+        : mData(static_cast<uint16_t>(from | (to << 6) | (promotion << 12))) {}
+
+    constexpr int From() const { return mData & 63; }
+    constexpr int To() const { return (mData >> 6) & 63; }
+    constexpr int Promotion() const { return mData >> 12; }
+    constexpr bool IsNull() const { return mData == 0; }
+    constexpr uint16_t Raw() const { return mData; }
+    static constexpr Move FromRaw(uint16_t raw) { Move move; move.mData = raw; return move; }
+
+    constexpr bool operator==(const Move& other) const = default;
+
+    /// Long algebraic notation, e.g. "e2e4" or "e7e8q"
+    std::string ToString() const {
+        static const char promotionChars[] = " pnbrq";
+        std::string text = SquareName(From()) + SquareName(To());
+        if (Promotion()) text += promotionChars[Promotion()];
+        return text;
+    }
+
+private:
+    uint16_t mData = 0;
+};
+
+/// Fixed-capacity list of moves; no position has more than 218 legal moves
+class MoveList {
+public:
+    static constexpr int Capacity = 256;
+
+    void Add(Move move) { mMoves[mSize++] = move; }
+    void Clear() { mSize = 0; }
+    void Resize(int size) { mSize = size; }
+    int Size() const { return mSize; }
+    bool Empty() const { return mSize == 0; }
+    bool Contains(Move move) const;
+
+    Move& operator[](int index) { return mMoves[index]; }
+    const Move& operator[](int index) const { return mMoves[index]; }
+
+    Move* begin() { return mMoves.data(); }
+    Move* end() { return mMoves.data() + mSize; }
+    const Move* begin() const { return mMoves.data(); }
+    const Move* end() const { return mMoves.data() + mSize; }
+
+private:
+    std::array<Move, Capacity> mMoves;
+    int mSize = 0;
+};
+
+inline bool MoveList::Contains(Move move) const {
+    for (Move m : *this) {
+        if (m == move) return true;
+    }
+    return false;
+}
+
+#endif //MOVE_H
@@ -0,0 +1,134 @@
+/**
+ * @file MovePicker.cpp
+ * @author John Korreck
+ */
+
+#include "MovePicker.h"
+#include "Board.h"
+
+#include <cstdlib>
+#include <utility>
+
+// Piece values for MVV-LVA, indexed by piece type
+static const int pieceValues[7] = {0, 100, 320, 330, 500, 900, 0};
+
+MovePicker::MovePicker(Board& board, Move ttMove, const Move killers[2])
+    : mBoard(board), mKillers{killers[0], killers[1]} {
+    // A hash collision can hand us a move from another position
+    if (!ttMove.IsNull() && board.IsPseudoLegal(ttMove)) {
+        mTTMove = ttMove;
+    }
+}
+
+MovePicker::MovePicker(Board& board)
+    : mBoard(board), mStage(Stage::GenerateCaptures), mCapturesOnly(true) {
+}
+
+Move MovePicker::Next() {
+    while (true) {
+        switch (mStage) {
+            case Stage::TTMove:
+                mStage = Stage::GenerateCaptures;
+                if (!mTTMove.IsNull() && mBoard.IsLegal(mTTMove)) {
+                    return mTTMove;
+                }
+                break;
+
+            case Stage::GenerateCaptures:
+                mMoves.Clear();
+                mBoard.GeneratePseudoLegalMoves(mMoves, GenType::Captures);
+                ScoreCaptures();
+                mCurrent = 0;
+                mStage = Stage::GoodCaptures;
+                break;
+
+            case Stage::GoodCaptures:
+                while (mCurrent < mMoves.Size()) {
+                    Move move = SelectBest();
+                    if (move == mTTMove) continue;
+                    if (!mBoard.SeeAtLeast(move)) {
+                        // Quiescence drops losing captures altogether
+                        if (!mCapturesOnly) mBadCaptures.Add(move);
+                        continue;
+                    }
+                    if (mBoard.IsLegal(move)) {
+                        return move;
+                    }
+                }
+                mStage = mCapturesOnly ? Stage::Done : Stage::Killers;
+                break;
+
+            case Stage::Killers:
+                while (mKillerIndex < 2) {
+                    Move killer = mKillers[mKillerIndex++];
+                    if (!killer.IsNull() && killer != mTTMove && !mBoard.IsTactical(killer) &&
+                        mBoard.IsPseudoLegal(killer) && mBoard.IsLegal(killer)) {
+                        return killer;
+                    }
+                }
+                mStage = Stage::GenerateQuiets;
+                break;
+
+            case Stage::GenerateQuiets:
+                mMoves.Clear();
+                mBoard.GeneratePseudoLegalMoves(mMoves, GenType::Quiets);
+                mCurrent = 0;
+                mStage = Stage::Quiets;
+                break;
+
+            case Stage::Quiets:
+                while (mCurrent < mMoves.Size()) {
+                    Move move = mMoves[mCurrent++];
+                    if (!IsSpecial(move) && mBoard.IsLegal(move)) {
+                        return move;
+                    }
+                }
+                mCurrent = 0;
+                mStage = Stage::BadCaptures;
+                break;
+
+            case Stage::BadCaptures:
+                // Already in MVV-LVA order
+                while (mCurrent < mBadCaptures.Size()) {
+                    Move move = mBadCaptures[mCurrent++];
+                    if (mBoard.IsLegal(move)) {
+                        return move;
+                    }
+                }
+                mStage = Stage::Done;
+                break;
+
+            case Stage::Done:
+                return Move();
+        }
+    }
+}
+
+void MovePicker::ScoreCaptures() {
+    const BoardArray& board = mBoard.GetBoard();
+    for (int i = 0; i < mMoves.Size(); i++) {
+        Move move = mMoves[i];
+        int victim = std::abs(board[move.To() / 8][move.To() % 8]);
+        int attacker = std::abs(board[move.From() / 8][move.From() % 8]);
+
+        // En passant lands on an empty square but still takes a pawn
+        if (victim == 0 && attacker == 1) victim = 1;
+
+        mScores[i] = pieceValues[victim] * 16 - attacker + (move.Promotion() ? pieceValues[5] : 0);
+    }
+}
+
+Move MovePicker::SelectBest() {
+    // Selection sort one step at a time; most nodes cut off after a move or two
+    int best = mCurrent;
+    for (int i = mCurrent + 1; i < mMoves.Size(); i++) {
+        if (mScores[i] > mScores[best]) best = i;
+    }
+    std::swap(mMoves[best], mMoves[mCurrent]);
+    std::swap(mScores[best], mScores[mCurrent]);
+    return mMoves[mCurrent++];
+}
+
+bool MovePicker::IsSpecial(Move move) const {
+    return move == mTTMove || move == mKillers[0] || move == mKillers[1];
+}
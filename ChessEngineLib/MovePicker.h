@@ -0,0 +1,47 @@
+/**
+ * @file MovePicker.h
+ * @author John Korreck
+ *
+ * Hands out moves one at a time in search order, generating each stage only
+ * when the previous one is exhausted so cutoffs skip the rest of the work.
+ * Captures that lose material by static exchange wait until after the quiets.
+ */
+
+#ifndef MOVEPICKER_H
+#define MOVEPICKER_H
+
+#include "Move.h"
+
+class Board;
+
+class MovePicker {
+public:
+    MovePicker(Board& board, Move ttMove, const Move killers[2]);
+
+    /// Quiescence: only the captures that don't lose material
+    explicit MovePicker(Board& board);
+
+    /// Next legal move, or a null move once every stage is exhausted
+    Move Next();
+
+private:
+    enum class Stage { TTMove, GenerateCaptures, GoodCaptures, Killers, GenerateQuiets, Quiets, BadCaptures, Done };
+
+    Board& mBoard;
+    Move mTTMove;
+    Move mKillers[2];
+    Stage mStage = Stage::TTMove;
+    int mKillerIndex = 0;
+    bool mCapturesOnly = false;
+
+    MoveList mMoves;
+    int mScores[MoveList::Capacity];
+    int mCurrent = 0;
+    MoveList mBadCaptures;
+
+    void ScoreCaptures();
+    Move SelectBest();
+    bool IsSpecial(Move move) const;
+};
+
+#endif //MOVEPICKER_H
@@ -0,0 +1,307 @@
+/**
+ * @file Nnue.cpp
+ * @author John Korreck
+ */
+
+#include "Nnue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NNUE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t HeaderBytes = sizeof(NnueFileHeader);
+constexpr size_t FtBiasBytes = NnueNetwork::HalfDimensions * sizeof(int16_t);
+constexpr size_t FtWeightBytes = size_t(NnueNetwork::FeatureCount) * NnueNetwork::HalfDimensions * sizeof(int16_t);
+constexpr size_t L1BiasBytes = NnueNetwork::L1Size * sizeof(int32_t);
+constexpr size_t L1WeightBytes = NnueNetwork::L1Size * 2 * NnueNetwork::HalfDimensions;
+constexpr size_t L2BiasBytes = NnueNetwork::L2Size * sizeof(int32_t);
+constexpr size_t L2WeightBytes = NnueNetwork::L2Size * NnueNetwork::L1Size;
+constexpr size_t OutBiasBytes = sizeof(int32_t);
+constexpr size_t OutWeightBytes = NnueNetwork::L2Size;
+
+static_assert(HeaderBytes == 64, "network header must stay 64 bytes");
+
+// ------------------------------------------------------------------
+// Scalar kernels
+// ------------------------------------------------------------------
+
+void AddRowScalar(int16_t* acc, const int16_t* row) {
+    for (int i = 0; i < NnueNetwork::HalfDimensions; i++) acc[i] += row[i];
+}
+
+void SubRowScalar(int16_t* acc, const int16_t* row) {
+    for (int i = 0; i < NnueNetwork::HalfDimensions; i++) acc[i] -= row[i];
+}
+
+void ClipScalar(const int16_t* in, uint8_t* out, int n) {
+    for (int i = 0; i < n; i++) out[i] = static_cast<uint8_t>(std::clamp<int>(in[i], 0, 127));
+}
+
+int32_t DotScalar(const uint8_t* in, const int8_t* weights, int n) {
+    int32_t sum = 0;
+    for (int i = 0; i < n; i++) sum += int32_t(in[i]) * int32_t(weights[i]);
+    return sum;
+}
+
+#ifdef NNUE_X86
+
+// ------------------------------------------------------------------
+// SSE4.1 kernels
+// ------------------------------------------------------------------
+
+__attribute__((target("sse4.1")))
+void AddRowSse41(int16_t* acc, const int16_t* row) {
+    for (int i = 0; i < NnueNetwork::HalfDimensions; i += 8) {
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i), _mm_add_epi16(a, b));
+    }
+}
+
+__attribute__((target("sse4.1")))
+void SubRowSse41(int16_t* acc, const int16_t* row) {
+    for (int i = 0; i < NnueNetwork::HalfDimensions; i += 8) {
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i), _mm_sub_epi16(a, b));
+    }
+}
+
+__attribute__((target("sse4.1")))
+void ClipSse41(const int16_t* in, uint8_t* out, int n) {
+    const auto zero = _mm_setzero_si128();
+    for (int i = 0; i < n; i += 16) {
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+        auto packed = _mm_max_epi8(_mm_packs_epi16(a, b), zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+}
+
+__attribute__((target("sse4.1")))
+int32_t DotSse41(const uint8_t* in, const int8_t* weights, int n) {
+    const auto ones = _mm_set1_epi16(1);
+    auto sum = _mm_setzero_si128();
+    for (int i = 0; i < n; i += 16) {
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(a, b), ones));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+// ------------------------------------------------------------------
+// AVX2 kernels
+// ------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+void AddRowAvx2(int16_t* acc, const int16_t* row) {
+    for (int i = 0; i < NnueNetwork::HalfDimensions; i += 16) {
+        auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+        auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_add_epi16(a, b));
+    }
+}
+
+__attribute__((target("avx2")))
+void SubRowAvx2(int16_t* acc, const int16_t* row) {
+    for (int i = 0; i < NnueNetwork::HalfDimensions; i += 16) {
+        auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+        auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_sub_epi16(a, b));
+    }
+}
+
+__attribute__((target("avx2")))
+void ClipAvx2(const int16_t* in, uint8_t* out, int n) {
+    const auto zero = _mm256_setzero_si256();
+    for (int i = 0; i < n; i += 32) {
+        auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 16));
+        // packs works per 128-bit lane, so restore the element order afterwards
+        auto packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_max_epi8(packed, zero));
+    }
+}
+
+__attribute__((target("avx2")))
+int32_t DotAvx2(const uint8_t* in, const int8_t* weights, int n) {
+    const auto ones = _mm256_set1_epi16(1);
+    auto sum = _mm256_setzero_si256();
+    for (int i = 0; i < n; i += 32) {
+        auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(a, b), ones));
+    }
+    auto half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    return _mm_cvtsi128_si32(half);
+}
+
+#endif // NNUE_X86
+
+struct Kernels {
+    void (*addRow)(int16_t*, const int16_t*);
+    void (*subRow)(int16_t*, const int16_t*);
+    void (*clip)(const int16_t*, uint8_t*, int);
+    int32_t (*dot)(const uint8_t*, const int8_t*, int);
+};
+
+Kernels KernelsFor(NnueSimd simd) {
+#ifdef NNUE_X86
+    switch (simd) {
+        case NnueSimd::Avx2: return {AddRowAvx2, SubRowAvx2, ClipAvx2, DotAvx2};
+        case NnueSimd::Sse41: return {AddRowSse41, SubRowSse41, ClipSse41, DotSse41};
+        case NnueSimd::Scalar: break;
+    }
+#endif
+    return {AddRowScalar, SubRowScalar, ClipScalar, DotScalar};
+}
+
+NnueSimd gActiveSimd = NnueNetwork::DetectedSimd();
+Kernels gKernels = KernelsFor(gActiveSimd);
+
+} // namespace
+
+NnueNetwork::~NnueNetwork() {
+    Unmap();
+}
+
+void NnueNetwork::Unmap() {
+    if (mMapping) {
+        munmap(mMapping, mMappingSize);
+    }
+    mMapping = nullptr;
+    mMappingSize = 0;
+}
+
+size_t NnueNetwork::FileSize() {
+    return HeaderBytes + FtBiasBytes + FtWeightBytes + L1BiasBytes + L1WeightBytes +
+           L2BiasBytes + L2WeightBytes + OutBiasBytes + OutWeightBytes;
+}
+
+bool NnueNetwork::Load(const std::string& path) {
+    Unmap();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) != FileSize()) {
+        close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, FileSize(), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    // The weights are touched on the first evaluations anyway, so fault them in now
+    madvise(mapping, FileSize(), MADV_WILLNEED);
+
+    NnueFileHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+        header.version != Version ||
+        header.featureCount != FeatureCount ||
+        header.halfDimensions != HalfDimensions ||
+        header.l1Size != L1Size ||
+        header.l2Size != L2Size) {
+        munmap(mapping, FileSize());
+        return false;
+    }
+
+    mMapping = mapping;
+    mMappingSize = FileSize();
+
+    auto* bytes = static_cast<const uint8_t*>(mapping) + HeaderBytes;
+    mFtBiases = reinterpret_cast<const int16_t*>(bytes);     bytes += FtBiasBytes;
+    mFtWeights = reinterpret_cast<const int16_t*>(bytes);    bytes += FtWeightBytes;
+    mL1Biases = reinterpret_cast<const int32_t*>(bytes);     bytes += L1BiasBytes;
+    mL1Weights = reinterpret_cast<const int8_t*>(bytes);     bytes += L1WeightBytes;
+    mL2Biases = reinterpret_cast<const int32_t*>(bytes);     bytes += L2BiasBytes;
+    mL2Weights = reinterpret_cast<const int8_t*>(bytes);     bytes += L2WeightBytes;
+    mOutBias = reinterpret_cast<const int32_t*>(bytes);      bytes += OutBiasBytes;
+    mOutWeights = reinterpret_cast<const int8_t*>(bytes);
+    return true;
+}
+
+int NnueNetwork::FeatureIndex(int perspective, int kingSquare, int piece, int square) {
+    // Mirror ranks for black so "own" pieces always look the same to the network
+    int flip = perspective == 0 ? 0 : 56;
+    bool own = (piece > 0) == (perspective == 0);
+    int pieceIndex = (std::abs(piece) - 1) * 2 + (own ? 0 : 1);
+    return (kingSquare ^ flip) * 640 + pieceIndex * 64 + (square ^ flip);
+}
+
+void NnueNetwork::RefreshAccumulator(NnueAccumulator& acc, int perspective, const int* features, int count) const {
+    std::memcpy(acc.values[perspective], mFtBiases, FtBiasBytes);
+    for (int i = 0; i < count; i++) {
+        AddFeature(acc, perspective, features[i]);
+    }
+}
+
+void NnueNetwork::AddFeature(NnueAccumulator& acc, int perspective, int feature) const {
+    gKernels.addRow(acc.values[perspective], mFtWeights + size_t(feature) * HalfDimensions);
+}
+
+void NnueNetwork::SubFeature(NnueAccumulator& acc, int perspective, int feature) const {
+    gKernels.subRow(acc.values[perspective], mFtWeights + size_t(feature) * HalfDimensions);
+}
+
+int NnueNetwork::Evaluate(const NnueAccumulator& acc, bool whiteToMove) const {
+    alignas(64) uint8_t input[2 * HalfDimensions];
+    alignas(64) uint8_t hidden1[L1Size];
+    alignas(64) uint8_t hidden2[L2Size];
+
+    int us = whiteToMove ? 0 : 1;
+    gKernels.clip(acc.values[us], input, HalfDimensions);
+    gKernels.clip(acc.values[us ^ 1], input + HalfDimensions, HalfDimensions);
+
+    for (int i = 0; i < L1Size; i++) {
+        int32_t sum = mL1Biases[i] + gKernels.dot(input, mL1Weights + i * 2 * HalfDimensions, 2 * HalfDimensions);
+        hidden1[i] = static_cast<uint8_t>(std::clamp(sum >> WeightShift, 0, 127));
+    }
+
+    for (int i = 0; i < L2Size; i++) {
+        int32_t sum = mL2Biases[i] + gKernels.dot(hidden1, mL2Weights + i * L1Size, L1Size);
+        hidden2[i] = static_cast<uint8_t>(std::clamp(sum >> WeightShift, 0, 127));
+    }
+
+    int32_t output = *mOutBias + gKernels.dot(hidden2, mOutWeights, L2Size);
+    return output / OutputScale;
+}
+
+NnueSimd NnueNetwork::DetectedSimd() {
+#ifdef NNUE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return NnueSimd::Avx2;
+    if (__builtin_cpu_supports("sse4.1")) return NnueSimd::Sse41;
+#endif
+    return NnueSimd::Scalar;
+}
+
+NnueSimd NnueNetwork::ActiveSimd() {
+    return gActiveSimd;
+}
+
+void NnueNetwork::SetSimd(NnueSimd simd) {
+    // Never select kernels the CPU cannot run
+    gActiveSimd = std::min(simd, DetectedSimd());
+    gKernels = KernelsFor(gActiveSimd);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file Nnue.h
+ * @author John Korreck
+ *
+ * Efficiently updatable neural network evaluator.
+ *
+ * The network is a HalfKP feature transformer (king square x non-king piece
+ * square, one half per perspective) feeding two small int8 layers:
+ *
+ *     40960 -> 256 (x2 perspectives) -> 32 -> 32 -> 1
+ *
+ * Squares use the Board layout (0 = a8, 63 = h1). The black perspective is
+ * mirrored vertically so both halves share one set of weights.
+ */
+
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/// One accumulator per perspective (index 0 = white, 1 = black)
+struct NnueAccumulator {
+    alignas(64) int16_t values[2][256];
+};
+
+/// Layout of the first 64 bytes of a network file
+struct NnueFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t featureCount;
+    uint32_t halfDimensions;
+    uint32_t l1Size;
+    uint32_t l2Size;
+    uint8_t reserved[36];
+};
+
+enum class NnueSimd { Scalar, Sse41, Avx2 };
+
+class NnueNetwork {
+public:
+    static constexpr int FeatureCount = 64 * 640;
+    static constexpr int HalfDimensions = 256;
+    static constexpr int L1Size = 32;
+    static constexpr int L2Size = 32;
+    static constexpr int WeightShift = 6;
+    static constexpr int OutputScale = 16;
+    static constexpr uint32_t Version = 1;
+    static constexpr char Magic[8] = {'C', 'E', 'N', 'N', 'U', 'E', 'v', '1'};
+
+    NnueNetwork() = default;
+    ~NnueNetwork();
+    NnueNetwork(const NnueNetwork&) = delete;
+    NnueNetwork& operator=(const NnueNetwork&) = delete;
+
+    bool Load(const std::string& path);
+    bool IsLoaded() const { return mMapping != nullptr; }
+    static size_t FileSize();
+
+    static int FeatureIndex(int perspective, int kingSquare, int piece, int square);
+
+    void RefreshAccumulator(NnueAccumulator& acc, int perspective, const int* features, int count) const;
+    void AddFeature(NnueAccumulator& acc, int perspective, int feature) const;
+    void SubFeature(NnueAccumulator& acc, int perspective, int feature) const;
+
+    /// Evaluation in centipawns from the side to move's point of view
+    int Evaluate(const NnueAccumulator& acc, bool whiteToMove) const;
+
+    static NnueSimd DetectedSimd();
+    static NnueSimd ActiveSimd();
+    static void SetSimd(NnueSimd simd);
+
+private:
+    void Unmap();
+
+    void* mMapping = nullptr;
+    size_t mMappingSize = 0;
+
+    const int16_t* mFtBiases = nullptr;
+    const int16_t* mFtWeights = nullptr;
+    const int32_t* mL1Biases = nullptr;
+    const int8_t* mL1Weights = nullptr;
+    const int32_t* mL2Biases = nullptr;
+    const int8_t* mL2Weights = nullptr;
+    const int32_t* mOutBias = nullptr;
+    const int8_t* mOutWeights = nullptr;
+};
+
+#endif //NNUE_H
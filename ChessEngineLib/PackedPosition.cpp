@@ -0,0 +1,106 @@
+/**
+ * @file PackedPosition.cpp
+ * @author John Korreck
+ */
+
+#include "PackedPosition.h"
+#include "Move.h"
+
+#include <algorithm>
+#include <bit>
+#include <sstream>
+
+static const char pieceLetters[] = " PNBRQKpnbrqk";
+
+bool PackFen(const std::string& fen, PackedPosition& packed) {
+    packed = PackedPosition();
+    std::istringstream ss(fen);
+    std::string boardPart;
+    std::string activeColor;
+    std::string castling = "-";
+    std::string enPassant = "-";
+    int halfMove = 0;
+    int fullMove = 1;
+    if (!(ss >> boardPart >> activeColor)) return false;
+    ss >> castling >> enPassant >> halfMove >> fullMove;
+
+    int squares[64] = {};
+    int rank = 0;
+    int file = 0;
+    for (char c : boardPart) {
+        if (c == '/') {
+            if (file != 8) return false;
+            rank++;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else {
+            const char* letter = std::char_traits<char>::find(pieceLetters + 1, 12, c);
+            if (!letter || rank > 7 || file > 7) return false;
+            int index = static_cast<int>(letter - pieceLetters);
+            squares[rank * 8 + file] = index <= 6 ? index : 6 - index;
+            file++;
+        }
+        if (file > 8) return false;
+    }
+    if (rank != 7 || file != 8) return false;
+    if (activeColor != "w" && activeColor != "b") return false;
+
+    int count = 0;
+    for (int square = 0; square < 64; square++) {
+        if (squares[square] == 0) continue;
+        if (count == 32) return false;
+        packed.occupied |= uint64_t{1} << square;
+        packed.pieces[count / 2] |= PackPiece(squares[square]) << (count % 2 * 4);
+        count++;
+    }
+
+    packed.flags = activeColor == "b";
+    const char rights[] = "KQkq";
+    for (int i = 0; i < 4; i++) {
+        if (castling.find(rights[i]) != std::string::npos) packed.flags |= 2 << i;
+    }
+    int square = ParseSquare(enPassant);
+    packed.enPassant = square < 0 ? 64 : square;
+    packed.halfMoveClock = std::clamp(halfMove, 0, 65535);
+    packed.fullMoveNumber = std::max(1, fullMove);
+    return true;
+}
+
+std::string UnpackFen(const PackedPosition& packed) {
+    int squares[64] = {};
+    uint64_t occupied = packed.occupied;
+    for (int i = 0; occupied && i < 32; i++, occupied &= occupied - 1) {
+        squares[std::countr_zero(occupied)] = UnpackPiece(packed.pieces[i / 2] >> (i % 2 * 4));
+    }
+
+    std::string fen;
+    fen.reserve(90);
+    for (int rank = 0; rank < 8; rank++) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            int piece = squares[rank * 8 + file];
+            if (piece == 0) {
+                empty++;
+                continue;
+            }
+            if (empty > 0) fen += static_cast<char>('0' + empty);
+            empty = 0;
+            fen += pieceLetters[piece > 0 ? piece : 6 - piece];
+        }
+        if (empty > 0) fen += static_cast<char>('0' + empty);
+        if (rank < 7) fen += '/';
+    }
+
+    fen += packed.flags & 1 ? " b " : " w ";
+    const char rights[] = "KQkq";
+    size_t length = fen.size();
+    for (int i = 0; i < 4; i++) {
+        if (packed.flags & 2 << i) fen += rights[i];
+    }
+    if (fen.size() == length) fen += '-';
+    fen += ' ';
+    fen += packed.enPassant < 64 ? SquareName(packed.enPassant) : "-";
+    fen += ' ' + std::to_string(packed.halfMoveClock) + ' ' + std::to_string(packed.fullMoveNumber);
+    return fen;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file PackedPosition.h
+ * @author John Korreck
+ *
+ * A position in a fixed 32 bytes, for storing and passing around where a FEN
+ * would be two to three times the size and slow to parse: an occupancy
+ * bitboard, a nibble per piece, and the side to move, castling, en passant and
+ * clocks. Board::Pack and Board::Unpack convert without going through text.
+ */
+
+#ifndef PACKEDPOSITION_H
+#define PACKEDPOSITION_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+struct PackedPosition {
+    uint64_t occupied = 0;       // bit = rank * 8 + file, rank 0 the eighth rank
+    uint8_t pieces[16] = {};     // a nibble per occupied square in bit order, low nibble first:
+                                 // 1-6 white pawn to king, 9-14 black
+    uint8_t flags = 0;           // 1 black to move; 2, 4, 8, 16 castling K, Q, k, q
+    uint8_t enPassant = 64;      // target square, 64 for none
+    uint16_t halfMoveClock = 0;
+    uint32_t fullMoveNumber = 1;
+
+    bool operator==(const PackedPosition&) const = default;
+};
+static_assert(sizeof(PackedPosition) == 32);
+
+/// Nibble for a piece (-6 to 6), and back; nibbles that aren't pieces unpack as empty
+inline uint8_t PackPiece(int piece) {
+    return std::abs(piece) | (piece < 0) << 3;
+}
+inline int UnpackPiece(uint8_t nibble) {
+    static constexpr int8_t pieces[16] = {0, 1, 2, 3, 4, 5, 6, 0, 0, -1, -2, -3, -4, -5, -6, 0};
+    return pieces[nibble & 15];
+}
+
+/// Without a Board; false if the FEN is malformed or has more than 32 pieces
+bool PackFen(const std::string& fen, PackedPosition& packed);
+std::string UnpackFen(const PackedPosition& packed);
+
+#endif //PACKEDPOSITION_H
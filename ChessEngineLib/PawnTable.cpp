@@ -0,0 +1,151 @@
+/**
+ * @file PawnTable.cpp
+ * @author John Korreck
+ */
+
+#include "PawnTable.h"
+#include "Board.h"
+
+#include <bit>
+
+namespace {
+
+// Indexed by rank relative to the pawn's own side (1 = starting rank)
+const int passedMg[8] = {0, 5, 10, 15, 30, 50, 80, 0};
+const int passedEg[8] = {0, 10, 20, 35, 60, 100, 150, 0};
+
+const int doubledMg = -10, doubledEg = -20;
+const int isolatedMg = -10, isolatedEg = -15;
+const int backwardMg = -8, backwardEg = -10;
+
+uint64_t FileMask(int file) {
+    if (file < 0 || file > 7) return 0;
+    return 0x0101010101010101ULL << file;
+}
+
+// Ranks strictly in front of the given rank from the side's point of view
+uint64_t RanksAhead(int side, int rank) {
+    uint64_t mask = 0;
+    for (int r = 0; r < 8; r++) {
+        if (side == 0 ? r < rank : r > rank) mask |= 0xFFULL << (r * 8);
+    }
+    return mask;
+}
+
+bool HasPawn(uint64_t pawns, int rank, int file) {
+    if (rank < 0 || rank > 7 || file < 0 || file > 7) return false;
+    return pawns & (1ULL << (rank * 8 + file));
+}
+
+} // namespace
+
+PawnTable::PawnTable(size_t entries) : mSize(std::bit_ceil(entries)) {
+}
+
+void PawnTable::Clear() {
+    mEntries.clear();
+    mProbes = 0;
+    mHits = 0;
+}
+
+PawnEntry& PawnTable::Probe(Board& board) {
+    // Allocated on first use so boards that never search don't pay for it
+    if (mEntries.empty()) {
+        mEntries.resize(mSize);
+    }
+
+    uint64_t key = board.GetPawnKey();
+    PawnEntry& entry = mEntries[key & (mSize - 1)];
+    mProbes++;
+    if (entry.key == key) {
+        mHits++;
+        return entry;
+    }
+
+    entry = PawnEntry();
+    entry.key = key;
+    auto& squares = board.GetBoard();
+    for (int rank = 0; rank < 8; rank++) {
+        for (int file = 0; file < 8; file++) {
+            if (squares[rank][file] == 1) entry.pawns[0] |= 1ULL << (rank * 8 + file);
+            if (squares[rank][file] == -1) entry.pawns[1] |= 1ULL << (rank * 8 + file);
+        }
+    }
+    EvaluatePawns(entry);
+    return entry;
+}
+
+void PawnTable::EvaluatePawns(PawnEntry& entry) {
+    for (int side = 0; side < 2; side++) {
+        uint64_t own = entry.pawns[side];
+        uint64_t enemy = entry.pawns[side ^ 1];
+        int forward = side == 0 ? -1 : 1;
+        int mg = 0;
+        int eg = 0;
+
+        for (uint64_t pawns = own; pawns; pawns &= pawns - 1) {
+            int square = std::countr_zero(pawns);
+            int rank = square / 8;
+            int file = square % 8;
+            int relativeRank = side == 0 ? 7 - rank : rank;
+
+            uint64_t ahead = RanksAhead(side, rank);
+            uint64_t adjacentFiles = FileMask(file - 1) | FileMask(file + 1);
+            bool isolated = !(own & adjacentFiles);
+
+            if (own & FileMask(file) & ahead) {
+                mg += doubledMg;
+                eg += doubledEg;
+            }
+
+            if (isolated) {
+                mg += isolatedMg;
+                eg += isolatedEg;
+            }
+
+            // Passed: no enemy pawn in front on this or an adjacent file (the rearmost doubled pawn isn't)
+            if (!(enemy & (FileMask(file) | adjacentFiles) & ahead) && !(own & FileMask(file) & ahead)) {
+                entry.passed[side] |= 1ULL << square;
+                mg += passedMg[relativeRank];
+                eg += passedEg[relativeRank];
+            }
+
+            // Backward: no friendly pawn level or behind on adjacent files, and the stop square is guarded
+            if (!isolated && !(own & adjacentFiles & ~ahead)) {
+                int stopRank = rank + forward;
+                if (HasPawn(enemy, stopRank + forward, file - 1) || HasPawn(enemy, stopRank + forward, file + 1)) {
+                    mg += backwardMg;
+                    eg += backwardEg;
+                }
+            }
+        }
+
+        entry.mg[side] = static_cast<int16_t>(mg);
+        entry.eg[side] = static_cast<int16_t>(eg);
+    }
+}
+
+int PawnTable::Shelter(PawnEntry& entry, int side, int kingSquare) {
+    if (entry.shelterSquare[side] == kingSquare) {
+        return entry.shelter[side];
+    }
+
+    int kingRank = kingSquare / 8;
+    int kingFile = kingSquare % 8;
+    int forward = side == 0 ? -1 : 1;
+    int shelter = 0;
+    for (int file = kingFile - 1; file <= kingFile + 1; file++) {
+        if (file < 0 || file > 7) continue;
+        if (HasPawn(entry.pawns[side], kingRank + forward, file)) {
+            shelter += 12;
+        } else if (HasPawn(entry.pawns[side], kingRank + 2 * forward, file)) {
+            shelter += 6;
+        } else {
+            shelter -= 10;
+        }
+    }
+
+    entry.shelterSquare[side] = static_cast<int8_t>(kingSquare);
+    entry.shelter[side] = static_cast<int16_t>(shelter);
+    return shelter;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file PawnTable.h
+ * @author John Korreck
+ *
+ * Pawn-structure evaluation cached by pawn-only Zobrist key.
+ */
+
+#ifndef PAWNTABLE_H
+#define PAWNTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Board;
+
+/// Cached pawn-structure terms. Index 0 is white, 1 is black.
+struct PawnEntry {
+    uint64_t key = 0;
+    int16_t mg[2] = {0, 0};
+    int16_t eg[2] = {0, 0};
+    uint64_t passed[2] = {0, 0}; // passed pawns, bit = rank * 8 + file
+    uint64_t pawns[2] = {0, 0};
+
+    // King shelter depends on the king square as well, so it is cached lazily
+    int8_t shelterSquare[2] = {-1, -1};
+    int16_t shelter[2] = {0, 0};
+};
+
+class PawnTable {
+public:
+    explicit PawnTable(size_t entries = 16384);
+
+    /// Entry for the board's pawn structure, evaluated on a miss
+    PawnEntry& Probe(Board& board);
+
+    /// Midgame king shelter for the given side, cached in the entry
+    static int Shelter(PawnEntry& entry, int side, int kingSquare);
+
+    void Clear();
+    uint64_t Probes() const { return mProbes; }
+    uint64_t Hits() const { return mHits; }
+
+    static void EvaluatePawns(PawnEntry& entry);
+
+private:
+    std::vector<PawnEntry> mEntries;
+    size_t mSize;
+    uint64_t mProbes = 0;
+    uint64_t mHits = 0;
+};
+
+#endif //PAWNTABLE_H
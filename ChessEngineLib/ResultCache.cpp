@@ -0,0 +1,42 @@
+/**
+ * @file ResultCache.cpp
+ * @author John Korreck
+ */
+
+#include "ResultCache.h"
+
+#include <algorithm>
+#include <bit>
+
+ResultCache::ResultCache(size_t entries)
+    : mEntries(std::bit_floor(entries ? entries : 1)) {
+}
+
+bool ResultCache::Probe(uint64_t key, int depth, int64_t budgetMs, CachedResult& result) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    const CachedResult& entry = mEntries[key & (mEntries.size() - 1)];
+    if (entry.key != key || entry.move == 0) return false;
+
+    // Deep enough, or given at least as much time as this request
+    bool deepEnough = entry.depth >= depth;
+    bool longEnough = budgetMs > 0 && entry.budgetMs >= budgetMs;
+    if (!deepEnough && !longEnough) return false;
+
+    result = entry;
+    return true;
+}
+
+void ResultCache::Store(const CachedResult& result) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries[result.key & (mEntries.size() - 1)] = result;
+}
+
+void ResultCache::Clear() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::fill(mEntries.begin(), mEntries.end(), CachedResult());
+}
+
+std::vector<CachedResult> ResultCache::Entries() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file ResultCache.h
+ * @author John Korreck
+ *
+ * Finished search results by position, so a repeated request is answered
+ * without searching again. Safe to share between threads.
+ */
+
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+struct CachedResult {
+    uint64_t key = 0;
+    int32_t score = 0;      // side to move's point of view
+    uint32_t budgetMs = 0;  // time budget of the search, 0 if it was only depth-limited
+    uint16_t move = 0;
+    int16_t depth = 0;      // deepest completed iteration
+    uint32_t reserved = 0;
+};
+
+class ResultCache {
+public:
+    explicit ResultCache(size_t entries = 4096);
+
+    /// A result at least as good as a search with this depth and budget would produce
+    bool Probe(uint64_t key, int depth, int64_t budgetMs, CachedResult& result) const;
+    void Store(const CachedResult& result);
+    void Clear();
+
+    size_t Size() const { return mEntries.size(); }
+    /// Copy of every entry, for snapshots
+    std::vector<CachedResult> Entries() const;
+
+private:
+    std::vector<CachedResult> mEntries;
+    mutable std::mutex mMutex;
+};
+
+#endif //RESULTCACHE_H
@@ -0,0 +1,398 @@
+/**
+ * @file SearchScheduler.cpp
+ * @author John Korreck
+ */
+
+#include "SearchScheduler.h"
+#include "Board.h"
+
+#include <algorithm>
+
+#include <ucontext.h>
+
+struct SearchJob::Fiber {
+    ucontext_t context;
+    ucontext_t* worker = nullptr;  // where to return to on the thread running it now
+    SearchScheduler* scheduler = nullptr;
+    std::unique_ptr<char[]> stack;
+    std::unique_ptr<Engine> engine;
+    Clock::time_point sliceStart;
+    Clock::duration runTime{};     // spent on a thread so far
+    bool finished = false;
+};
+
+SearchJob::SearchJob(std::unique_ptr<Board> board, const SearchLimits& limits, int priority,
+                     const LimitDecision& decision, bool streaming)
+    : mBoard(std::move(board)), mLimits(limits), mPriority(priority), mDeadline(Clock::time_point::max()),
+      mSubmitted(Clock::now()), mDecision(decision), mStreaming(streaming) {
+    if (limits.moveTimeMs > 0) {
+        mDeadline = Clock::now() + std::chrono::milliseconds(limits.moveTimeMs);
+    }
+    mResult = mPromise.get_future().share();
+}
+
+SearchJob::SearchJob(std::shared_ptr<SearchJob> search)
+    : mLimits(search->mLimits), mPriority(search->mPriority), mDeadline(search->mDeadline),
+      mSubmitted(Clock::now()), mDecision(search->mDecision), mSearch(std::move(search)),
+      mResult(mSearch->mResult), mStreaming(false) {
+}
+
+SearchJob::~SearchJob() = default;
+
+void SearchJob::Cancel() {
+    // A client that goes away may cancel repeatedly; it still counts once
+    if (mHandleCancelled.exchange(true, std::memory_order_relaxed)) return;
+    SearchJob& search = mSearch ? *mSearch : *this;
+    if (search.mSubmitters.fetch_sub(1, std::memory_order_relaxed) <= 1) {
+        search.mCancelled.store(true, std::memory_order_relaxed);
+    }
+}
+
+bool SearchJob::Join() {
+    // Never back up from zero: by then the search is being stopped
+    int submitters = mSubmitters.load(std::memory_order_relaxed);
+    while (submitters > 0) {
+        if (mSubmitters.compare_exchange_weak(submitters, submitters + 1, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<SearchResult> SearchJob::TakeIterations(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mIterationsMutex);
+    mIterationsChanged.wait_for(lock, timeout, [this] { return !mIterations.empty() || mFinished; });
+    return std::exchange(mIterations, {});
+}
+
+bool SearchJob::IsDone() const {
+    return mResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+SearchScheduler::SearchScheduler(int threads, size_t hashMegabytes)
+    : mTable(std::make_shared<TranspositionTable>(hashMegabytes)),
+      mResults(std::make_shared<ResultCache>()) {
+    mTable->Allocate();
+    mPrimary.ShareTables(mTable, mResults);
+
+    for (int i = 0; i < std::max(1, threads); i++) {
+        mWorkers.emplace_back(&SearchScheduler::WorkerLoop, this);
+    }
+}
+
+SearchScheduler::~SearchScheduler() {
+    // Queued and running searches finish early with what they have
+    mStopping.store(true, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mShuttingDown = true;
+    }
+    mReadyChanged.notify_all();
+    for (std::thread& worker : mWorkers) {
+        worker.join();
+    }
+}
+
+bool SearchScheduler::MoreUrgent(const SearchJob& a, const SearchJob& b) {
+    if (a.mPriority != b.mPriority) return a.mPriority > b.mPriority;
+    return a.mDeadline < b.mDeadline;
+}
+
+// Heap order: equally urgent jobs run in queue order
+bool SearchScheduler::RunsAfter(const std::shared_ptr<SearchJob>& a, const std::shared_ptr<SearchJob>& b) {
+    return MoreUrgent(*b, *a) || (!MoreUrgent(*a, *b) && a->mSequence > b->mSequence);
+}
+
+// Whether the running search answers the request at least as well and no later than it needs
+bool SearchScheduler::Covers(const SearchJob& running, const SearchJob& request) {
+    const SearchLimits& have = running.mLimits;
+    const SearchLimits& want = request.mLimits;
+    if (request.mStreaming) return false;
+    if (have.depth < want.depth || have.multiPv != want.multiPv || running.mPriority < request.mPriority) {
+        return false;
+    }
+    if (have.nodes != 0 && (want.nodes == 0 || have.nodes < want.nodes)) return false;
+    if (want.moveTimeMs == 0) return have.moveTimeMs == 0;
+    return have.moveTimeMs >= want.moveTimeMs && running.mDeadline <= request.mDeadline;
+}
+
+std::shared_ptr<SearchJob> SearchScheduler::Submit(const std::string& fen, const SearchLimits& limits,
+                                                   int priority, const LimitDecision& decision, bool streaming) {
+    std::string name = "Search";
+    std::string position = fen;
+    return Enqueue(std::shared_ptr<SearchJob>(new SearchJob(std::make_unique<Board>(name, position), limits,
+                                                            priority, decision, streaming)));
+}
+
+std::shared_ptr<SearchJob> SearchScheduler::Submit(const Board& board, const SearchLimits& limits, int priority,
+                                                   const LimitDecision& decision, bool streaming) {
+    return Enqueue(std::shared_ptr<SearchJob>(new SearchJob(std::make_unique<Board>(board), limits, priority,
+                                                            decision, streaming)));
+}
+
+bool SearchScheduler::Plan(SearchLimits& limits, LimitDecision& decision) {
+    if (!mController.Decide(Competing(), Threads(), decision)) return false;
+    limits.moveTimeMs = decision.moveTimeMs;
+    limits.nodes = decision.nodes;
+    return true;
+}
+
+std::shared_ptr<SearchJob> SearchScheduler::Enqueue(std::shared_ptr<SearchJob> job) {
+    uint64_t key = job->mBoard->GetKey();
+    bool shareable = Engine::ScoresPositionAlone(*job->mBoard, job->mLimits.depth);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (shareable) {
+            auto [first, last] = mInFlight.equal_range(key);
+            for (auto it = first; it != last; ++it) {
+                SearchJob& running = *it->second;
+                if (Covers(running, *job) && running.Join()) {
+                    mCoalesced++;
+                    return std::shared_ptr<SearchJob>(new SearchJob(running.shared_from_this()));
+                }
+            }
+            mInFlight.emplace(key, job.get());
+        }
+        job->mSequence = mNextSequence++;
+        mPending++;
+        if (job->mPriority >= 0) mCompeting++;
+        mReady.push_back(job);
+        std::push_heap(mReady.begin(), mReady.end(), RunsAfter);
+        mReadyCount.store(mReady.size(), std::memory_order_relaxed);
+    }
+    mReadyChanged.notify_one();
+    return job;
+}
+
+void SearchScheduler::Promote(const std::shared_ptr<SearchJob>& job, const SearchLimits& limits, int priority,
+                              const LimitDecision& decision) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!job->mRetired && (job->mPriority >= 0) != (priority >= 0)) {
+        priority >= 0 ? mCompeting++ : mCompeting--;
+    }
+    job->mPriority = priority;
+    job->mDecision = decision;
+    job->mSubmitted = SearchJob::Clock::now();
+    job->mDeadline = limits.moveTimeMs > 0 ? SearchJob::Clock::now() + std::chrono::milliseconds(limits.moveTimeMs)
+                                           : SearchJob::Clock::time_point::max();
+    job->mRetarget = limits;
+    job->mRetargeted.store(true, std::memory_order_relaxed);
+
+    // It may be waiting in the queue under its old urgency
+    std::make_heap(mReady.begin(), mReady.end(), RunsAfter);
+}
+
+size_t SearchScheduler::Pending() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPending;
+}
+
+size_t SearchScheduler::Competing() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mCompeting;
+}
+
+uint64_t SearchScheduler::Coalesced() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mCoalesced;
+}
+
+bool SearchScheduler::SetOption(const std::string& name, const std::string& value) {
+    // A trace follows one search; pooled engines would interleave theirs in one file
+    if (name == "TraceFile") return false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    bool accepted = mPrimary.SetOption(name, value);
+
+    // Table options act on the shared table through the primary engine
+    if (name == "Hash" || name == "SharedHash" || name == "HugePages") {
+        mTable->Allocate();
+        return accepted;
+    }
+    if (accepted) {
+        for (auto& engine : mIdleEngines) {
+            engine->SetOption(name, value);
+        }
+        mOptions.emplace_back(name, value);
+    }
+    return accepted;
+}
+
+bool SearchScheduler::SaveSnapshot(const std::string& path) const {
+    return mPrimary.SaveSnapshot(path);
+}
+
+bool SearchScheduler::LoadSnapshot(const std::string& path) {
+    return mPrimary.LoadSnapshot(path);
+}
+
+void SearchScheduler::WorkerLoop() {
+    ucontext_t home;
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mReadyChanged.wait(lock, [this] { return !mReady.empty() || (mShuttingDown && mPending == 0); });
+        if (mReady.empty()) break;
+
+        std::pop_heap(mReady.begin(), mReady.end(), RunsAfter);
+        std::shared_ptr<SearchJob> job = std::move(mReady.back());
+        mReady.pop_back();
+        mReadyCount.store(mReady.size(), std::memory_order_relaxed);
+        lock.unlock();
+
+        if (!job->mFiber) {
+            StartFiber(*job);
+        }
+        SearchJob::Fiber& fiber = *job->mFiber;
+        fiber.worker = &home;
+        fiber.sliceStart = SearchJob::Clock::now();
+        swapcontext(&home, &fiber.context);
+        fiber.runTime += SearchJob::Clock::now() - fiber.sliceStart;
+
+        // Back here when the search yields or finishes
+        if (fiber.finished) {
+            FinishFiber(*job);
+            lock.lock();
+            continue;
+        }
+
+        // Requeued behind equally urgent jobs, so they get a turn
+        lock.lock();
+        job->mSequence = mNextSequence++;
+        mReady.push_back(std::move(job));
+        std::push_heap(mReady.begin(), mReady.end(), RunsAfter);
+        mReadyCount.store(mReady.size(), std::memory_order_relaxed);
+    }
+}
+
+void SearchScheduler::StartFiber(SearchJob& job) {
+    auto fiber = std::make_unique<SearchJob::Fiber>();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mIdleEngines.empty()) {
+            fiber->engine = std::move(mIdleEngines.back());
+            mIdleEngines.pop_back();
+        }
+        if (!mIdleStacks.empty()) {
+            fiber->stack = std::move(mIdleStacks.back());
+            mIdleStacks.pop_back();
+        }
+    }
+    if (!fiber->engine) {
+        fiber->engine = std::make_unique<Engine>();
+        fiber->engine->ShareTables(mTable, mResults);
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const auto& [name, value] : mOptions) {
+            fiber->engine->SetOption(name, value);
+        }
+    }
+    if (!fiber->stack) {
+        fiber->stack.reset(new char[StackBytes]);
+    }
+    fiber->engine->SetYieldHook([this, &job] { Yield(job); });
+    if (job.mStreaming) {
+        fiber->engine->SetIterationHook([&job](const SearchResult& result) {
+            std::lock_guard<std::mutex> lock(job.mIterationsMutex);
+            job.mIterations.push_back(result);
+            job.mIterations.back().decision = job.mDecision;
+            job.mIterationsChanged.notify_all();
+        });
+    }
+    fiber->scheduler = this;
+
+    getcontext(&fiber->context);
+    fiber->context.uc_stack.ss_sp = fiber->stack.get();
+    fiber->context.uc_stack.ss_size = StackBytes;
+    fiber->context.uc_link = nullptr;
+
+    // makecontext only passes ints, so the job pointer goes in two halves
+    auto address = reinterpret_cast<uintptr_t>(&job);
+    makecontext(&fiber->context, reinterpret_cast<void (*)()>(&SearchScheduler::RunFiber), 2,
+                static_cast<unsigned int>(uint64_t(address) >> 32), static_cast<unsigned int>(address));
+    job.mFiber = std::move(fiber);
+}
+
+void SearchScheduler::FinishFiber(SearchJob& job) {
+    std::unique_ptr<SearchJob::Fiber> fiber = std::move(job.mFiber);
+    fiber->engine->SetYieldHook(nullptr);
+    fiber->engine->SetIterationHook(nullptr);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mIdleEngines.push_back(std::move(fiber->engine));
+    mIdleStacks.push_back(std::move(fiber->stack));
+}
+
+void SearchScheduler::RunFiber(unsigned int high, unsigned int low) {
+    auto* job = reinterpret_cast<SearchJob*>(uintptr_t(uint64_t(high) << 32 | low));
+    SearchJob::Fiber& fiber = *job->mFiber;
+    {
+        SearchResult result = fiber.engine->Search(*job->mBoard, job->mLimits);
+        SearchScheduler& scheduler = *fiber.scheduler;
+        SearchJob::Clock::time_point submitted;
+        {
+            // Promote may have changed these while it ran
+            std::lock_guard<std::mutex> lock(scheduler.mMutex);
+            result.decision = job->mDecision;
+            submitted = job->mSubmitted;
+        }
+
+        // Latency from submission, and speed per thread while it was running
+        auto now = SearchJob::Clock::now();
+        auto runTime = fiber.runTime + (now - fiber.sliceStart);
+        auto toMs = [](SearchJob::Clock::duration d) {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+        };
+        scheduler.mController.Record(toMs(now - submitted), result.decision.adaptive, result.nodes,
+                                     toMs(runTime));
+
+        // No longer pending by the time anyone sees the result
+        {
+            std::lock_guard<std::mutex> lock(scheduler.mMutex);
+            auto [first, last] = scheduler.mInFlight.equal_range(job->mBoard->GetKey());
+            for (auto it = first; it != last; ++it) {
+                if (it->second == job) {
+                    scheduler.mInFlight.erase(it);
+                    break;
+                }
+            }
+            job->mRetired = true;
+            if (job->mPriority >= 0) scheduler.mCompeting--;
+            if (--scheduler.mPending == 0 && scheduler.mShuttingDown) scheduler.mReadyChanged.notify_all();
+        }
+        {
+            std::lock_guard<std::mutex> lock(job->mIterationsMutex);
+            job->mFinished = true;
+        }
+        job->mIterationsChanged.notify_all();
+        job->mPromise.set_value(std::move(result));
+    }
+    fiber.finished = true;
+
+    // Nothing on this stack outlives the switch; the worker recycles it
+    setcontext(fiber.worker);
+}
+
+// Runs on the search's own stack at every engine poll
+void SearchScheduler::Yield(SearchJob& job) {
+    SearchJob::Fiber& fiber = *job.mFiber;
+    if (job.mCancelled.load(std::memory_order_relaxed) || mStopping.load(std::memory_order_relaxed)) {
+        fiber.engine->Stop();
+    }
+    if (job.mRetargeted.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        fiber.engine->Retarget(job.mRetarget);
+        job.mRetargeted.store(false, std::memory_order_relaxed);
+    }
+    if (mReadyCount.load(std::memory_order_relaxed) == 0) return;
+
+    bool sliceOver = SearchJob::Clock::now() - fiber.sliceStart >= TimeSlice;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mReady.empty()) return;
+        const SearchJob& next = *mReady.front();
+        if (!MoreUrgent(next, job) && !(sliceOver && !MoreUrgent(job, next))) return;
+    }
+
+    // The worker requeues this job; whichever worker picks it up next resumes it here
+    swapcontext(&fiber.context, fiber.worker);
+}
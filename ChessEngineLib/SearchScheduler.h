@@ -0,0 +1,186 @@
+/**
+ * @file SearchScheduler.h
+ * @author John Korreck
+ *
+ * Runs many searches on a small fixed pool of threads. Each search runs on its
+ * own stack and yields at the engine's node polls; the scheduler then resumes
+ * whichever waiting search is most urgent (highest priority, then earliest
+ * deadline), so short requests don't queue behind deep ones. Searches of equal
+ * urgency take turns a time slice at a time.
+ *
+ * Requests for a position already being searched at least as hard share the
+ * running search instead of starting another. Callers can let the scheduler's
+ * load controller choose limits, keeping latency inside a target under load.
+ * A streamed search also keeps each completed iteration for the caller to take
+ * while it runs.
+ */
+
+#ifndef SEARCHSCHEDULER_H
+#define SEARCHSCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Engine.h"
+#include "LoadController.h"
+
+class Board;
+
+/// Handle to a submitted search; shared between the caller and the scheduler. A request that
+/// joins a search already in flight gets a handle of its own onto that search.
+class SearchJob : public std::enable_shared_from_this<SearchJob> {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    ~SearchJob();
+    SearchJob(const SearchJob&) = delete;
+    SearchJob& operator=(const SearchJob&) = delete;
+
+    bool IsDone() const;
+    void Wait() const { mResult.wait(); }
+    /// Blocks until the search finishes
+    const SearchResult& Result() const { return mResult.get(); }
+    /// Finish early with the best move found so far, once every submitter sharing the search has
+    /// cancelled. Cancelling a handle again does nothing.
+    void Cancel();
+    /// Iterations completed since the last call, for a search submitted with streaming on.
+    /// Waits up to `timeout` for one unless the search is done; empty on timeout or once done.
+    std::vector<SearchResult> TakeIterations(std::chrono::milliseconds timeout);
+
+    /// Whether the two handles follow the same search
+    bool SharesSearchWith(const SearchJob& other) const {
+        return (mSearch ? mSearch.get() : this) == (other.mSearch ? other.mSearch.get() : &other);
+    }
+
+    int Priority() const { return mPriority; }
+    Clock::time_point Deadline() const { return mDeadline; }
+
+private:
+    friend class SearchScheduler;
+    struct Fiber;
+
+    SearchJob(std::unique_ptr<Board> board, const SearchLimits& limits, int priority,
+              const LimitDecision& decision, bool streaming);
+    /// Another submitter's handle onto a search in flight
+    explicit SearchJob(std::shared_ptr<SearchJob> search);
+    /// Count one more submitter, unless the last one has already cancelled
+    bool Join();
+
+    std::unique_ptr<Board> mBoard;
+    SearchLimits mLimits;
+    int mPriority;
+    Clock::time_point mDeadline;  // time_point::max() without a time limit
+    uint64_t mSequence = 0;       // queue order among equally urgent jobs
+    Clock::time_point mSubmitted;
+    LimitDecision mDecision;
+    std::atomic<bool> mCancelled{false};
+    std::atomic<int> mSubmitters{1};
+    std::atomic<bool> mHandleCancelled{false};  // this handle's submitter has cancelled
+    std::shared_ptr<SearchJob> mSearch;         // the search a joining handle shares, else null
+    SearchLimits mRetarget;              // set by Promote, applied by the search at its next yield
+    std::atomic<bool> mRetargeted{false};
+    bool mRetired = false;               // no longer pending; guarded by the scheduler's lock
+    std::promise<SearchResult> mPromise;
+    std::shared_future<SearchResult> mResult;
+
+    // Completed iterations not yet taken, when streaming
+    bool mStreaming;
+    std::mutex mIterationsMutex;
+    std::condition_variable mIterationsChanged;
+    std::vector<SearchResult> mIterations;
+    bool mFinished = false;
+
+    // Stack, engine and saved registers while the search is in flight
+    std::unique_ptr<Fiber> mFiber;
+};
+
+class SearchScheduler {
+public:
+    /// Slice after which a search gives way to an equally urgent one
+    static constexpr std::chrono::milliseconds TimeSlice{10};
+    static constexpr size_t StackBytes = 1 << 20;
+
+    explicit SearchScheduler(int threads = 1, size_t hashMegabytes = 16);
+    ~SearchScheduler();
+    SearchScheduler(const SearchScheduler&) = delete;
+    SearchScheduler& operator=(const SearchScheduler&) = delete;
+
+    /// Queue a search; a higher priority runs first, then the earliest deadline. A search
+    /// already in flight for the position that is at least as deep and finishes in time is
+    /// returned instead, unless streaming, since its earlier iterations have gone.
+    std::shared_ptr<SearchJob> Submit(const std::string& fen, const SearchLimits& limits, int priority = 0,
+                                      const LimitDecision& decision = LimitDecision(), bool streaming = false);
+    /// Search a copy of the board. Its move history makes it distinct, so it is never coalesced.
+    std::shared_ptr<SearchJob> Submit(const Board& board, const SearchLimits& limits, int priority = 0,
+                                      const LimitDecision& decision = LimitDecision(), bool streaming = false);
+
+    /// Set the time and node budgets of limits for the current load; false when the request
+    /// should be turned away. Pass the decision on to Submit so it shows in the result.
+    bool Plan(SearchLimits& limits, LimitDecision& decision);
+    LoadController& Controller() { return mController; }
+
+    /// Give a queued or running search new limits and priority, e.g. to turn a ponder into the
+    /// real search. Time it has already spent counts against the new budget; the decision and
+    /// latency reported are the new request's.
+    void Promote(const std::shared_ptr<SearchJob>& job, const SearchLimits& limits, int priority,
+                 const LimitDecision& decision = LimitDecision());
+
+    /// Engine options for every search. Set them before submitting work.
+    bool SetOption(const std::string& name, const std::string& value);
+    bool SaveSnapshot(const std::string& path) const;
+    bool LoadSnapshot(const std::string& path);
+
+    int Threads() const { return static_cast<int>(mWorkers.size()); }
+    /// Searches queued or in flight
+    size_t Pending() const;
+    /// Pending searches at normal priority or above: what a new request shares the threads
+    /// with, since a ponder only runs when nothing more urgent is waiting
+    size_t Competing() const;
+    /// Requests answered by attaching to a search already in flight
+    uint64_t Coalesced() const;
+
+private:
+    // Tables shared by every engine, and the engine that validates options
+    std::shared_ptr<TranspositionTable> mTable;
+    std::shared_ptr<ResultCache> mResults;
+    Engine mPrimary;
+    std::vector<std::pair<std::string, std::string>> mOptions;
+    LoadController mController;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mReadyChanged;
+    std::vector<std::shared_ptr<SearchJob>> mReady; // heap, most urgent first
+    std::atomic<size_t> mReadyCount{0};             // mReady.size(), read without the lock
+    std::vector<std::unique_ptr<Engine>> mIdleEngines;
+    std::vector<std::unique_ptr<char[]>> mIdleStacks;
+    size_t mPending = 0;
+    size_t mCompeting = 0;
+    std::unordered_multimap<uint64_t, SearchJob*> mInFlight; // by position key, until finished
+    uint64_t mCoalesced = 0;
+    uint64_t mNextSequence = 0;
+    bool mShuttingDown = false;
+    std::atomic<bool> mStopping{false};
+    std::vector<std::thread> mWorkers;
+
+    void WorkerLoop();
+    void StartFiber(SearchJob& job);
+    void FinishFiber(SearchJob& job);
+    void Yield(SearchJob& job);
+    static void RunFiber(unsigned int high, unsigned int low);
+    static bool MoreUrgent(const SearchJob& a, const SearchJob& b);
+    static bool Covers(const SearchJob& running, const SearchJob& request);
+    std::shared_ptr<SearchJob> Enqueue(std::shared_ptr<SearchJob> job);
+    static bool RunsAfter(const std::shared_ptr<SearchJob>& a, const std::shared_ptr<SearchJob>& b);
+};
+
+#endif //SEARCHSCHEDULER_H
@@ -0,0 +1,49 @@
+/**
+ * @file SearchTrace.cpp
+ * @author John Korreck
+ */
+
+#include "SearchTrace.h"
+
+#include <cstring>
+
+static const char traceMagic[8] = {'C', 'E', 'T', 'R', 'A', 'C', 'E', '1'};
+static const uint32_t traceVersion = 1;
+
+SearchTrace::~SearchTrace() {
+    if (!mFile) return;
+    Flush();
+    std::fclose(mFile);
+}
+
+bool SearchTrace::Open(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    TraceHeader header {};
+    std::memcpy(header.magic, traceMagic, sizeof(traceMagic));
+    header.version = traceVersion;
+    header.recordBytes = sizeof(TraceRecord);
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        std::fclose(file);
+        return false;
+    }
+
+    if (mFile) {
+        Flush();
+        std::fclose(mFile);
+    }
+    mFile = file;
+    mBuffer = std::make_unique<TraceRecord[]>(BufferRecords);
+    mCount = 0;
+    mWritten = 0;
+    return true;
+}
+
+void SearchTrace::Flush() {
+    if (!mFile || mCount == 0) return;
+    std::fwrite(mBuffer.get(), sizeof(TraceRecord), mCount, mFile);
+    std::fflush(mFile);
+    mWritten += mCount;
+    mCount = 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file SearchTrace.h
+ * @author John Korreck
+ *
+ * Opt-in record of every node a search visits, for finding out where the nodes
+ * of a slow search went. Each node becomes one fixed-size record, written when
+ * the search leaves it, so a node's record follows those of its children and
+ * an iteration ends with a Root record. tracesummary.py reads the file back.
+ */
+
+#ifndef SEARCHTRACE_H
+#define SEARCHTRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+enum class TraceKind : uint8_t {
+    Searched,    // moves searched; cutoff says which one failed high, if any
+    TableHit,    // answered by the transposition table
+    Draw,        // repetition or the fifty-move rule
+    Terminal,    // checkmate or stalemate
+    Quiescence,  // depth 0, handed to quiescence; nodes counts its captures
+    SeePruned,   // quiet move skipped for losing material, never searched
+    Root,        // end of a completed iteration; its children are the root moves
+};
+
+// TraceRecord::flags
+constexpr uint8_t TraceMaximizing = 1;  // white to move
+constexpr uint8_t TraceInCheck = 2;
+
+struct TraceRecord {
+    int32_t alpha;       // window on entry, from white's point of view like the result
+    int32_t beta;
+    int32_t result;
+    uint32_t nodes;      // in the subtree, this node included
+    uint16_t move;       // Move::Raw() of the move into this node
+    uint8_t moves;       // moves searched
+    uint8_t cutoff;      // position in the move order of the move that failed high, 0 if none
+    uint8_t ply;
+    int8_t depth;
+    TraceKind kind;
+    uint8_t flags;
+};
+static_assert(sizeof(TraceRecord) == 24);
+
+/// File header; records follow until the end of the file
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordBytes;
+};
+static_assert(sizeof(TraceHeader) == 16);
+
+/// Buffers records and appends them to a file a block at a time
+class SearchTrace {
+public:
+    static constexpr size_t BufferRecords = 1 << 14;
+
+    SearchTrace() = default;
+    ~SearchTrace();
+    SearchTrace(const SearchTrace&) = delete;
+    SearchTrace& operator=(const SearchTrace&) = delete;
+
+    /// Start a new trace file, replacing any at the path
+    bool Open(const std::string& path);
+    void Write(const TraceRecord& record) {
+        mBuffer[mCount++] = record;
+        if (mCount == BufferRecords) Flush();
+    }
+    void Flush();
+
+    /// Records written so far, buffered ones included
+    uint64_t Records() const { return mWritten + mCount; }
+
+private:
+    std::FILE* mFile = nullptr;
+    std::unique_ptr<TraceRecord[]> mBuffer;
+    size_t mCount = 0;
+    uint64_t mWritten = 0;
+};
+
+#endif //SEARCHTRACE_H
@@ -0,0 +1,122 @@
+/**
+ * @file Snapshot.cpp
+ * @author John Korreck
+ */
+
+#include "Snapshot.h"
+#include "ResultCache.h"
+#include "TranspositionTable.h"
+
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char snapshotMagic[8] = {'C', 'E', 'S', 'N', 'A', 'P', 'v', '1'};
+const uint32_t snapshotVersion = 1;
+
+// Word-at-a-time hash; fast enough to check a large table at startup
+uint64_t Checksum(const uint8_t* bytes, size_t size, uint64_t hash = 0xCBF29CE484222325ULL) {
+    size_t words = size / 8;
+    for (size_t i = 0; i < words; i++) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i * 8, 8);
+        hash = std::rotl(hash ^ word, 29) * 0x9E3779B97F4A7C15ULL;
+    }
+    for (size_t i = words * 8; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+bool SaveSnapshot(const std::string& path, const TranspositionTable& table, const ResultCache& results) {
+    std::vector<uint64_t> slots(table.Size() * 2);
+    table.ExportSlots(slots.data());
+    std::vector<CachedResult> entries = results.Entries();
+
+    auto* slotBytes = reinterpret_cast<const uint8_t*>(slots.data());
+    auto* resultBytes = reinterpret_cast<const uint8_t*>(entries.data());
+    size_t slotSize = slots.size() * sizeof(uint64_t);
+    size_t resultSize = entries.size() * sizeof(CachedResult);
+
+    SnapshotHeader header {};
+    std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.version = snapshotVersion;
+    header.headerBytes = sizeof(SnapshotHeader);
+    header.ttSlots = table.Size();
+    header.resultEntries = entries.size();
+    header.resultBytes = sizeof(CachedResult);
+    header.checksum = Checksum(resultBytes, resultSize, Checksum(slotBytes, slotSize));
+
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(slotBytes), slotSize);
+        file.write(reinterpret_cast<const char*>(resultBytes), resultSize);
+        if (!file) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool LoadSnapshot(const std::string& path, TranspositionTable& table, ResultCache& results) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(SnapshotHeader)) {
+        close(fd);
+        return false;
+    }
+
+    size_t size = info.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    auto* bytes = static_cast<const uint8_t*>(mapping);
+    SnapshotHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+
+    if (header.ttSlots > size / 16 || header.resultEntries > size || header.resultBytes > size) {
+        munmap(mapping, size);
+        return false;
+    }
+    size_t slotSize = header.ttSlots * 2 * sizeof(uint64_t);
+    size_t resultSize = header.resultEntries * header.resultBytes;
+    const uint8_t* payload = bytes + sizeof(SnapshotHeader);
+    bool valid = std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) == 0 &&
+                 header.version == snapshotVersion &&
+                 header.headerBytes == sizeof(SnapshotHeader) &&
+                 header.resultBytes == sizeof(CachedResult) &&
+                 size == sizeof(SnapshotHeader) + slotSize + resultSize &&
+                 header.checksum == Checksum(payload + slotSize, resultSize, Checksum(payload, slotSize));
+
+    if (valid) {
+        table.ImportSlots(reinterpret_cast<const uint64_t*>(payload), header.ttSlots);
+
+        auto* cached = reinterpret_cast<const CachedResult*>(payload + slotSize);
+        for (size_t i = 0; i < header.resultEntries; i++) {
+            if (cached[i].move != 0) {
+                results.Store(cached[i]);
+            }
+        }
+    }
+
+    munmap(mapping, size);
+    return valid;
+}
@@ -0,0 +1,38 @@
+/**
+ * @file Snapshot.h
+ * @author John Korreck
+ *
+ * Saves the transposition table and result cache to a binary file and loads
+ * them back, so a restarted server begins with warm caches.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+
+class ResultCache;
+class TranspositionTable;
+
+/// File header; everything after it is covered by the checksum
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerBytes;
+    uint64_t ttSlots;        // followed by ttSlots (key ^ data, data) word pairs
+    uint64_t resultEntries;  // then the result cache entries
+    uint32_t resultBytes;
+    uint32_t reserved0;
+    uint64_t checksum;
+    char reserved[16];
+};
+static_assert(sizeof(SnapshotHeader) == 64);
+
+/// Write to a temporary file and rename it over the path, so a crash never leaves half a snapshot
+bool SaveSnapshot(const std::string& path, const TranspositionTable& table, const ResultCache& results);
+
+/// Memory-map the file and load it after checking the header and checksum
+bool LoadSnapshot(const std::string& path, TranspositionTable& table, ResultCache& results);
+
+#endif //SNAPSHOT_H
@@ -0,0 +1,63 @@
+/**
+ * @file Sprt.cpp
+ * @author John Korreck
+ */
+
+#include "Sprt.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Keeps the logistic curve finite for shut-outs
+const double scoreClamp = 1e-6;
+
+static double ExpectedScore(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+static double Elo(double mean) {
+    mean = std::clamp(mean, scoreClamp, 1.0 - scoreClamp);
+    return -400.0 * std::log10(1.0 / mean - 1.0);
+}
+
+double MatchScore::Mean() const {
+    return Games() == 0 ? 0.5 : (wins + draws * 0.5) / Games();
+}
+
+double MatchScore::Variance() const {
+    if (Games() == 0) return 0;
+    double mean = Mean();
+    double games = static_cast<double>(Games());
+    return (wins * (1 - mean) * (1 - mean) + draws * (0.5 - mean) * (0.5 - mean) + losses * mean * mean) / games;
+}
+
+double EloFromScore(const MatchScore& score) {
+    return Elo(score.Mean());
+}
+
+double EloErrorMargin(const MatchScore& score) {
+    if (score.Games() == 0) return 0;
+    double margin = 1.959964 * std::sqrt(score.Variance() / score.Games());
+    return (Elo(score.Mean() + margin) - Elo(score.Mean() - margin)) / 2;
+}
+
+Sprt::Sprt(double elo0, double elo1, double alpha, double beta)
+    : mElo0(elo0), mElo1(elo1),
+      mLower(std::log(beta / (1 - alpha))), mUpper(std::log((1 - beta) / alpha)) {
+}
+
+double Sprt::Llr(const MatchScore& score) const {
+    double variance = score.Variance();
+    if (score.Games() == 0 || variance <= 0) return 0;
+
+    double s0 = ExpectedScore(mElo0);
+    double s1 = ExpectedScore(mElo1);
+    return score.Games() * (s1 - s0) * (2 * score.Mean() - s0 - s1) / (2 * variance);
+}
+
+SprtDecision Sprt::Decide(const MatchScore& score) const {
+    double llr = Llr(score);
+    if (llr >= mUpper) return SprtDecision::AcceptH1;
+    if (llr <= mLower) return SprtDecision::AcceptH0;
+    return SprtDecision::Continue;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file Sprt.h
+ * @author John Korreck
+ *
+ * Elo estimates and the sequential probability ratio test for engine matches.
+ * The test weighs "the change is worth elo1" against "it is worth elo0" after
+ * every game and stops as soon as either is accepted at the chosen error rates,
+ * which usually takes far fewer games than a fixed-length match.
+ */
+
+#ifndef SPRT_H
+#define SPRT_H
+
+#include <cstdint>
+
+/// Results from the first engine's point of view
+struct MatchScore {
+    int64_t wins = 0;
+    int64_t draws = 0;
+    int64_t losses = 0;
+
+    int64_t Games() const { return wins + draws + losses; }
+    /// Points per game, 0 to 1
+    double Mean() const;
+    /// Variance of one game's points
+    double Variance() const;
+};
+
+/// Elo difference for a score, and the half-width of its 95% confidence interval
+double EloFromScore(const MatchScore& score);
+double EloErrorMargin(const MatchScore& score);
+
+enum class SprtDecision { Continue, AcceptH0, AcceptH1 };
+
+class Sprt {
+public:
+    Sprt(double elo0 = 0, double elo1 = 5, double alpha = 0.05, double beta = 0.05);
+
+    /// Log-likelihood ratio of H1 over H0, by the normal approximation to the game results
+    double Llr(const MatchScore& score) const;
+    SprtDecision Decide(const MatchScore& score) const;
+
+    double LowerBound() const { return mLower; }
+    double UpperBound() const { return mUpper; }
+    double Elo0() const { return mElo0; }
+    double Elo1() const { return mElo1; }
+
+private:
+    double mElo0;
+    double mElo1;
+    double mLower;
+    double mUpper;
+};
+
+#endif //SPRT_H
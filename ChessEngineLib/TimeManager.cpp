@@ -0,0 +1,54 @@
+/**
+ * @file TimeManager.cpp
+ * @author John Korreck
+ */
+
+#include "TimeManager.h"
+
+#include <algorithm>
+
+// Time kept back for unwinding the search and answering the request
+const int64_t safetyMarginMs = 5;
+
+// Moves a game clock is shared over when the time control doesn't say
+const int defaultMovesToGo = 30;
+// Time left on the clock for lag between moves
+const int64_t clockReserveMs = 50;
+
+int64_t TimeManager::FromClock(int64_t remainingMs, int64_t incrementMs, int movesToGo) {
+    int moves = movesToGo > 0 ? movesToGo : defaultMovesToGo;
+    int64_t budget = remainingMs / moves + incrementMs * 3 / 4;
+    int64_t available = std::max<int64_t>(1, remainingMs - std::min(clockReserveMs, remainingMs / 2));
+    return std::clamp<int64_t>(budget, 1, available);
+}
+
+void TimeManager::Start(int64_t budgetMs) {
+    mStart = std::chrono::steady_clock::now();
+    SetBudget(budgetMs);
+    mLastBestMove = 0;
+    mStability = 0;
+}
+
+void TimeManager::SetBudget(int64_t budgetMs) {
+    mBudgetMs = std::max<int64_t>(0, budgetMs);
+    mHardMs = std::max<int64_t>(1, mBudgetMs - std::min(safetyMarginMs, mBudgetMs / 10));
+    mSoftMs = mHardMs / 2;
+}
+
+int64_t TimeManager::ElapsedMs() const {
+    auto elapsed = std::chrono::steady_clock::now() - mStart;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+bool TimeManager::SoftLimitReached() const {
+    if (!IsLimited()) return false;
+
+    // Each iteration with the same best move takes a tenth off, down to half
+    int64_t soft = mSoftMs * (10 - std::min(mStability, 5)) / 10;
+    return ElapsedMs() >= soft;
+}
+
+void TimeManager::OnIteration(uint16_t bestMove) {
+    mStability = bestMove == mLastBestMove ? mStability + 1 : 0;
+    mLastBestMove = bestMove;
+}
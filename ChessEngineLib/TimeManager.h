@@ -0,0 +1,46 @@
+/**
+ * @file TimeManager.h
+ * @author John Korreck
+ *
+ * Turns a move-time budget into soft and hard search limits.
+ */
+
+#ifndef TIMEMANAGER_H
+#define TIMEMANAGER_H
+
+#include <chrono>
+#include <cstdint>
+
+class TimeManager {
+public:
+    /// Budget for one move from a game clock: a share of the time left plus most of the
+    /// increment, never so much that the flag could fall
+    static int64_t FromClock(int64_t remainingMs, int64_t incrementMs, int movesToGo = 0);
+
+    /// Start the clock; a budget of 0 means no time limit
+    void Start(int64_t budgetMs);
+    /// Change the budget without restarting the clock; time already spent counts against it
+    void SetBudget(int64_t budgetMs);
+
+    int64_t ElapsedMs() const;
+    bool IsLimited() const { return mBudgetMs > 0; }
+
+    /// Past the hard limit the search must stop, even mid-iteration
+    bool HardLimitReached() const { return IsLimited() && ElapsedMs() >= mHardMs; }
+
+    /// Past the soft limit another iteration is unlikely to finish in time
+    bool SoftLimitReached() const;
+
+    /// Report the best move of a finished iteration; a stable best move shortens the soft limit
+    void OnIteration(uint16_t bestMove);
+
+private:
+    std::chrono::steady_clock::time_point mStart;
+    int64_t mBudgetMs = 0;
+    int64_t mSoftMs = 0;
+    int64_t mHardMs = 0;
+    uint16_t mLastBestMove = 0;
+    int mStability = 0;
+};
+
+#endif //TIMEMANAGER_H
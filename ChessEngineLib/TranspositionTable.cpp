@@ -0,0 +1,188 @@
+/**
+ * @file TranspositionTable.cpp
+ * @author John Korreck
+ */
+
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+/// First bytes of a shared segment, so processes built differently don't share slots
+struct SharedHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slotBytes;
+    uint64_t slots;
+    char reserved[40];
+};
+static_assert(sizeof(SharedHeader) == 64);
+
+const char sharedMagic[8] = {'C', 'E', 'T', 'T', 's', 'h', 'm', '1'};
+const uint32_t sharedVersion = 1;
+
+uint64_t Pack(Move move, int score, int depth, Bound bound) {
+    return uint64_t(uint32_t(score)) | uint64_t(move.Raw()) << 32 |
+           uint64_t(uint8_t(depth)) << 48 | uint64_t(bound) << 56;
+}
+
+void Unpack(uint64_t data, TTEntry& entry) {
+    entry.score = int32_t(uint32_t(data));
+    entry.move = uint16_t(data >> 32);
+    entry.depth = int8_t(uint8_t(data >> 48));
+    entry.bound = Bound(uint8_t(data >> 56));
+}
+
+size_t SlotsFor(size_t megabytes, size_t slotBytes) {
+    // Power of two so the index is a mask
+    return std::bit_floor(std::max<size_t>(1, megabytes * 1024 * 1024 / slotBytes));
+}
+
+} // namespace
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    Resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable() {
+    Release();
+}
+
+void TranspositionTable::Release() {
+    if (mMapping) {
+        munmap(mMapping, mMappingSize);
+    }
+    mMapping = nullptr;
+    mMappingSize = 0;
+    mOwned.reset();
+    mSlots = nullptr;
+}
+
+void TranspositionTable::Resize(size_t megabytes) {
+    // Private memory is claimed on the first store
+    Release();
+    mMegabytes = megabytes;
+    mSize = SlotsFor(megabytes, sizeof(Slot));
+}
+
+bool TranspositionTable::AttachShared(const std::string& name, bool hugePages) {
+    size_t slots = SlotsFor(mMegabytes, sizeof(Slot));
+    size_t bytes = HeaderBytes + slots * sizeof(Slot);
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0) return false;
+
+    // The first process sizes the segment (zero-filled); the rest must agree with it
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || (info.st_size == 0 && ftruncate(fd, bytes) != 0) ||
+        fstat(fd, &info) != 0 || size_t(info.st_size) != bytes) {
+        close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+#ifdef MADV_HUGEPAGE
+    if (hugePages) {
+        madvise(mapping, bytes, MADV_HUGEPAGE);
+    }
+#endif
+
+    // Fill in a fresh header, magic last; racing creators write identical bytes
+    auto* header = static_cast<SharedHeader*>(mapping);
+    static const char noMagic[8] = {};
+    if (std::memcmp(header->magic, noMagic, sizeof(noMagic)) == 0) {
+        header->version = sharedVersion;
+        header->slotBytes = sizeof(Slot);
+        header->slots = slots;
+        std::memcpy(header->magic, sharedMagic, sizeof(sharedMagic));
+    }
+    if (std::memcmp(header->magic, sharedMagic, sizeof(sharedMagic)) != 0 ||
+        header->version != sharedVersion || header->slotBytes != sizeof(Slot) || header->slots != slots) {
+        munmap(mapping, bytes);
+        return false;
+    }
+
+    Release();
+    mMapping = mapping;
+    mMappingSize = bytes;
+    mSlots = reinterpret_cast<Slot*>(static_cast<char*>(mapping) + HeaderBytes);
+    mSize = slots;
+    return true;
+}
+
+void TranspositionTable::Allocate() {
+    if (!mSlots) {
+        mOwned = std::make_unique<Slot[]>(mSize);
+        mSlots = mOwned.get();
+    }
+}
+
+void TranspositionTable::Clear() {
+    // Zeroed in place: other threads or processes may be probing it
+    for (size_t i = 0; mSlots && i < mSize; i++) {
+        mSlots[i].check.store(0, std::memory_order_relaxed);
+        mSlots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool TranspositionTable::Probe(uint64_t key, TTEntry& entry) const {
+    if (!mSlots) return false;
+
+    const Slot& slot = mSlots[key & (mSize - 1)];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || Bound(uint8_t(data >> 56)) == Bound::None) return false;
+
+    entry.key = key;
+    Unpack(data, entry);
+    return true;
+}
+
+void TranspositionTable::Store(uint64_t key, Move move, int score, int depth, Bound bound) {
+    Allocate();
+
+    Slot& slot = mSlots[key & (mSize - 1)];
+    uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+    bool sameKey = (slot.check.load(std::memory_order_relaxed) ^ oldData) == key;
+
+    // Prefer deeper results for the same position, but always take exact scores and new positions
+    if (sameKey && depth < int8_t(uint8_t(oldData >> 48)) && bound != Bound::Exact) return;
+
+    // Keep the old best move if this search didn't find one
+    if (sameKey && move.IsNull()) {
+        move = Move::FromRaw(uint16_t(oldData >> 32));
+    }
+
+    uint64_t data = Pack(move, score, depth, bound);
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::ExportSlots(uint64_t* words) const {
+    for (size_t i = 0; i < mSize; i++) {
+        words[2 * i] = mSlots ? mSlots[i].check.load(std::memory_order_relaxed) : 0;
+        words[2 * i + 1] = mSlots ? mSlots[i].data.load(std::memory_order_relaxed) : 0;
+    }
+}
+
+void TranspositionTable::ImportSlots(const uint64_t* words, size_t slots) {
+    for (size_t i = 0; i < slots; i++) {
+        uint64_t data = words[2 * i + 1];
+        if (Bound(uint8_t(data >> 56)) == Bound::None) continue;
+
+        TTEntry entry;
+        Unpack(data, entry);
+        Store(words[2 * i] ^ data, Move::FromRaw(entry.move), entry.score, entry.depth, entry.bound);
+    }
+}
@@ -0,0 +1,81 @@
+/**
+ * @file TranspositionTable.h
+ * @author John Korreck
+ *
+ * Hash table of search results keyed by the full Zobrist key. The table can
+ * live in private memory or in a named POSIX shared-memory segment that every
+ * worker process on the machine maps. Entries are written without locks: each
+ * slot stores its data word and the key XORed with it, so a torn write from
+ * another process reads back as a miss instead of a wrong hit.
+ */
+
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Move.h"
+
+enum class Bound : uint8_t { None, Exact, Lower, Upper };
+
+struct TTEntry {
+    uint64_t key = 0;
+    int32_t score = 0;
+    uint16_t move = 0;
+    int8_t depth = 0;
+    Bound bound = Bound::None;
+};
+
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes = 16);
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    /// Resize in private memory, leaving any shared segment
+    void Resize(size_t megabytes);
+
+    /// Map (creating if needed) the named shared-memory segment at the current size
+    bool AttachShared(const std::string& name, bool hugePages = false);
+    bool IsShared() const { return mMapping != nullptr; }
+
+    /// Claim private memory now rather than on the first store, so threads can share the table
+    void Allocate();
+    void Clear();
+
+    bool Probe(uint64_t key, TTEntry& entry) const;
+    void Store(uint64_t key, Move move, int score, int depth, Bound bound);
+
+    size_t Size() const { return mSize; }
+    size_t Megabytes() const { return mMegabytes; }
+
+    /// Raw slots as (key ^ data, data) word pairs, for snapshots
+    void ExportSlots(uint64_t* words) const;
+    /// Store every valid slot from an export, which may come from a table of another size
+    void ImportSlots(const uint64_t* words, size_t slots);
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "slots are shared between processes");
+
+    static constexpr size_t HeaderBytes = 64;
+
+    size_t mMegabytes = 0;
+    size_t mSize = 0;
+    Slot* mSlots = nullptr;
+    std::unique_ptr<Slot[]> mOwned;
+    void* mMapping = nullptr;
+    size_t mMappingSize = 0;
+
+    void Release();
+};
+
+#endif //TRANSPOSITIONTABLE_H
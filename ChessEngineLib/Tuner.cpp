@@ -0,0 +1,399 @@
+/**
+ * @file Tuner.cpp
+ * @author John Korreck
+ */
+
+#include "Tuner.h"
+#include "Board.h"
+#include "EvalWeights.h"
+#include "PawnTable.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// As in Engine::EvaluateBoard
+const int phaseWeights[7] = {0, 0, 1, 1, 2, 4, 0};
+const int maxPhase = 24;
+const uint64_t centreSquares = 0x0000001818000000ULL;
+const int squareOffsets[7] = {-1, TunePawnSquares, TuneKnightSquares, TuneBishopSquares, -1, -1, -1};
+
+const char* startPosition = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Lines smaller than this per thread aren't worth a thread
+const size_t minBytesPerThread = 1 << 16;
+
+int ThreadCount(int threads) {
+    return threads > 0 ? threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+/// Run work(begin, end, thread) over [0, count) in contiguous chunks, one per thread
+template <typename Work> void ForChunks(size_t count, int threads, const Work& work) {
+    size_t workers = std::clamp<size_t>(threads, 1, std::max<size_t>(1, count));
+    size_t chunk = (count + workers - 1) / workers;
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < workers; t++) {
+        size_t begin = std::min(count, t * chunk);
+        pool.emplace_back(work, begin, std::min(count, begin + chunk), t);
+    }
+    work(size_t(0), std::min(count, chunk), size_t(0));
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+}
+
+// The FEN fields and result of one line; false if there is no result
+bool ParseLine(std::string_view line, std::string& fen, double& result) {
+    size_t marker = line.find('[');
+    if (marker != std::string_view::npos) {
+        size_t start = marker + 1;
+        while (start < line.size() && line[start] == ' ') start++;
+        auto [end, error] = std::from_chars(line.data() + start, line.data() + line.size(), result);
+        if (error != std::errc() || result < 0 || result > 1) return false;
+    } else if ((marker = line.find("1/2-1/2")) != std::string_view::npos) {
+        result = 0.5;
+    } else if ((marker = line.find("1-0")) != std::string_view::npos) {
+        result = 1;
+    } else if ((marker = line.find("0-1")) != std::string_view::npos) {
+        result = 0;
+    } else {
+        return false;
+    }
+
+    // Placement, side, castling and en passant, then the clocks if they are there (EPD has none)
+    fen.clear();
+    std::string_view rest = line.substr(0, marker);
+    for (int field = 0; field < 6; field++) {
+        size_t start = rest.find_first_not_of(" \t");
+        if (start == std::string_view::npos) break;
+        size_t end = std::min(rest.find_first_of(" \t", start), rest.size());
+        std::string_view token = rest.substr(start, end - start);
+        if (field >= 4 && token.find_first_not_of("0123456789") != std::string_view::npos) break;
+        fen += (fen.empty() ? "" : " ") + std::string(token);
+        rest = rest.substr(end);
+    }
+    return !fen.empty();
+}
+
+// Expected score for white from an evaluation, as in the usual Elo curve
+double Sigmoid(double eval, double scale) {
+    return 1.0 / (1.0 + std::pow(10.0, -scale * eval / 400.0));
+}
+
+// Exactly one king each, so the attack maps make sense
+bool HasBothKings(const Board& board) {
+    int kings[2] = {0, 0};
+    for (const auto& row : board.GetBoard()) {
+        for (int piece : row) {
+            if (std::abs(piece) == 6) kings[piece > 0 ? 0 : 1]++;
+        }
+    }
+    return kings[0] == 1 && kings[1] == 1;
+}
+
+} // namespace
+
+void ExtractFeatures(Board& board, PawnTable& pawns, EvalFeatures& features) {
+    int counts[TuneWeightCount] = {};
+    int phase = 0;
+    const auto& boardArray = board.GetBoard();
+    for (int rank = 0; rank < 8; rank++) {
+        for (int file = 0; file < 8; file++) {
+            int piece = boardArray[rank][file];
+            if (piece == 0) continue;
+
+            bool isWhite = piece > 0;
+            int sign = isWhite ? 1 : -1;
+            int pieceType = std::abs(piece);
+            phase += phaseWeights[pieceType];
+            if (pieceType <= 5) counts[TunePieceValues + pieceType - 1] += sign;
+            if (squareOffsets[pieceType] >= 0) {
+                counts[squareOffsets[pieceType] + (isWhite ? rank : 7 - rank) * 8 + file] += sign;
+            }
+        }
+    }
+
+    const AttackMap& attacks = board.GetAttacks();
+    for (int side = 0; side < 2; side++) {
+        int sign = side == 0 ? 1 : -1;
+        for (int pieceType = 1; pieceType <= 6; pieceType++) {
+            uint64_t controlled = attacks.byPiece[side][pieceType];
+            counts[TuneControl + pieceType - 1] += sign * std::popcount(controlled);
+            counts[TuneCentre + pieceType - 1] += sign * std::popcount(controlled & centreSquares);
+        }
+    }
+
+    features.terms.clear();
+    for (int i = 0; i < TuneWeightCount; i++) {
+        if (counts[i] != 0) features.terms.emplace_back(static_cast<uint16_t>(i), static_cast<int8_t>(counts[i]));
+    }
+
+    phase = std::min(phase, maxPhase);
+    PawnEntry& entry = pawns.Probe(board);
+    int pawnMg = entry.mg[0] - entry.mg[1];
+    int pawnEg = entry.eg[0] - entry.eg[1];
+    pawnMg += PawnTable::Shelter(entry, 0, board.GetKingSquare(true)) -
+              PawnTable::Shelter(entry, 1, board.GetKingSquare(false));
+    features.fixed = (pawnMg * phase + pawnEg * (maxPhase - phase)) / maxPhase;
+}
+
+std::vector<double> CurrentWeights() {
+    std::vector<double> weights(TuneWeightCount);
+    for (int pieceType = 1; pieceType <= 5; pieceType++) {
+        weights[TunePieceValues + pieceType - 1] = EvalWeights::pieceValues[pieceType];
+    }
+    for (int square = 0; square < 64; square++) {
+        weights[TunePawnSquares + square] = EvalWeights::pawnSquares[square];
+        weights[TuneKnightSquares + square] = EvalWeights::knightSquares[square];
+        weights[TuneBishopSquares + square] = EvalWeights::bishopSquares[square];
+    }
+    for (int pieceType = 1; pieceType <= 6; pieceType++) {
+        weights[TuneControl + pieceType - 1] =
+            EvalWeights::controlWeights[pieceType] / double(EvalWeights::controlScale);
+        weights[TuneCentre + pieceType - 1] =
+            EvalWeights::centreWeights[pieceType] / double(EvalWeights::controlScale);
+    }
+    return weights;
+}
+
+bool WriteWeightsHeader(const std::string& path, const std::vector<double>& weights) {
+    if (weights.size() != TuneWeightCount) return false;
+    auto round = [](double value) { return std::to_string(std::lround(value)); };
+    auto pieceArray = [&](int offset, int count, double scale) {
+        std::string text = "{0";
+        for (int i = 0; i < count; i++) {
+            text += ", " + round(weights[offset + i] * scale);
+        }
+        return text + (count == 5 ? ", 0}" : "}");
+    };
+    auto squareTable = [&](const char* name, int offset) {
+        std::string text = std::string("inline constexpr int ") + name + "[64] = {\n";
+        for (int rank = 0; rank < 8; rank++) {
+            text += "   ";
+            for (int file = 0; file < 8; file++) {
+                std::string value = round(weights[offset + rank * 8 + file]);
+                text += std::string(std::max(1, 5 - static_cast<int>(value.size())), ' ') + value + ",";
+            }
+            text += "\n";
+        }
+        return text + "};\n";
+    };
+
+    std::ofstream file(path, std::ios::trunc);
+    file << "/**\n"
+            " * @file EvalWeights.h\n"
+            " * @author John Korreck\n"
+            " *\n"
+            " * Weights of the hand-written evaluation. Written by the tune tool; regenerate\n"
+            " * it rather than editing by hand.\n"
+            " */\n"
+            "\n"
+            "#ifndef EVALWEIGHTS_H\n"
+            "#define EVALWEIGHTS_H\n"
+            "\n"
+            "namespace EvalWeights {\n"
+            "\n"
+            "// Material by piece type: none, pawn, knight, bishop, rook, queen, king\n"
+            "inline constexpr int pieceValues[7] = " << pieceArray(TunePieceValues, 5, 1) << ";\n"
+            "\n"
+            "// Piece-square bonuses for white, square = rank * 8 + file with rank 0 the eighth rank.\n"
+            "// Black uses the square mirrored top to bottom.\n"
+         << squareTable("pawnSquares", TunePawnSquares) << "\n"
+         << squareTable("knightSquares", TuneKnightSquares) << "\n"
+         << squareTable("bishopSquares", TuneBishopSquares) << "\n"
+         << "// Control per attacked square by piece type, and the extra for d4, e4, d5 and e5,\n"
+            "// in units of 1/controlScale centipawn\n"
+            "inline constexpr int controlScale = " << EvalWeights::controlScale << ";\n"
+            "inline constexpr int controlWeights[7] = "
+         << pieceArray(TuneControl, 6, EvalWeights::controlScale) << ";\n"
+            "inline constexpr int centreWeights[7] = "
+         << pieceArray(TuneCentre, 6, EvalWeights::controlScale) << ";\n"
+            "\n"
+            "} // namespace EvalWeights\n"
+            "\n"
+            "#endif //EVALWEIGHTS_H\n";
+    return static_cast<bool>(file);
+}
+
+void TuningSet::Add(const EvalFeatures& features, double result) {
+    for (auto [index, count] : features.terms) {
+        mIndices.push_back(index);
+        mCounts.push_back(count);
+    }
+    mOffsets.push_back(static_cast<uint32_t>(mIndices.size()));
+    mFixed.push_back(static_cast<float>(features.fixed));
+    mResults.push_back(static_cast<float>(result));
+}
+
+bool TuningSet::Load(const std::string& path, int threads) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info {};
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    size_t size = info.st_size;
+    if (size == 0) {
+        close(fd);
+        return true;
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    const char* text = static_cast<const char*>(mapping);
+
+    // Each thread takes the lines that start in its stretch of the file
+    int workers = static_cast<int>(std::clamp<size_t>(size / minBytesPerThread, 1, ThreadCount(threads)));
+    std::vector<TuningSet> parts(workers);
+    ForChunks(size, workers, [&](size_t begin, size_t end, size_t part) {
+        auto lineStart = [&](size_t offset) {
+            if (offset == 0) return offset;
+            const void* newline = std::memchr(text + offset - 1, '\n', size - offset + 1);
+            return newline ? static_cast<const char*>(newline) - text + 1 : size;
+        };
+        std::string name = "Tune";
+        std::string position = startPosition;
+        Board board(name, position);
+        PawnTable pawns;
+        EvalFeatures features;
+        std::string fen;
+        double result = 0;
+
+        for (size_t offset = lineStart(begin), stop = lineStart(end); offset < stop;) {
+            const void* newline = std::memchr(text + offset, '\n', size - offset);
+            size_t lineEnd = newline ? static_cast<const char*>(newline) - text : size;
+            std::string_view line(text + offset, lineEnd - offset);
+            offset = lineEnd + 1;
+
+            if (!ParseLine(line, fen, result)) continue;
+            board.FenParser(fen);
+            if (!HasBothKings(board) || board.GetAttacks().checkers != 0) continue;
+            ExtractFeatures(board, pawns, features);
+            parts[part].Add(features, result);
+        }
+    });
+    munmap(mapping, size);
+
+    for (const TuningSet& part : parts) {
+        uint32_t base = mOffsets.back();
+        for (size_t i = 1; i < part.mOffsets.size(); i++) {
+            mOffsets.push_back(base + part.mOffsets[i]);
+        }
+        mIndices.insert(mIndices.end(), part.mIndices.begin(), part.mIndices.end());
+        mCounts.insert(mCounts.end(), part.mCounts.begin(), part.mCounts.end());
+        mFixed.insert(mFixed.end(), part.mFixed.begin(), part.mFixed.end());
+        mResults.insert(mResults.end(), part.mResults.begin(), part.mResults.end());
+    }
+    return true;
+}
+
+Tuner::Tuner(const TuningSet& set, std::vector<double> weights, TunerSettings settings)
+    : mSet(set), mWeights(std::move(weights)), mSettings(settings), mThreads(ThreadCount(settings.threads)),
+      mMoment(mWeights.size()), mVelocity(mWeights.size()), mOrder(set.Size()) {
+    for (size_t i = 0; i < mOrder.size(); i++) {
+        mOrder[i] = static_cast<uint32_t>(i);
+    }
+}
+
+double Tuner::Error() const {
+    return Error(mScale);
+}
+
+double Tuner::Error(double scale) const {
+    if (mSet.Size() == 0) return 0;
+    std::vector<double> sums(mThreads);
+    ForChunks(mSet.Size(), mThreads, [&](size_t begin, size_t end, size_t thread) {
+        double sum = 0;
+        for (size_t i = begin; i < end; i++) {
+            double error = mSet.Result(i) - Sigmoid(mSet.Evaluate(i, mWeights.data()), scale);
+            sum += error * error;
+        }
+        sums[thread] = sum;
+    });
+    double total = 0;
+    for (double sum : sums) total += sum;
+    return total / mSet.Size();
+}
+
+double Tuner::FitScale() {
+    // Golden-section search; the error is unimodal in the scale
+    const double ratio = (std::sqrt(5.0) - 1) / 2;
+    double low = 0.01;
+    double high = 4.0;
+    double a = high - ratio * (high - low);
+    double b = low + ratio * (high - low);
+    double errorA = Error(a);
+    double errorB = Error(b);
+    for (int i = 0; i < 40; i++) {
+        if (errorA < errorB) {
+            high = b;
+            b = a;
+            errorB = errorA;
+            a = high - ratio * (high - low);
+            errorA = Error(a);
+        } else {
+            low = a;
+            a = b;
+            errorA = errorB;
+            b = low + ratio * (high - low);
+            errorB = Error(b);
+        }
+    }
+    mScale = (low + high) / 2;
+    return mScale;
+}
+
+void Tuner::Epoch() {
+    std::shuffle(mOrder.begin(), mOrder.end(), mRandom);
+    size_t batch = mSettings.batchSize ? mSettings.batchSize : mOrder.size();
+    for (size_t begin = 0; begin < mOrder.size(); begin += batch) {
+        Step(mOrder.data() + begin, std::min(batch, mOrder.size() - begin));
+    }
+}
+
+void Tuner::Step(const uint32_t* batch, size_t count) {
+    // Each thread sums the gradient over its share of the batch
+    std::vector<std::vector<double>> gradients(mThreads, std::vector<double>(mWeights.size()));
+    double slope = mScale * std::log(10.0) / 400.0;
+    ForChunks(count, mThreads, [&](size_t begin, size_t end, size_t thread) {
+        double* gradient = gradients[thread].data();
+        for (size_t b = begin; b < end; b++) {
+            uint32_t i = batch[b];
+            double predicted = Sigmoid(mSet.Evaluate(i, mWeights.data()), mScale);
+            double delta = 2 * (predicted - mSet.Result(i)) * predicted * (1 - predicted) * slope;
+            for (uint32_t t = mSet.mOffsets[i]; t < mSet.mOffsets[i + 1]; t++) {
+                gradient[mSet.mIndices[t]] += delta * mSet.mCounts[t];
+            }
+        }
+    });
+
+    mSteps++;
+    double correction1 = 1 - std::pow(mSettings.beta1, mSteps);
+    double correction2 = 1 - std::pow(mSettings.beta2, mSteps);
+    for (size_t w = 0; w < mWeights.size(); w++) {
+        double gradient = 0;
+        for (const std::vector<double>& part : gradients) gradient += part[w];
+        gradient /= count;
+
+        mMoment[w] = mSettings.beta1 * mMoment[w] + (1 - mSettings.beta1) * gradient;
+        mVelocity[w] = mSettings.beta2 * mVelocity[w] + (1 - mSettings.beta2) * gradient * gradient;
+        double moment = mMoment[w] / correction1;
+        double velocity = mVelocity[w] / correction2;
+        mWeights[w] -= mSettings.learningRate * moment / (std::sqrt(velocity) + 1e-8);
+    }
+}
@@ -0,0 +1,122 @@
+/**
+ * @file Tuner.h
+ * @author John Korreck
+ *
+ * Texel-style tuning of the hand-written evaluation. The evaluation is linear
+ * in its weights, so each labelled position is reduced once to sparse feature
+ * counts (white's minus black's), and the weights are then fitted so that a
+ * sigmoid of the evaluation predicts the game results, by mini-batch Adam with
+ * the batches split across threads. The result is written out as EvalWeights.h.
+ */
+
+#ifndef TUNER_H
+#define TUNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Board;
+class PawnTable;
+
+// Where each weight sits in the parameter vector. Piece values and control weights run from
+// pawn to queen and pawn to king; control is in centipawns per square here.
+constexpr int TunePieceValues = 0;
+constexpr int TunePawnSquares = TunePieceValues + 5;
+constexpr int TuneKnightSquares = TunePawnSquares + 64;
+constexpr int TuneBishopSquares = TuneKnightSquares + 64;
+constexpr int TuneControl = TuneBishopSquares + 64;
+constexpr int TuneCentre = TuneControl + 6;
+constexpr int TuneWeightCount = TuneCentre + 6;
+
+/// A position's evaluation as sum(weight[index] * count) + fixed
+struct EvalFeatures {
+    std::vector<std::pair<uint16_t, int8_t>> terms;
+    double fixed = 0;  // terms that aren't tuned: pawn structure and king shelter
+};
+
+void ExtractFeatures(Board& board, PawnTable& pawns, EvalFeatures& features);
+
+/// The weights in EvalWeights.h
+std::vector<double> CurrentWeights();
+
+/// Round the weights and write them as a replacement for EvalWeights.h
+bool WriteWeightsHeader(const std::string& path, const std::vector<double>& weights);
+
+/// Labelled positions reduced to their features
+class TuningSet {
+public:
+    /// Memory-map a file with one position per line, a FEN followed by its game result
+    /// (1-0, 0-1, 1/2-1/2, or [1.0], [0.5], [0.0]), and extract features across threads
+    /// (0 for one per core). Positions in check, and lines that can't be read, are skipped.
+    bool Load(const std::string& path, int threads = 0);
+    void Add(const EvalFeatures& features, double result);
+
+    size_t Size() const { return mResults.size(); }
+    double Result(size_t i) const { return mResults[i]; }
+    double Evaluate(size_t i, const double* weights) const {
+        double eval = mFixed[i];
+        for (uint32_t t = mOffsets[i]; t < mOffsets[i + 1]; t++) {
+            eval += weights[mIndices[t]] * mCounts[t];
+        }
+        return eval;
+    }
+
+private:
+    friend class Tuner;
+
+    // Compressed rows: position i's terms are [mOffsets[i], mOffsets[i + 1])
+    std::vector<uint32_t> mOffsets{0};
+    std::vector<uint16_t> mIndices;
+    std::vector<int8_t> mCounts;
+    std::vector<float> mFixed;
+    std::vector<float> mResults;  // 1 white won, 0.5 drawn, 0 black won
+};
+
+struct TunerSettings {
+    size_t batchSize = 16384;     // 0 for the whole set
+    double learningRate = 1.0;    // Adam step, in centipawns
+    double beta1 = 0.9;
+    double beta2 = 0.999;
+    int threads = 0;              // 0 for one per core
+};
+
+class Tuner {
+public:
+    Tuner(const TuningSet& set, std::vector<double> weights, TunerSettings settings = TunerSettings());
+
+    /// Mean squared error between results and predictions over the whole set
+    double Error() const;
+    /// Choose the sigmoid's scale that best fits the current weights; call before tuning
+    double FitScale();
+    double Scale() const { return mScale; }
+    void SetScale(double scale) { mScale = scale; }
+
+    /// One pass over the set in shuffled batches
+    void Epoch();
+
+    const std::vector<double>& Weights() const { return mWeights; }
+
+private:
+    const TuningSet& mSet;
+    std::vector<double> mWeights;
+    TunerSettings mSettings;
+    double mScale = 1.0;
+    int mThreads;
+
+    // Adam moments
+    std::vector<double> mMoment;
+    std::vector<double> mVelocity;
+    int64_t mSteps = 0;
+
+    std::vector<uint32_t> mOrder;
+    std::mt19937_64 mRandom{0x5EED};
+
+    double Error(double scale) const;
+    void Step(const uint32_t* batch, size_t count);
+};
+
+#endif //TUNER_H
@@ -0,0 +1,233 @@
+/**
+ * @file Uci.cpp
+ * @author John Korreck
+ */
+
+#include "Uci.h"
+#include "Board.h"
+#include "Engine.h"
+#include "TimeManager.h"
+
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+static const char* startPosition = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+namespace {
+
+class UciEngine {
+public:
+    explicit UciEngine(std::ostream& out) : mOut(out), mBoard(MakeBoard(startPosition)) {}
+    ~UciEngine() { StopSearch(); }
+
+    /// False once told to quit
+    bool Handle(const std::string& line);
+    void WaitForSearch();
+
+private:
+    std::ostream& mOut;
+    std::mutex mOutMutex;
+    Engine mEngine;
+    std::unique_ptr<Board> mBoard;
+    std::thread mSearch;
+    // An infinite search holds its bestmove until stop, even if it runs out of depth first
+    std::mutex mStopMutex;
+    std::condition_variable mStopSignal;
+    bool mStopSent = false;
+    bool mInfinite = false;
+
+    static std::unique_ptr<Board> MakeBoard(const std::string& fen);
+    void Send(const std::string& line);
+    void SetPosition(std::istringstream& args);
+    void Go(std::istringstream& args);
+    void StopSearch();
+};
+
+std::unique_ptr<Board> UciEngine::MakeBoard(const std::string& fen) {
+    std::string name = "Uci";
+    std::string position = fen;
+    return std::make_unique<Board>(name, position);
+}
+
+void UciEngine::Send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(mOutMutex);
+    mOut << line << std::endl;
+}
+
+bool UciEngine::Handle(const std::string& line) {
+    std::istringstream args(line);
+    std::string command;
+    args >> command;
+
+    if (command == "uci") {
+        Send("id name ChessEngine");
+        Send("id author John Korreck");
+        Send("option name Hash type spin default 16 min 1 max 65536");
+        Send("option name EvalFile type string default <empty>");
+        Send("option name UseNNUE type check default false");
+        Send("option name TraceFile type string default <empty>");
+        Send("uciok");
+    } else if (command == "isready") {
+        Send("readyok");
+    } else if (command == "setoption") {
+        // setoption name <name> value <value>; names and values may not contain spaces here
+        std::string word, name, value;
+        while (args >> word) {
+            if (word == "name") args >> name;
+            else if (word == "value") args >> value;
+        }
+        StopSearch();
+        mEngine.SetOption(name, value);
+    } else if (command == "ucinewgame") {
+        StopSearch();
+        mEngine.NewGame();
+    } else if (command == "position") {
+        StopSearch();
+        SetPosition(args);
+    } else if (command == "go") {
+        StopSearch();
+        Go(args);
+    } else if (command == "stop") {
+        StopSearch();
+    } else if (command == "quit") {
+        return false;
+    }
+    return true;
+}
+
+void UciEngine::SetPosition(std::istringstream& args) {
+    std::string word;
+    args >> word;
+    std::string fen = startPosition;
+    if (word == "fen") {
+        fen.clear();
+        while (args >> word && word != "moves") {
+            fen += (fen.empty() ? "" : " ") + word;
+        }
+    } else {
+        args >> word;
+    }
+
+    mBoard = MakeBoard(fen);
+    while (args >> word) {
+        Move move = mBoard->ParseMove(word);
+        MoveList legalMoves;
+        mBoard->GenerateMoves(legalMoves);
+        if (move.IsNull() || !legalMoves.Contains(move)) break;
+        mBoard->MakeMove(move);
+    }
+}
+
+void UciEngine::Go(std::istringstream& args) {
+    SearchLimits limits;
+    int64_t time[2] = {0, 0};
+    int64_t increment[2] = {0, 0};
+    int movesToGo = 0;
+    bool infinite = false;
+    std::string word;
+    while (args >> word) {
+        if (word == "wtime") args >> time[0];
+        else if (word == "btime") args >> time[1];
+        else if (word == "winc") args >> increment[0];
+        else if (word == "binc") args >> increment[1];
+        else if (word == "movestogo") args >> movesToGo;
+        else if (word == "movetime") args >> limits.moveTimeMs;
+        else if (word == "depth") args >> limits.depth;
+        else if (word == "nodes") args >> limits.nodes;
+        else if (word == "infinite") infinite = true;
+    }
+
+    int side = mBoard->IsWhiteTurn() ? 0 : 1;
+    if (infinite) {
+        // Only stop ends it, whatever clocks came with it
+        limits = SearchLimits();
+    } else if (limits.moveTimeMs == 0 && time[side] > 0) {
+        limits.moveTimeMs = TimeManager::FromClock(time[side], increment[side], movesToGo);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mStopMutex);
+        mStopSent = false;
+        mInfinite = infinite;
+    }
+    mSearch = std::thread([this, limits, infinite]() {
+        // Search clears the engine's stop flag as it starts, so a stop sent before then is
+        // picked up here at the first poll instead
+        mEngine.SetYieldHook([this] {
+            std::lock_guard<std::mutex> lock(mStopMutex);
+            if (mStopSent) mEngine.Stop();
+        });
+        // Report each iteration as it completes, so a GUI can show the analysis growing
+        mEngine.SetIterationHook([this](const SearchResult& result) {
+            std::ostringstream info;
+            int64_t nps = result.timeMs > 0 ? static_cast<int64_t>(result.nodes * 1000 / result.timeMs) : 0;
+            info << "info depth " << result.depth << " score " << FormatScore(result.score)
+                 << " nodes " << result.nodes << " nps " << nps << " time " << result.timeMs;
+            if (!result.lines.empty()) {
+                info << " pv";
+                for (Move move : result.lines[0].pv) {
+                    info << " " << move.ToString();
+                }
+            }
+            Send(info.str());
+        });
+        SearchResult result = mEngine.Search(*mBoard, limits);
+        mEngine.SetIterationHook(nullptr);
+        mEngine.SetYieldHook(nullptr);
+        if (infinite) {
+            std::unique_lock<std::mutex> lock(mStopMutex);
+            mStopSignal.wait(lock, [this] { return mStopSent; });
+        }
+        Send("bestmove " + (result.bestMove.IsNull() ? std::string("0000") : result.bestMove.ToString()));
+    });
+}
+
+void UciEngine::WaitForSearch() {
+    bool infinite;
+    {
+        std::lock_guard<std::mutex> lock(mStopMutex);
+        infinite = mInfinite;
+    }
+    // Nothing is left to stop an infinite search
+    if (infinite) StopSearch();
+    else if (mSearch.joinable()) mSearch.join();
+}
+
+void UciEngine::StopSearch() {
+    if (!mSearch.joinable()) return;
+    mEngine.Stop();
+    {
+        std::lock_guard<std::mutex> lock(mStopMutex);
+        mStopSent = true;
+    }
+    mStopSignal.notify_one();
+    mSearch.join();
+}
+
+} // namespace
+
+std::string FormatScore(int score) {
+    int mateBound = Engine::MateScore - Engine::MaxPly;
+    if (std::abs(score) < mateBound) return "cp " + std::to_string(score);
+
+    // Moves, not plies, to the mate; negative when being mated
+    int plies = Engine::MateScore - std::abs(score);
+    int moves = (plies + 1) / 2;
+    return "mate " + std::to_string(score > 0 ? moves : -moves);
+}
+
+void RunUci(std::istream& in, std::ostream& out) {
+    UciEngine engine(out);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!engine.Handle(line)) return;
+    }
+
+    // Input ran out, as with a script piped in: let the last search finish and report
+    engine.WaitForSearch();
+}
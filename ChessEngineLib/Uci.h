@@ -0,0 +1,22 @@
+/**
+ * @file Uci.h
+ * @author John Korreck
+ *
+ * The engine behind the Universal Chess Interface, so a match runner or a GUI
+ * can drive it as a separate process.
+ */
+
+#ifndef UCI_H
+#define UCI_H
+
+#include <iosfwd>
+#include <string>
+
+/// Answers UCI commands from `in` until "quit" or the end of input. Searches run on
+/// their own thread, so "stop" and "isready" are answered while one is going.
+void RunUci(std::istream& in, std::ostream& out);
+
+/// A score from the side to move's point of view as UCI writes it: "cp 35" or "mate -3"
+std::string FormatScore(int score);
+
+#endif //UCI_H
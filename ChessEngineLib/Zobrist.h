@@ -0,0 +1,45 @@
+/**
+ * @file Zobrist.h
+ * @author John Korreck
+ *
+ * Zobrist hashing keys, generated at compile time.
+ */
+
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+struct ZobristKeys {
+    uint64_t pieces[13][64]; // indexed by piece + 6, so black pieces come first
+    uint64_t side;
+    uint64_t castling[16];
+    uint64_t enPassant[8];
+};
+
+constexpr uint64_t ZobristNext(uint64_t& state) {
+    // splitmix64
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys GenerateZobristKeys() {
+    ZobristKeys keys{};
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (int piece = 0; piece < 13; piece++) {
+        for (int square = 0; square < 64; square++) {
+            // The empty "piece" hashes to nothing
+            keys.pieces[piece][square] = piece == 6 ? 0 : ZobristNext(state);
+        }
+    }
+    keys.side = ZobristNext(state);
+    for (auto& key : keys.castling) key = ZobristNext(state);
+    for (auto& key : keys.enPassant) key = ZobristNext(state);
+    return keys;
+}
+
+inline constexpr ZobristKeys Zobrist = GenerateZobristKeys();
+
+#endif //ZOBRIST_H
@@ -0,0 +1,94 @@
+/**
+ * @file AllocationTest.cpp
+ * @author John Korreck
+ *
+ * Checks that the search hot path does not touch the heap once warmed up.
+ */
+
+#include "gtest/gtest.h"
+#include "AllocationTracker.h"
+#include "Board.h"
+#include "Engine.h"
+
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+#ifndef CHESS_TRACK_ALLOCATIONS
+// Outside the instrumentation build the tests count with hooks of their own
+void* operator new(std::size_t size) {
+    CountAllocation(size);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+#endif
+
+static uint64_t Allocations() {
+    return ThreadAllocations().allocations;
+}
+
+static long perft(Board& board, int depth) {
+    MoveList moves;
+    board.GenerateMoves(moves);
+    if (depth == 1) return moves.Size();
+
+    long count = 0;
+    for (Move move : moves) {
+        board.MakeMove(move);
+        count += perft(board, depth - 1);
+        board.UndoMove();
+    }
+    return count;
+}
+
+TEST(AllocationTest, MoveGenerationIsAllocationFree) {
+    std::string name = "Board";
+    std::string position = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -";
+    Board board(name, position);
+    perft(board, 2);
+
+    uint64_t before = Allocations();
+    EXPECT_EQ(perft(board, 3), 97862);
+    EXPECT_EQ(Allocations() - before, 0u);
+}
+
+TEST(AllocationTest, SearchIsAllocationFree) {
+    std::string name = "Board";
+    std::string position = "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3";
+    Board board(name, position);
+    Engine engine;
+    int alpha = std::numeric_limits<int>::min();
+    int beta = std::numeric_limits<int>::max();
+    engine.Minimax(board, 3, true, alpha, beta);
+
+    uint64_t before = Allocations();
+    engine.Minimax(board, 3, true, alpha, beta);
+    EXPECT_EQ(Allocations() - before, 0u);
+}
+
+TEST(AllocationTest, SearchReportsItsAllocations) {
+    std::string name = "Board";
+    std::string position = "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3";
+    Board board(name, position);
+    Engine engine;
+    SearchLimits limits;
+    limits.depth = 4;
+    engine.Search(board, limits);
+    ASSERT_TRUE(AllocationTrackingEnabled());
+
+    // Only the result's lines allocate, a few per iteration however many nodes there are
+    engine.NewGame();
+    uint64_t before = Allocations();
+    SearchResult result = engine.Search(board, limits);
+    EXPECT_EQ(result.allocated.allocations, Allocations() - before);
+    EXPECT_GT(result.nodes, 1000u);
+    EXPECT_LE(result.allocated.allocations, 8u * result.depth);
+}
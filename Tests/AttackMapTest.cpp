@@ -0,0 +1,96 @@
+/**
+ * @file AttackMapTest.cpp
+ * @author John Korreck
+ */
+
+#include "gtest/gtest.h"
+#include "Board.h"
+
+static uint64_t bit(const std::string& square) {
+    return SquareBit(ParseSquare(square));
+}
+
+TEST(AttackMapTest, CheckersAndPins) {
+    std::string name = "Board";
+    // Bishop on b5 pins the d7 knight, rook on e1 gives check through the open e-file
+    std::string position = "4k3/3n4/8/1B6/8/8/8/4RK2 b - - 0 1";
+    Board board(name, position);
+    const AttackMap& attacks = board.GetAttacks();
+
+    EXPECT_EQ(attacks.checkers, bit("e1"));
+    EXPECT_EQ(attacks.pinned[1], bit("d7"));
+    EXPECT_EQ(attacks.pinners[1], bit("b5"));
+    EXPECT_TRUE(board.IsBlackInCheck());
+    EXPECT_FALSE(board.IsWhiteInCheck());
+    EXPECT_TRUE(board.IsPinned(3, 1));
+
+    // The pinned knight can't block on e5, but the king can step off the file
+    EXPECT_FALSE(board.IsLegalMove("d7e5"));
+    EXPECT_TRUE(board.IsLegalMove("e8f7"));
+    EXPECT_TRUE(board.IsLegalMove("e8d8"));
+}
+
+TEST(AttackMapTest, AttacksByPieceType) {
+    std::string name = "Board";
+    std::string position = "4k3/8/8/8/8/8/4P3/1N2K3 w - - 0 1";
+    Board board(name, position);
+    const AttackMap& attacks = board.GetAttacks();
+
+    EXPECT_EQ(attacks.byPiece[0][1], bit("d3") | bit("f3"));
+    EXPECT_EQ(attacks.byPiece[0][2], bit("a3") | bit("c3") | bit("d2"));
+    EXPECT_TRUE(board.IsSquareAttacked(ParseSquare("d3"), true));
+    EXPECT_FALSE(board.IsSquareAttacked(ParseSquare("e3"), true));
+    EXPECT_EQ(attacks.checkers, 0u);
+}
+
+TEST(AttackMapTest, MapsFollowMakeAndUndo) {
+    std::string name = "Board";
+    std::string position = "4k3/8/8/8/8/8/8/R3K3 w - - 0 1";
+    Board board(name, position);
+    uint64_t before = board.GetAttacks().bySide[0];
+
+    board.MakeMove("a1a8");
+    EXPECT_TRUE(board.IsBlackInCheck());
+    EXPECT_EQ(board.GetAttacks().checkers, bit("a8"));
+    board.UndoMove();
+
+    EXPECT_FALSE(board.IsBlackInCheck());
+    EXPECT_EQ(board.GetAttacks().bySide[0], before);
+}
+
+TEST(AttackMapTest, StaticExchange) {
+    std::string name = "Board";
+
+    // Rook takes a pawn defended by a pawn: wins 100, then loses 500
+    std::string position = "4k3/8/2p5/3p4/8/8/8/3RK3 w - - 0 1";
+    Board defended(name, position);
+    EXPECT_FALSE(defended.SeeAtLeast(defended.ParseMove("d1d5")));
+    EXPECT_TRUE(defended.SeeAtLeast(defended.ParseMove("d1d5"), -400));
+    EXPECT_FALSE(defended.SeeAtLeast(defended.ParseMove("d1d5"), -399));
+
+    // A queen behind the rook backs it up through the x-ray: RxP, RxR, QxR
+    position = "3rk3/8/8/3p4/8/8/3R4/3QK3 w - - 0 1";
+    Board xray(name, position);
+    EXPECT_TRUE(xray.SeeAtLeast(xray.ParseMove("d2d5")));
+    EXPECT_TRUE(xray.SeeAtLeast(xray.ParseMove("d2d5"), 100));
+    EXPECT_FALSE(xray.SeeAtLeast(xray.ParseMove("d2d5"), 101));
+
+    // The same exchange with the black rook doubled behind the pawn's defender loses the rook
+    position = "3rk3/3r4/8/3p4/8/8/3R4/3QK3 w - - 0 1";
+    Board doubled(name, position);
+    EXPECT_FALSE(doubled.SeeAtLeast(doubled.ParseMove("d2d5")));
+
+    // A pinned defender doesn't count, and the king can't recapture into a defended square
+    position = "3k4/8/3n4/5p2/6P1/8/8/3R1K2 w - - 0 1";
+    Board pinned(name, position);
+    EXPECT_TRUE(pinned.SeeAtLeast(pinned.ParseMove("g4f5"), 100));
+    position = "8/8/4k3/3p4/4P3/8/8/3RK3 w - - 0 1";
+    Board guarded(name, position);
+    EXPECT_TRUE(guarded.SeeAtLeast(guarded.ParseMove("e4d5"), 100));
+
+    // Quiet moves onto attacked squares
+    position = "4k3/8/8/4p3/8/5N2/8/4K3 w - - 0 1";
+    Board quiet(name, position);
+    EXPECT_FALSE(quiet.SeeAtLeast(quiet.ParseMove("f3d4")));
+    EXPECT_TRUE(quiet.SeeAtLeast(quiet.ParseMove("f3h4")));
+}
@@ -0,0 +1,75 @@
+/**
+ * @file DataGenTest.cpp
+ * @author John Korreck
+ */
+
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "DataGen.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+TEST(DataGenTest, WritesShardsOfQuietPositions) {
+    DataGenSettings settings;
+    settings.positions = 150;
+    settings.threads = 2;
+    settings.nodes = 300;
+    settings.maxMoves = 60;
+    settings.shardRecords = 40;
+    settings.output = "/tmp/chessengine-datagen-" + std::to_string(getpid());
+
+    DataGenerator generator(settings);
+    uint64_t reported = 0;
+    ASSERT_TRUE(generator.Run([&](uint64_t positions, uint64_t) { reported = positions; }));
+    EXPECT_EQ(generator.Positions(), settings.positions);
+    EXPECT_EQ(reported, settings.positions);
+    EXPECT_GT(generator.Games(), 0u);
+
+    std::vector<TrainingRecord> records;
+    for (int thread = 0; thread < settings.threads; thread++) {
+        for (int shard = 0;; shard++) {
+            char path[256];
+            std::snprintf(path, sizeof(path), "%s-%02d-%04d.bin", settings.output.c_str(), thread, shard);
+            std::FILE* file = std::fopen(path, "rb");
+            if (!file) break;
+
+            ShardHeader header;
+            ASSERT_EQ(std::fread(&header, sizeof(header), 1, file), 1u);
+            EXPECT_EQ(std::memcmp(header.magic, "CEDATA1", 8), 0);
+            EXPECT_EQ(header.version, 2u);
+            EXPECT_EQ(header.recordBytes, sizeof(TrainingRecord));
+            TrainingRecord record;
+            size_t count = 0;
+            while (std::fread(&record, sizeof(record), 1, file) == 1) {
+                records.push_back(record);
+                count++;
+            }
+            EXPECT_LE(count, settings.shardRecords);
+            std::fclose(file);
+            std::remove(path);
+        }
+    }
+    ASSERT_EQ(records.size(), settings.positions);
+
+    // Every record unpacks to a position with both kings, in which the move is legal
+    std::string name = "Board";
+    std::string start = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    Board board(name, start);
+    MoveList moves;
+    for (const TrainingRecord& record : records) {
+        board.Unpack(record.position);
+        EXPECT_GE(board.GetKingSquare(true), 0);
+        EXPECT_GE(board.GetKingSquare(false), 0);
+        board.GenerateMoves(moves);
+        EXPECT_TRUE(moves.Contains(Move::FromRaw(record.move))) << UnpackFen(record.position);
+        EXPECT_FALSE(board.GetAttacks().checkers);
+        EXPECT_GE(record.result, -1);
+        EXPECT_LE(record.result, 1);
+        EXPECT_LT(std::abs(record.score), settings.maxScore);
+    }
+}
@@ -53,4 +53,15 @@ TEST(MoveGenerationTest, DifficultPositionDepth3) {
     std::cout << "Count " << count << std::endl;
 
     EXPECT_EQ(count, 97862);
-}
\ No newline at end of file
+}
+// Promotions (including under-promotions) and castling rights lost to captures
+TEST(MoveGenerationTest, PromotionPositionDepth3) {
+    std::string name = "Board";
+    std::string position = "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1";
+    Board board(name, position);
+
+    int count = countMoves(board, 3);
+    std::cout << "Count " << count << std::endl;
+
+    EXPECT_EQ(count, 9467);
+}
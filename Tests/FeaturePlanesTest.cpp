@@ -0,0 +1,71 @@
+/**
+ * @file FeaturePlanesTest.cpp
+ * @author John Korreck
+ */
+
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "FeaturePlanes.h"
+
+#include <cstdint>
+#include <numeric>
+
+static int PlaneSum(const std::vector<uint8_t>& features, int plane) {
+    return std::accumulate(features.begin() + plane * 64, features.begin() + (plane + 1) * 64, 0);
+}
+
+TEST(FeaturePlanesTest, StartPosition) {
+    std::vector<uint8_t> features(FeatureSize);
+    ASSERT_TRUE(EncodeFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", features.data()));
+
+    // White pawns fill the second rank, which is rank index 6
+    EXPECT_EQ(PlaneSum(features, 0), 8);
+    for (int file = 0; file < 8; file++) {
+        EXPECT_EQ(features[6 * 8 + file], 1);
+    }
+    EXPECT_EQ(features[5 * 64 + 7 * 8 + 4], 1); // white king on e1
+    EXPECT_EQ(features[11 * 64 + 0 * 8 + 4], 1); // black king on e8
+    EXPECT_EQ(PlaneSum(features, 12), 64);
+    for (int plane = 13; plane < 17; plane++) {
+        EXPECT_EQ(PlaneSum(features, plane), 64);
+    }
+    EXPECT_EQ(PlaneSum(features, 17), 0);
+}
+
+TEST(FeaturePlanesTest, FenMatchesBoard) {
+    std::string name = "Board";
+    std::string position = "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w Kq f6 0 3";
+    Board board(name, position);
+
+    std::vector<float> fromFen(FeatureSize);
+    std::vector<float> fromBoard(FeatureSize);
+    ASSERT_TRUE(EncodeFen(position, fromFen.data()));
+    EncodeBoard(board, fromBoard.data());
+    EXPECT_EQ(fromFen, fromBoard);
+    EXPECT_EQ(fromFen[17 * 64 + ParseSquare("f6")], 1.0f);
+
+    // Only w and b are a side to move
+    EXPECT_FALSE(EncodeFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1", fromFen.data()));
+    EXPECT_FALSE(EncodeFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR white KQkq - 0 1", fromFen.data()));
+    EXPECT_TRUE(std::all_of(fromFen.begin(), fromFen.end(), [](float value) { return value == 0; }));
+}
+
+TEST(FeaturePlanesTest, BatchAcrossThreads) {
+    std::vector<std::string> fens;
+    for (int i = 0; i < 1000; i++) {
+        fens.push_back(i % 2 ? "8/5pk1/6p1/8/3R4/6P1/5PK1/2r5 w - - 0 40"
+                             : "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R b KQ - 0 8");
+    }
+    fens[500] = "not a position";
+
+    std::vector<uint8_t> batch(fens.size() * FeatureSize);
+    EXPECT_EQ(EncodeFens(fens, batch.data(), 4), 1u);
+
+    std::vector<uint8_t> single(FeatureSize);
+    for (size_t i : {0, 1, 499, 999}) {
+        EncodeFen(fens[i], single.data());
+        EXPECT_TRUE(std::equal(single.begin(), single.end(), batch.begin() + i * FeatureSize));
+    }
+    EXPECT_TRUE(std::all_of(batch.begin() + 500 * FeatureSize, batch.begin() + 501 * FeatureSize,
+                            [](uint8_t value) { return value == 0; }));
+}
@@ -0,0 +1,131 @@
+/**
+ * @file GameSessionTest.cpp
+ * @author John Korreck
+ */
+
+#include "gtest/gtest.h"
+#include "GameSession.h"
+#include "SearchScheduler.h"
+
+#include <chrono>
+#include <thread>
+
+TEST(GameSessionTest, PushAndPop) {
+    SearchScheduler scheduler(1);
+    GameSession session(scheduler);
+
+    EXPECT_TRUE(session.Push("e2e4"));
+    EXPECT_FALSE(session.Push("e2e4"));
+    EXPECT_TRUE(session.Push("c7c5"));
+    EXPECT_EQ(session.Moves().size(), 2u);
+    EXPECT_EQ(session.Fen(), "rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq c6 0 2");
+
+    EXPECT_TRUE(session.Pop());
+    EXPECT_TRUE(session.Pop());
+    EXPECT_FALSE(session.Pop());
+    EXPECT_EQ(session.Fen(), GameSession::StartPosition);
+}
+
+TEST(GameSessionTest, DrawsByRule) {
+    SearchScheduler scheduler(1);
+    GameSession session(scheduler);
+
+    // The start position comes round for the third time
+    for (int i = 0; i < 2; i++) {
+        EXPECT_EQ(session.State(), GameState::Ongoing);
+        for (const char* move : {"g1f3", "g8f6", "f3g1", "f6g8"}) {
+            ASSERT_TRUE(session.Push(move));
+        }
+    }
+    EXPECT_EQ(session.State(), GameState::Repetition);
+
+    GameSession quiet(scheduler, "8/8/4k3/8/8/3K4/8/7R w - - 99 80");
+    EXPECT_EQ(quiet.State(), GameState::Ongoing);
+    quiet.Push("h1h2");
+    EXPECT_EQ(quiet.State(), GameState::FiftyMoves);
+
+    GameSession mated(scheduler, "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3");
+    EXPECT_EQ(mated.State(), GameState::Checkmate);
+}
+
+TEST(GameSessionTest, FollowUpSearchReusesTheLastOne) {
+    const char* middlegame = "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8";
+    SearchScheduler scheduler(1);
+    GameSession session(scheduler, middlegame);
+
+    SearchLimits limits;
+    limits.depth = 5;
+    SearchResult first = session.BestMove(limits);
+    ASSERT_GE(first.lines[0].pv.size(), 3u);
+    Move reply = first.lines[0].pv[1];
+    ASSERT_TRUE(session.Push(first.bestMove.ToString()));
+    ASSERT_TRUE(session.Push(reply.ToString()));
+    EXPECT_EQ(session.ExpectedLine().front(), first.lines[0].pv[2]);
+
+    SearchResult followUp = session.BestMove(limits);
+
+    // The same position searched cold
+    SearchScheduler cold(1);
+    SearchResult fresh = cold.Submit(session.Fen(), limits)->Result();
+    EXPECT_EQ(followUp.depth, 5);
+    EXPECT_LT(followUp.nodes, fresh.nodes);
+}
+
+TEST(GameSessionTest, PonderTakesOverOnPredictedReply) {
+    const char* middlegame = "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8";
+    SearchScheduler scheduler(1);
+    GameSession session(scheduler, middlegame);
+    session.SetPondering(true);
+
+    SearchLimits limits;
+    limits.depth = 4;
+    SearchResult first = session.BestMove(limits);
+    ASSERT_GE(first.lines[0].pv.size(), 2u);
+    EXPECT_TRUE(session.IsPondering());
+
+    // The opponent takes a while to reply with the move we expected
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_TRUE(session.Push(first.lines[0].pv[0].ToString()));
+    ASSERT_TRUE(session.Push(first.lines[0].pv[1].ToString()));
+    EXPECT_TRUE(session.IsPondering());
+
+    // The ponder has already had more than the budget, so the answer is immediate
+    SearchLimits timed;
+    timed.moveTimeMs = 200;
+    LimitDecision decision;
+    decision.adaptive = true;
+    decision.moveTimeMs = timed.moveTimeMs;
+    auto start = std::chrono::steady_clock::now();
+    session.Go(timed, 0, decision);
+    SearchResult result = session.Result();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_LT(elapsed, std::chrono::milliseconds(50));
+    EXPECT_GE(result.timeMs, 200);
+    EXPECT_GE(result.depth, 4);
+    // Reported with the limits the caller chose, not the ponder's
+    EXPECT_TRUE(result.decision.adaptive);
+    EXPECT_EQ(result.decision.moveTimeMs, 200);
+}
+
+TEST(GameSessionTest, UnexpectedReplyDropsPonder) {
+    SearchScheduler scheduler(1);
+    GameSession session(scheduler);
+    session.SetPondering(true);
+
+    SearchLimits limits;
+    limits.depth = 3;
+    SearchResult first = session.BestMove(limits);
+    ASSERT_GE(first.lines[0].pv.size(), 2u);
+    ASSERT_TRUE(session.Push(first.bestMove.ToString()));
+    EXPECT_TRUE(session.IsPondering());
+
+    // Any reply but the expected one
+    MoveList replies;
+    Board board = session.GetBoard();
+    board.GenerateMoves(replies);
+    Move other = replies[0] == first.lines[0].pv[1] ? replies[1] : replies[0];
+    ASSERT_TRUE(session.Push(other.ToString()));
+    EXPECT_FALSE(session.IsPondering());
+    EXPECT_TRUE(session.ExpectedLine().empty());
+}
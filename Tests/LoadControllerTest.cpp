@@ -0,0 +1,101 @@
+/**
+ * @file LoadControllerTest.cpp
+ * @author John Korreck
+ */
+
+#include "gtest/gtest.h"
+#include "LoadController.h"
+#include "GameSession.h"
+#include "SearchScheduler.h"
+
+TEST(LoadControllerTest, IdleSearchesGetTheWholeBudget) {
+    LoadController controller(1000, 20);
+    controller.Record(100, false, 1000000, 1000);
+
+    LimitDecision decision;
+    ASSERT_TRUE(controller.Decide(0, 4, decision));
+    EXPECT_TRUE(decision.adaptive);
+    EXPECT_EQ(decision.moveTimeMs, 900);
+    EXPECT_EQ(decision.nodes, 0u);
+    EXPECT_DOUBLE_EQ(decision.nps, 1000000.0);
+}
+
+TEST(LoadControllerTest, BurstsShrinkNodeBudgetsThenRefuse) {
+    LoadController controller(1000, 20);
+    controller.Record(100, false, 1000000, 1000);
+
+    // Eight searches on four threads: half a thread's worth each
+    LimitDecision decision;
+    ASSERT_TRUE(controller.Decide(7, 4, decision));
+    EXPECT_EQ(decision.queued, 7u);
+    EXPECT_EQ(decision.nodes, 450000u);
+
+    // A share below the minimum budget isn't worth searching
+    EXPECT_FALSE(controller.Decide(1000, 4, decision));
+}
+
+TEST(LoadControllerTest, SlowTailShortensBudgets) {
+    LoadController controller(1000, 20);
+    for (int i = 0; i < 20; i++) {
+        controller.Record(1500, true, 0, 0);
+    }
+    EXPECT_DOUBLE_EQ(controller.P99Ms(), 1500.0);
+
+    LimitDecision decision;
+    ASSERT_TRUE(controller.Decide(0, 1, decision));
+    EXPECT_LT(decision.moveTimeMs, 900);
+    int64_t backedOff = decision.moveTimeMs;
+
+    // Once the tail is well under target again, budgets recover
+    for (size_t i = 0; i < LoadController::Window; i++) {
+        controller.Record(200, true, 0, 0);
+    }
+    ASSERT_TRUE(controller.Decide(0, 1, decision));
+    EXPECT_GT(decision.moveTimeMs, backedOff);
+}
+
+TEST(LoadControllerTest, SchedulerPlansAndReports) {
+    SearchScheduler scheduler(1);
+    scheduler.Controller().SetTarget(200, 10);
+
+    SearchLimits limits;
+    LimitDecision decision;
+    ASSERT_TRUE(scheduler.Plan(limits, decision));
+    EXPECT_EQ(limits.moveTimeMs, 180);
+
+    SearchResult result = scheduler.Submit("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", limits, 0, decision)->Result();
+    EXPECT_TRUE(result.decision.adaptive);
+    EXPECT_EQ(result.decision.moveTimeMs, 180);
+    EXPECT_LE(result.timeMs, 200);
+    EXPECT_GT(scheduler.Controller().P99Ms(), 0.0);
+}
+
+TEST(LoadControllerTest, PondersDontCountAsLoad) {
+    const char* start = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    const char* middlegame = "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8";
+    SearchScheduler scheduler(1);
+    scheduler.Controller().Record(100, false, 1000000, 1000);
+
+    // Ponders only run when nothing more urgent is waiting, so a request gets the whole thread
+    std::vector<std::shared_ptr<SearchJob>> ponders;
+    for (const char* fen : {start, middlegame}) {
+        ponders.push_back(scheduler.Submit(fen, SearchLimits(), GameSession::PonderPriority));
+    }
+    SearchLimits limits;
+    LimitDecision decision;
+    ASSERT_TRUE(scheduler.Plan(limits, decision));
+    EXPECT_EQ(decision.queued, 0u);
+    EXPECT_EQ(decision.nodes, 0u);
+
+    // A ponder promoted to the real search competes like any other
+    scheduler.Promote(ponders[0], SearchLimits(), 0);
+    ASSERT_TRUE(scheduler.Plan(limits, decision));
+    EXPECT_EQ(decision.queued, 1u);
+    EXPECT_GT(decision.nodes, 0u);
+
+    for (auto& ponder : ponders) {
+        ponder->Cancel();
+        ponder->Wait();
+    }
+    EXPECT_EQ(scheduler.Competing(), 0u);
+}
@@ -0,0 +1,111 @@
+/**
+ * @file MatchTest.cpp
+ * @author John Korreck
+ */
+
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Match.h"
+#include "Sprt.h"
+#include "Uci.h"
+
+#include <sstream>
+
+TEST(MatchTest, EloAndSprt) {
+    MatchScore even{100, 100, 100};
+    EXPECT_NEAR(EloFromScore(even), 0.0, 1e-9);
+    EXPECT_GT(EloErrorMargin(even), 0.0);
+
+    // 75% is about +191 Elo
+    MatchScore strong{150, 0, 50};
+    EXPECT_NEAR(EloFromScore(strong), 190.8, 0.1);
+
+    Sprt sprt(0, 5, 0.05, 0.05);
+    EXPECT_NEAR(sprt.UpperBound(), 2.944, 0.001);
+    EXPECT_NEAR(sprt.LowerBound(), -2.944, 0.001);
+    EXPECT_EQ(sprt.Decide(MatchScore{}), SprtDecision::Continue);
+    EXPECT_EQ(sprt.Decide(strong), SprtDecision::Continue);
+    EXPECT_EQ(sprt.Decide(MatchScore{600, 0, 200}), SprtDecision::AcceptH1);
+    EXPECT_EQ(sprt.Decide(MatchScore{100, 200, 300}), SprtDecision::AcceptH0);
+    EXPECT_EQ(sprt.Decide(MatchScore{11, 20, 10}), SprtDecision::Continue);
+}
+
+TEST(MatchTest, UciSession) {
+    std::istringstream in("uci\n"
+                          "isready\n"
+                          "position startpos moves e2e4 e7e5\n"
+                          "go depth 2\n");
+    std::ostringstream out;
+    RunUci(in, out);
+
+    std::string text = out.str();
+    EXPECT_NE(text.find("uciok"), std::string::npos);
+    EXPECT_NE(text.find("readyok"), std::string::npos);
+    EXPECT_NE(text.find("info depth 2 score cp"), std::string::npos);
+
+    size_t best = text.find("bestmove ");
+    ASSERT_NE(best, std::string::npos);
+    std::string name = "Board";
+    std::string position = "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2";
+    Board board(name, position);
+    EXPECT_TRUE(board.IsLegalMove(text.substr(best + 9, 4)));
+
+    EXPECT_EQ(FormatScore(Engine::MateScore - 3), "mate 2");
+    EXPECT_EQ(FormatScore(-(Engine::MateScore - 2)), "mate -1");
+}
+
+TEST(MatchTest, UciStopEndsAnInfiniteSearch) {
+    // Stop arrives straight after go, likely before the search thread has started
+    std::istringstream in("position startpos\n"
+                          "go infinite wtime 10 btime 10\n"
+                          "stop\n"
+                          "isready\n");
+    std::ostringstream out;
+    RunUci(in, out);
+
+    std::string text = out.str();
+    size_t best = text.find("bestmove ");
+    ASSERT_NE(best, std::string::npos);
+    EXPECT_LT(best, text.find("readyok"));
+
+    // At the end of the input an infinite search is stopped rather than waited on
+    std::istringstream unstopped("position startpos\ngo infinite\n");
+    std::ostringstream reported;
+    RunUci(unstopped, reported);
+    EXPECT_NE(reported.str().find("bestmove "), std::string::npos);
+}
+
+TEST(MatchTest, GamesEndAndAreScored) {
+    MatchSettings settings;
+    settings.baseMs = 0;
+    settings.depth = 1;
+    settings.maxMoves = 40;
+
+    // Mate in one for white
+    EnginePlayer white;
+    EnginePlayer black;
+    GameRecord mate = PlayGame(white, black, "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", settings);
+    EXPECT_EQ(mate.outcome, GameOutcome::WhiteWins);
+    EXPECT_EQ(mate.reason, "checkmate");
+    ASSERT_EQ(mate.moves.size(), 1u);
+    EXPECT_EQ(mate.moves[0].ToString(), "a1a8");
+
+    GameRecord bare = PlayGame(white, black, "8/8/4k3/8/8/3NK3/8/8 w - - 0 1", settings);
+    EXPECT_EQ(bare.outcome, GameOutcome::Draw);
+    EXPECT_EQ(bare.reason, "insufficient material");
+
+    // A short match between two in-process engines, both colours of each opening
+    settings.games = 4;
+    settings.concurrency = 2;
+    settings.sprt = false;
+    Match match(ParsePlayer("engine"), ParsePlayer("engine:Hash=1"), settings);
+    int played = 0;
+    MatchScore score = match.Run([&played](const GameRecord&, const MatchScore&) { played++; });
+    EXPECT_EQ(score.Games(), 4);
+    EXPECT_EQ(played, 4);
+    EXPECT_EQ(match.FailedWorkers(), 0);
+
+    EXPECT_FALSE(ParsePlayer("engine:Hash"));
+    EXPECT_FALSE(ParsePlayer("uci:"));
+    EXPECT_FALSE(ParsePlayer("stockfish"));
+}
@@ -50,4 +50,30 @@ TEST(MoveGenerationTest, InitialPositionDepth3) {
 
     // Test depth 4 (should be 400 moves for initial position)
     EXPECT_EQ(count, 8902);
-}
\ No newline at end of file
+}
+// Evasions must not drop any legal reply to check
+TEST(MoveGenerationTest, EvasionsMatchFilteredMoves) {
+    std::string name = "Board";
+    for (std::string position : {std::string("4k3/8/8/8/8/8/3q4/4K2R w K - 0 1"),
+                                 std::string("4k3/8/8/2pP4/1K6/8/8/8 w - c6 0 1"),
+                                 std::string("r3k3/8/8/8/8/5n2/8/4K1NR w K - 0 1"),
+                                 std::string("4k3/8/8/8/1b6/8/8/R3K2R w KQ - 0 1")}) {
+        Board board(name, position);
+        ASSERT_TRUE(board.IsWhiteInCheck()) << position;
+
+        MoveList evasions;
+        board.GeneratePseudoLegalMoves(evasions, GenType::Evasions);
+        MoveList all;
+        board.GeneratePseudoLegalMoves(all, GenType::All);
+
+        MoveList legal;
+        board.GenerateMoves(legal);
+        for (Move move : all) {
+            if (board.IsLegal(move)) {
+                EXPECT_TRUE(evasions.Contains(move)) << move.ToString() << " in " << position;
+                EXPECT_TRUE(legal.Contains(move)) << move.ToString() << " in " << position;
+            }
+        }
+        EXPECT_LE(evasions.Size(), all.Size());
+    }
+}
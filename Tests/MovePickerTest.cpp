@@ -0,0 +1,91 @@
+/**
+ * @file MovePickerTest.cpp
+ * @author John Korreck
+ */
+
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Engine.h"
+#include "MovePicker.h"
+
+static const char* kiwipete = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+
+TEST(MovePickerTest, YieldsEachLegalMoveOnce) {
+    std::string name = "Board";
+    for (std::string position : {std::string(kiwipete),
+                                 std::string("8/2P5/8/8/8/8/3pk3/K7 b - - 0 1"),
+                                 std::string("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1")}) {
+        Board board(name, position);
+        MoveList legal;
+        board.GenerateMoves(legal);
+
+        // A quiet TT move and a killer that isn't even pseudo-legal here
+        Move ttMove = legal[legal.Size() - 1];
+        Move killers[2] = {Move(0, 63), legal[0]};
+        MovePicker picker(board, ttMove, killers);
+
+        MoveList picked;
+        for (Move move = picker.Next(); !move.IsNull(); move = picker.Next()) {
+            EXPECT_FALSE(picked.Contains(move)) << move.ToString() << " in " << position;
+            picked.Add(move);
+        }
+
+        EXPECT_EQ(picked.Size(), legal.Size()) << position;
+        EXPECT_EQ(picked[0], ttMove);
+        for (Move move : legal) {
+            EXPECT_TRUE(picked.Contains(move)) << move.ToString() << " in " << position;
+        }
+    }
+}
+
+TEST(MovePickerTest, WinningCapturesFirstLosingCapturesLast) {
+    std::string name = "Board";
+    std::string position = kiwipete;
+    Board board(name, position);
+    Move killers[2] = {};
+    MovePicker picker(board, Move(), killers);
+
+    // 0: captures that hold material, 1: quiets, 2: captures that lose it
+    int stage = 0;
+    int losing = 0;
+    for (Move move = picker.Next(); !move.IsNull(); move = picker.Next()) {
+        int moveStage = !board.IsTactical(move) ? 1 : board.SeeAtLeast(move) ? 0 : 2;
+        EXPECT_GE(moveStage, stage) << move.ToString();
+        stage = std::max(stage, moveStage);
+        if (moveStage == 2) losing++;
+    }
+    EXPECT_EQ(stage, 2);
+
+    // Quiescence sees only the captures that don't lose material
+    MovePicker quiescence(board);
+    int captures = 0;
+    for (Move move = quiescence.Next(); !move.IsNull(); move = quiescence.Next()) {
+        EXPECT_TRUE(board.IsTactical(move) && board.SeeAtLeast(move)) << move.ToString();
+        captures++;
+    }
+    EXPECT_GT(captures, 0);
+    EXPECT_GT(losing, 0);
+}
+
+TEST(MovePickerTest, RejectsMovesFromOtherPositions) {
+    std::string name = "Board";
+    std::string position = kiwipete;
+    Board board(name, position);
+
+    EXPECT_TRUE(board.IsPseudoLegal(board.ParseMove("e1g1")));
+    EXPECT_TRUE(board.IsPseudoLegal(board.ParseMove("a2a4")));
+    EXPECT_FALSE(board.IsPseudoLegal(board.ParseMove("a1a3"))); // blocked by a2
+    EXPECT_FALSE(board.IsPseudoLegal(board.ParseMove("e8g8"))); // black's king
+    EXPECT_FALSE(board.IsPseudoLegal(board.ParseMove("f3f7")));  // blocked by f6
+    EXPECT_FALSE(board.IsPseudoLegal(board.ParseMove("c3c4")));  // knight geometry
+}
+
+TEST(MovePickerTest, SearchFindsMateWithTable) {
+    std::string name = "Board";
+    std::string position = "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1";
+    Board board(name, position);
+    Engine engine;
+
+    EXPECT_EQ(engine.FindBestMove(board, 3), "a1a8");
+    EXPECT_GT(engine.GetTranspositionTable().Size(), 0u);
+}
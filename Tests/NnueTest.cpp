@@ -0,0 +1,139 @@
+/**
+ * @file NnueTest.cpp
+ * @author John Korreck
+ */
+
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Engine.h"
+#include "Nnue.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+// Writes a network with small random weights so accumulators cannot overflow
+static std::string writeRandomNetwork() {
+    std::string path = testing::TempDir() + "random.nnue";
+    std::vector<char> bytes(NnueNetwork::FileSize());
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> small(-8, 8);
+    for (size_t i = sizeof(NnueFileHeader); i < bytes.size(); i++) {
+        bytes[i] = static_cast<char>(small(rng));
+    }
+
+    NnueFileHeader header{};
+    std::memcpy(header.magic, NnueNetwork::Magic, sizeof(header.magic));
+    header.version = NnueNetwork::Version;
+    header.featureCount = NnueNetwork::FeatureCount;
+    header.halfDimensions = NnueNetwork::HalfDimensions;
+    header.l1Size = NnueNetwork::L1Size;
+    header.l2Size = NnueNetwork::L2Size;
+    std::memcpy(bytes.data(), &header, sizeof(header));
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    return path;
+}
+
+static bool sameAccumulator(const NnueAccumulator& a, const NnueAccumulator& b) {
+    return std::memcmp(a.values, b.values, sizeof(a.values)) == 0;
+}
+
+// Plays a line and compares the incremental accumulators against a fresh refresh after each move
+static void checkLine(const NnueNetwork& network, std::string position, const std::vector<std::string>& line) {
+    std::string name = "Board";
+    Board board(name, position);
+    board.SetNetwork(&network);
+
+    for (const auto& move : line) {
+        board.MakeMove(move);
+
+        std::string fen = board.GenerateFen();
+        Board fresh(name, fen);
+        fresh.SetNetwork(&network);
+        EXPECT_TRUE(sameAccumulator(board.GetAccumulator(), fresh.GetAccumulator())) << "after " << move;
+    }
+
+    for (size_t i = 0; i < line.size(); i++) {
+        board.UndoMove();
+    }
+    Board original(name, position);
+    original.SetNetwork(&network);
+    EXPECT_TRUE(sameAccumulator(board.GetAccumulator(), original.GetAccumulator()));
+    EXPECT_EQ(board.GenerateFen(), original.GenerateFen());
+}
+
+TEST(NnueTest, RejectsMissingAndMalformedFiles) {
+    NnueNetwork network;
+    EXPECT_FALSE(network.Load(testing::TempDir() + "does-not-exist.nnue"));
+
+    std::string path = testing::TempDir() + "short.nnue";
+    std::ofstream(path, std::ios::binary) << "not a network";
+    EXPECT_FALSE(network.Load(path));
+    EXPECT_FALSE(network.IsLoaded());
+}
+
+TEST(NnueTest, IncrementalUpdatesMatchRefresh) {
+    NnueNetwork network;
+    ASSERT_TRUE(network.Load(writeRandomNetwork()));
+
+    std::string position = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -";
+
+    // Captures, castling and king moves
+    checkLine(network, position, {"e1g1", "a6e2", "c3e2", "e8c8", "d5e6", "c7c5", "e6f7", "b4b3", "d2h6"});
+
+    // En passant and promotion
+    checkLine(network, "4k3/1P6/8/3pP3/8/8/8/4K3 w - d6 0 1", {"e5d6", "e8f7", "b7b8", "f7e6"});
+}
+
+TEST(NnueTest, SimdKernelsMatchScalar) {
+    NnueNetwork network;
+    ASSERT_TRUE(network.Load(writeRandomNetwork()));
+
+    std::string name = "Board";
+    std::string position = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -";
+    NnueSimd detected = NnueNetwork::DetectedSimd();
+
+    std::vector<int> evals;
+    for (NnueSimd simd : {NnueSimd::Scalar, NnueSimd::Sse41, NnueSimd::Avx2}) {
+        if (simd > detected) continue;
+        NnueNetwork::SetSimd(simd);
+
+        Board board(name, position);
+        board.SetNetwork(&network);
+        board.MakeMove("e2a6");
+        evals.push_back(network.Evaluate(board.GetAccumulator(), board.IsWhiteTurn()));
+    }
+    NnueNetwork::SetSimd(detected);
+
+    for (int eval : evals) {
+        EXPECT_EQ(eval, evals.front());
+    }
+}
+
+TEST(NnueTest, EngineOption) {
+    Engine engine;
+    EXPECT_FALSE(engine.SetOption("UseNNUE", "true"));
+    EXPECT_FALSE(engine.IsNnueActive());
+
+    ASSERT_TRUE(engine.SetOption("EvalFile", writeRandomNetwork()));
+    EXPECT_TRUE(engine.SetOption("UseNNUE", "true"));
+    EXPECT_TRUE(engine.IsNnueActive());
+
+    std::string name = "Board";
+    std::string position = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    Board board(name, position);
+    EXPECT_EQ(engine.FindBestMove(board, 2).size(), 4u);
+    EXPECT_EQ(board.GenerateFen(), position);
+
+    // Without both kings there's nothing to index the features by
+    std::string kingless = "8/8/8/3q4/8/8/8/4K3 w - - 0 1";
+    Board missingKing(name, kingless);
+    SearchLimits limits;
+    limits.depth = 3;
+    EXPECT_FALSE(engine.Search(missingKing, limits).bestMove.IsNull());
+    EXPECT_EQ(missingKing.GenerateFen(), kingless);
+}
@@ -0,0 +1,79 @@
+/**
+ * @file PackedPositionTest.cpp
+ * @author John Korreck
+ */
+
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Match.h"
+#include "PackedPosition.h"
+
+#include <cstring>
+#include <random>
+#include <string>
+
+TEST(PackedPositionTest, PacksTheFen) {
+    std::string fen = "r3k2r/8/8/3pP3/8/8/8/R3K1NR w Kq d6 3 20";
+    PackedPosition packed;
+    ASSERT_TRUE(PackFen(fen, packed));
+
+    EXPECT_EQ(packed.occupied, uint64_t{1} << 0 | uint64_t{1} << 4 | uint64_t{1} << 7 |
+                               uint64_t{1} << 27 | uint64_t{1} << 28 |
+                               uint64_t{1} << 56 | uint64_t{1} << 60 | uint64_t{1} << 62 | uint64_t{1} << 63);
+    // r k, r p, P R, K N, R
+    const uint8_t pieces[16] = {0xEC, 0x9C, 0x41, 0x26, 0x04};
+    EXPECT_EQ(std::memcmp(packed.pieces, pieces, sizeof(pieces)), 0);
+    EXPECT_EQ(packed.flags, (1 | 8) << 1);
+    EXPECT_EQ(packed.enPassant, 2 * 8 + 3);
+    EXPECT_EQ(packed.halfMoveClock, 3);
+    EXPECT_EQ(packed.fullMoveNumber, 20u);
+    EXPECT_EQ(UnpackFen(packed), fen);
+
+    std::string name = "Board";
+    Board board(name, fen);
+    EXPECT_TRUE(board.Pack() == packed);
+}
+
+TEST(PackedPositionTest, RoundTripsThroughTheBoard) {
+    std::string name = "Board";
+    std::string start = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    Board played(name, start);
+    Board unpacked(name, start);
+    std::mt19937 random(7);
+    MoveList moves;
+
+    for (const std::string& opening : DefaultOpenings()) {
+        std::string fen = opening;
+        played.FenParser(fen);
+        for (int ply = 0; ply < 60; ply++) {
+            PackedPosition packed = played.Pack();
+            std::string expected = played.GenerateFen();
+            ASSERT_EQ(UnpackFen(packed), expected);
+
+            unpacked.Unpack(packed);
+            ASSERT_EQ(unpacked.GenerateFen(), expected);
+            ASSERT_EQ(unpacked.GetKey(), played.GetKey());
+            ASSERT_EQ(unpacked.GetPawnKey(), played.GetPawnKey());
+            if (ply % 20 == 0) {
+                ASSERT_EQ(unpacked.CountMoves(2), played.CountMoves(2)) << expected;
+            }
+
+            played.GenerateMoves(moves);
+            if (moves.Empty()) break;
+            played.MakeMove(moves[static_cast<int>(random() % moves.Size())]);
+        }
+    }
+}
+
+TEST(PackedPositionTest, RejectsMalformedFens) {
+    PackedPosition packed;
+    EXPECT_FALSE(PackFen("", packed));
+    EXPECT_FALSE(PackFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1", packed));
+    EXPECT_FALSE(PackFen("rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", packed));
+    EXPECT_FALSE(PackFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNX w KQkq - 0 1", packed));
+    EXPECT_FALSE(PackFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1", packed));
+    EXPECT_FALSE(PackFen("rnbqkbnr/pppppppp/pppppppp/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", packed));
+    // Clocks may be left off
+    ASSERT_TRUE(PackFen("4k3/8/8/8/8/8/8/4K3 b - -", packed));
+    EXPECT_EQ(UnpackFen(packed), "4k3/8/8/8/8/8/8/4K3 b - - 0 1");
+}
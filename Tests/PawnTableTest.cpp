@@ -0,0 +1,79 @@
+/**
+ * @file PawnTableTest.cpp
+ * @author John Korreck
+ */
+
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Engine.h"
+#include "PawnTable.h"
+
+static uint64_t bit(const std::string& square) {
+    int file = square[0] - 'a';
+    int rank = 8 - (square[1] - '0');
+    return 1ULL << (rank * 8 + file);
+}
+
+TEST(PawnTableTest, PawnKeyIsIncremental) {
+    std::string name = "Board";
+    std::string position = "4k3/1P6/8/3pP3/8/8/5P2/4K3 w - d6 0 1";
+    Board board(name, position);
+    uint64_t startKey = board.GetPawnKey();
+
+    // En passant, promotion, double push and a quiet king move
+    for (const std::string move : {"e5d6", "e8f7", "b7b8", "f7e6", "f2f4"}) {
+        uint64_t before = board.GetPawnKey();
+        board.MakeMove(move);
+
+        std::string fen = board.GenerateFen();
+        Board fresh(name, fen);
+        EXPECT_EQ(board.GetPawnKey(), fresh.GetPawnKey()) << "after " << move;
+        if (move == "e8f7" || move == "f7e6") {
+            EXPECT_EQ(board.GetPawnKey(), before);
+        }
+    }
+
+    for (int i = 0; i < 5; i++) {
+        board.UndoMove();
+    }
+    EXPECT_EQ(board.GetPawnKey(), startKey);
+}
+
+TEST(PawnTableTest, StructureTerms) {
+    std::string name = "Board";
+    // Only the front pawn of the doubled h-pawns counts as passed
+    std::string position = "4k3/p7/8/3P4/8/7P/7P/4K3 w - - 0 1";
+    Board board(name, position);
+
+    PawnTable table;
+    PawnEntry& entry = table.Probe(board);
+    EXPECT_EQ(entry.passed[0], bit("d5") | bit("h3"));
+    EXPECT_EQ(entry.passed[1], bit("a7"));
+
+    // A pawn on c6 stops d5 from being passed
+    std::string blocked = "4k3/p7/2p5/3P4/8/7P/7P/4K3 w - - 0 1";
+    Board blockedBoard(name, blocked);
+    EXPECT_EQ(table.Probe(blockedBoard).passed[0], bit("h3"));
+
+    // Same structure, different pieces: served from the table
+    std::string other = "3qk3/p7/8/3P4/8/7P/7P/3QK3 b - - 0 1";
+    Board otherBoard(name, other);
+    const PawnEntry& cached = table.Probe(otherBoard);
+    EXPECT_EQ(&cached, &entry);
+    EXPECT_EQ(table.Hits(), 1u);
+    EXPECT_EQ(table.Probes(), 3u);
+}
+
+TEST(PawnTableTest, SearchHitRate) {
+    std::string name = "Board";
+    std::string position = "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3";
+    Board board(name, position);
+
+    Engine engine;
+    engine.FindBestMove(board, 3);
+
+    const PawnTable& table = engine.GetPawnTable();
+    ASSERT_GT(table.Probes(), 0u);
+    // Captures are searched first, and those are the moves that change the pawn structure
+    EXPECT_GT(double(table.Hits()) / double(table.Probes()), 0.8);
+}
@@ -0,0 +1,164 @@
+/**
+ * @file SearchSchedulerTest.cpp
+ * @author John Korreck
+ */
+
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "SearchScheduler.h"
+
+#include <chrono>
+#include <thread>
+
+static const char* middlegame = "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8";
+static const char* endgame = "8/5pk1/6p1/8/3R4/6P1/5PK1/2r5 w - - 0 40";
+
+TEST(SearchSchedulerTest, MoreSearchesThanThreads) {
+    SearchScheduler scheduler(2);
+
+    SearchLimits limits;
+    limits.depth = 3;
+    std::vector<std::shared_ptr<SearchJob>> jobs;
+    for (int i = 0; i < 6; i++) {
+        jobs.push_back(scheduler.Submit(i % 2 ? middlegame : endgame, limits));
+    }
+
+    for (int i = 0; i < 6; i++) {
+        const SearchResult& result = jobs[i]->Result();
+        std::string name = "Board";
+        std::string position = i % 2 ? middlegame : endgame;
+        Board board(name, position);
+        EXPECT_TRUE(board.IsLegalMove(result.bestMove.ToString()));
+        EXPECT_EQ(result.depth, 3);
+        EXPECT_FALSE(result.stopped);
+    }
+    EXPECT_EQ(scheduler.Pending(), 0u);
+}
+
+TEST(SearchSchedulerTest, ShortRequestOvertakesDeepOne) {
+    // One thread, already busy with a search that only a cancel can end
+    SearchScheduler scheduler(1);
+    auto deep = scheduler.Submit(middlegame, SearchLimits());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    SearchLimits limits;
+    limits.moveTimeMs = 100;
+    auto start = std::chrono::steady_clock::now();
+    auto urgent = scheduler.Submit(endgame, limits);
+    const SearchResult& result = urgent->Result();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_GE(result.depth, 1);
+    EXPECT_LT(elapsed, std::chrono::milliseconds(200));
+    EXPECT_FALSE(deep->IsDone());
+
+    deep->Cancel();
+    EXPECT_TRUE(deep->Result().stopped);
+    EXPECT_FALSE(deep->Result().bestMove.IsNull());
+}
+
+TEST(SearchSchedulerTest, EqualSearchesShareTheThread) {
+    SearchScheduler scheduler(1);
+    auto first = scheduler.Submit(middlegame, SearchLimits());
+    auto second = scheduler.Submit(endgame, SearchLimits());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    first->Cancel();
+    second->Cancel();
+
+    // Both got time slices, so both completed some iterations
+    EXPECT_GE(first->Result().depth, 1);
+    EXPECT_GE(second->Result().depth, 1);
+}
+
+TEST(SearchSchedulerTest, IdenticalRequestsShareOneSearch) {
+    SearchScheduler scheduler(1);
+    auto deep = scheduler.Submit(middlegame, SearchLimits());
+
+    // Shallower or identical requests ride along; a different position doesn't
+    SearchLimits shallow;
+    shallow.depth = 4;
+    auto same = scheduler.Submit(middlegame, SearchLimits());
+    auto shallower = scheduler.Submit(middlegame, shallow);
+    auto other = scheduler.Submit(endgame, shallow);
+    EXPECT_TRUE(same->SharesSearchWith(*deep));
+    EXPECT_TRUE(shallower->SharesSearchWith(*deep));
+    EXPECT_FALSE(other->SharesSearchWith(*deep));
+    EXPECT_EQ(scheduler.Coalesced(), 2u);
+    EXPECT_EQ(scheduler.Pending(), 2u);
+
+    // The search keeps going until everyone sharing it has cancelled
+    deep->Cancel();
+    same->Cancel();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(deep->IsDone());
+    shallower->Cancel();
+    EXPECT_TRUE(shallower->Result().stopped);
+    EXPECT_EQ(other->Result().depth, 4);
+}
+
+TEST(SearchSchedulerTest, CancellingTwiceCountsOnce) {
+    SearchScheduler scheduler(1);
+    auto first = scheduler.Submit(middlegame, SearchLimits());
+    auto second = scheduler.Submit(middlegame, SearchLimits());
+    ASSERT_TRUE(second->SharesSearchWith(*first));
+
+    // A client that has gone away cancels on every poll; the other is still waiting
+    second->Cancel();
+    second->Cancel();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(first->IsDone());
+
+    first->Cancel();
+    EXPECT_TRUE(second->Result().stopped);
+}
+
+TEST(SearchSchedulerTest, NoOneJoinsASearchBeingCancelled) {
+    SearchScheduler scheduler(1);
+    SearchLimits limits;
+    limits.depth = 5;
+
+    // Whichever wins the race, the new request gets a search that runs to its depth
+    for (int i = 0; i < 20; i++) {
+        auto abandoned = scheduler.Submit(middlegame, limits);
+        std::thread canceller([&abandoned] { abandoned->Cancel(); });
+        auto joining = scheduler.Submit(middlegame, limits);
+        canceller.join();
+        SearchResult result = joining->Result();
+        EXPECT_FALSE(result.stopped);
+        EXPECT_EQ(result.depth, 5);
+        abandoned->Result();
+    }
+}
+
+TEST(SearchSchedulerTest, StreamsEachIteration) {
+    SearchScheduler scheduler(1);
+    auto running = scheduler.Submit(middlegame, SearchLimits());
+
+    // A streamed request gets a search of its own, to see every iteration from the first
+    SearchLimits limits;
+    limits.depth = 4;
+    auto streamed = scheduler.Submit(middlegame, limits, 1, LimitDecision(), true);
+    EXPECT_FALSE(streamed->SharesSearchWith(*running));
+
+    std::vector<SearchResult> iterations;
+    while (true) {
+        bool done = streamed->IsDone();
+        for (SearchResult& iteration : streamed->TakeIterations(std::chrono::milliseconds(50))) {
+            iterations.push_back(std::move(iteration));
+        }
+        if (done) break;
+    }
+    running->Cancel();
+
+    ASSERT_EQ(iterations.size(), 4u);
+    for (size_t i = 0; i < iterations.size(); i++) {
+        EXPECT_EQ(iterations[i].depth, static_cast<int>(i) + 1);
+        EXPECT_FALSE(iterations[i].lines.empty());
+        if (i > 0) {
+            EXPECT_GE(iterations[i].nodes, iterations[i - 1].nodes);
+        }
+    }
+    EXPECT_EQ(iterations.back().bestMove, streamed->Result().bestMove);
+    EXPECT_EQ(iterations.back().score, streamed->Result().score);
+}
@@ -0,0 +1,263 @@
+/**
+ * @file SearchTest.cpp
+ * @author John Korreck
+ */
+
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Engine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+static const char* middlegame = "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8";
+
+TEST(SearchTest, DeadlineReturnsBestSoFar) {
+    std::string name = "Board";
+    std::string position = middlegame;
+    Board board(name, position);
+    Engine engine;
+
+    SearchLimits limits;
+    limits.moveTimeMs = 100;
+    SearchResult result = engine.Search(board, limits);
+
+    EXPECT_TRUE(board.IsLegalMove(result.bestMove.ToString()));
+    EXPECT_GE(result.depth, 1);
+    EXPECT_LT(result.timeMs, 150);
+    EXPECT_GT(result.nodes, 0u);
+
+    // The board is back where it started
+    EXPECT_EQ(board.GenerateFen(), position);
+}
+
+TEST(SearchTest, BoardsWithHistoryBypassTheResultCache) {
+    std::string name = "Board";
+    std::string position = middlegame;
+    Board played(name, position);
+    played.MakeMove("a2a3");
+    played.MakeMove("a7a6");
+    std::string reached = played.GenerateFen();
+    Board fresh(name, reached);
+    Engine engine;
+    SearchLimits limits;
+    limits.depth = 3;
+
+    // A search with history isn't stored for history-free requests...
+    EXPECT_GT(engine.Search(played, limits).nodes, 0u);
+    EXPECT_GT(engine.Search(fresh, limits).nodes, 0u);
+    // ...which are answered from the cache, but not for a board with history
+    EXPECT_EQ(engine.Search(fresh, limits).nodes, 0u);
+    EXPECT_GT(engine.Search(played, limits).nodes, 0u);
+}
+
+TEST(SearchTest, HighHalfMoveClocksBypassTheResultCache) {
+    std::string name = "Board";
+    std::string fresh = "4k3/8/8/8/8/8/8/R3K3 w - - 0 60";
+    std::string drawing = "4k3/8/8/8/8/8/8/R3K3 w - - 99 60";
+    Board freshBoard(name, fresh);
+    Board drawingBoard(name, drawing);
+    Engine engine;
+    SearchLimits limits;
+    limits.depth = 4;
+
+    SearchResult winning = engine.Search(freshBoard, limits);
+    EXPECT_GT(winning.score, 300);
+    // Same key, but one more quiet move is a draw
+    SearchResult drawn = engine.Search(drawingBoard, limits);
+    EXPECT_GT(drawn.nodes, 0u);
+    EXPECT_EQ(drawn.score, 0);
+}
+
+TEST(SearchTest, NodeLimitedResultsAreNotCached) {
+    std::string name = "Board";
+    std::string position = middlegame;
+    Board board(name, position);
+    Engine engine;
+
+    // Cut short under load, then asked again with the same time and no node budget
+    SearchLimits loaded;
+    loaded.moveTimeMs = 1000;
+    loaded.nodes = 2000;
+    SearchResult shallow = engine.Search(board, loaded);
+    EXPECT_LT(shallow.nodes, 2000u + 1024u);
+
+    SearchLimits idle;
+    idle.moveTimeMs = 50;
+    EXPECT_GT(engine.Search(board, idle).nodes, 0u);
+}
+
+TEST(SearchTest, StopFromAnotherThread) {
+    std::string name = "Board";
+    std::string position = middlegame;
+    Board board(name, position);
+    Engine engine;
+
+    std::thread stopper([&engine] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        engine.Stop();
+    });
+
+    // No time limit: only the stop request can end this search
+    auto start = std::chrono::steady_clock::now();
+    SearchResult result = engine.Search(board, SearchLimits());
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    stopper.join();
+
+    EXPECT_TRUE(result.stopped);
+    EXPECT_TRUE(board.IsLegalMove(result.bestMove.ToString()));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(1000));
+
+    // A stop that comes after the search has returned doesn't cut the next one short
+    engine.Stop();
+    SearchLimits limits;
+    limits.depth = 5;
+    SearchResult next = engine.Search(board, limits);
+    EXPECT_FALSE(next.stopped);
+    EXPECT_EQ(next.depth, 5);
+}
+
+TEST(SearchTest, DepthLimitCompletes) {
+    std::string name = "Board";
+    std::string position = middlegame;
+    Board board(name, position);
+    Engine engine;
+
+    SearchLimits limits;
+    limits.depth = 3;
+    SearchResult result = engine.Search(board, limits);
+
+    EXPECT_FALSE(result.stopped);
+    EXPECT_EQ(result.depth, 3);
+    EXPECT_EQ(result.bestMove.ToString(), engine.FindBestMove(board, 3));
+}
+
+TEST(SearchTest, QuiescenceSeesRecapture) {
+    std::string name = "Board";
+    // Taking d5 looks like a free pawn to a one-ply search, but c6 takes the queen back
+    std::string position = "4k3/8/2p5/3p4/8/8/8/3QK3 w - - 0 1";
+    Board board(name, position);
+    Engine engine;
+
+    EXPECT_NE(engine.FindBestMove(board, 1), "d1d5");
+}
+
+TEST(SearchTest, NodeBudget) {
+    std::string name = "Board";
+    std::string position = middlegame;
+    Board board(name, position);
+    Engine engine;
+
+    SearchLimits limits;
+    limits.nodes = 20000;
+    SearchResult result = engine.Search(board, limits);
+
+    // Checked at every poll, so it can overrun by less than one poll interval
+    EXPECT_LT(result.nodes, 20000u + 1024u);
+    EXPECT_GE(result.depth, 1);
+    EXPECT_TRUE(board.IsLegalMove(result.bestMove.ToString()));
+}
+
+TEST(SearchTest, MultiPvLines) {
+    std::string name = "Board";
+    std::string position = middlegame;
+    Board board(name, position);
+
+    SearchLimits limits;
+    limits.depth = 4;
+    Engine single;
+    SearchResult best = single.Search(board, limits);
+
+    limits.multiPv = 3;
+    Engine multi;
+    SearchResult top = multi.Search(board, limits);
+
+    ASSERT_EQ(top.lines.size(), 3u);
+    EXPECT_EQ(top.lines[0].score, best.score);
+    for (size_t i = 0; i < top.lines.size(); i++) {
+        const PvLine& line = top.lines[i];
+        if (i > 0) {
+            EXPECT_LE(line.score, top.lines[i - 1].score);
+            EXPECT_NE(line.move, top.lines[i - 1].move);
+        }
+
+        // Every line is a playable sequence starting with its move
+        ASSERT_FALSE(line.pv.empty());
+        EXPECT_EQ(line.pv[0], line.move);
+        for (Move move : line.pv) {
+            EXPECT_TRUE(board.IsLegalMove(move.ToString())) << move.ToString();
+            board.MakeMove(move);
+        }
+        for (size_t j = 0; j < line.pv.size(); j++) {
+            board.UndoMove();
+        }
+    }
+
+    // One run with a shared table, not three searches
+    EXPECT_LT(top.nodes, 3 * best.nodes);
+    std::cout << "single " << best.nodes << " nodes, top 3 " << top.nodes << " nodes" << std::endl;
+}
+
+TEST(SearchTest, TraceRecordsEveryNode) {
+    std::string path = "/tmp/chessengine-test-" + std::to_string(getpid()) + ".trace";
+    std::string name = "Board";
+    std::string position = middlegame;
+    Board board(name, position);
+    Engine engine;
+    ASSERT_TRUE(engine.SetOption("TraceFile", path));
+
+    SearchLimits limits;
+    limits.depth = 4;
+    SearchResult result = engine.Search(board, limits);
+    ASSERT_TRUE(engine.SetOption("TraceFile", ""));
+
+    std::ifstream file(path, std::ios::binary);
+    TraceHeader header {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    EXPECT_EQ(std::string(header.magic, 8), "CETRACE1");
+    EXPECT_EQ(header.recordBytes, sizeof(TraceRecord));
+    std::vector<TraceRecord> records;
+    TraceRecord record;
+    while (file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        records.push_back(record);
+    }
+    std::remove(path.c_str());
+
+    // Children come before their parent: each node accounts for the records waiting one ply deeper
+    std::map<int, std::vector<TraceRecord>> waiting;
+    uint64_t rootNodes = 0;
+    int iterations = 0;
+    for (const TraceRecord& node : records) {
+        std::vector<TraceRecord> children = std::move(waiting[node.ply + 1]);
+        waiting.erase(node.ply + 1);
+        uint32_t childNodes = 0;
+        int searched = 0;
+        for (const TraceRecord& child : children) {
+            childNodes += child.nodes;
+            searched += child.kind != TraceKind::SeePruned;
+        }
+
+        if (node.kind == TraceKind::Root) {
+            iterations++;
+            EXPECT_EQ(node.depth, iterations);
+            EXPECT_EQ(node.nodes, childNodes);
+            rootNodes += node.nodes;
+        } else if (node.kind == TraceKind::Searched) {
+            EXPECT_EQ(searched, node.moves);
+            EXPECT_EQ(node.nodes, childNodes + 1);
+            if (node.cutoff) {
+                EXPECT_EQ(node.cutoff, children.size());
+            }
+        } else {
+            EXPECT_TRUE(children.empty());
+        }
+        waiting[node.ply].push_back(node);
+    }
+    EXPECT_EQ(iterations, 4);
+    EXPECT_EQ(rootNodes, result.nodes);
+}
@@ -0,0 +1,131 @@
+/**
+ * @file TranspositionTableTest.cpp
+ * @author John Korreck
+ */
+
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Engine.h"
+#include "TranspositionTable.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static std::string segmentName() {
+    return "/chessengine-test-" + std::to_string(getpid());
+}
+
+TEST(TranspositionTableTest, StoreAndProbe) {
+    TranspositionTable table(1);
+    TTEntry entry;
+    EXPECT_FALSE(table.Probe(12345, entry));
+
+    table.Store(12345, Move(52, 36), -250, 7, Bound::Lower);
+    ASSERT_TRUE(table.Probe(12345, entry));
+    EXPECT_EQ(entry.score, -250);
+    EXPECT_EQ(Move::FromRaw(entry.move), Move(52, 36));
+    EXPECT_EQ(entry.depth, 7);
+    EXPECT_EQ(entry.bound, Bound::Lower);
+
+    // A shallower non-exact result doesn't replace a deeper one
+    table.Store(12345, Move(), 10, 3, Bound::Upper);
+    ASSERT_TRUE(table.Probe(12345, entry));
+    EXPECT_EQ(entry.depth, 7);
+
+    // A key that maps to the same slot is a miss, not a wrong hit
+    EXPECT_FALSE(table.Probe(12345 + table.Size(), entry));
+}
+
+TEST(TranspositionTableTest, SharedSegmentIsSeenByEveryTable) {
+    std::string name = segmentName();
+    shm_unlink(name.c_str());
+
+    TranspositionTable first(1);
+    TranspositionTable second(1);
+    ASSERT_TRUE(first.AttachShared(name));
+    ASSERT_TRUE(second.AttachShared(name));
+    EXPECT_TRUE(second.IsShared());
+
+    first.Store(987654321, Move(12, 28), 42, 5, Bound::Exact);
+    TTEntry entry;
+    ASSERT_TRUE(second.Probe(987654321, entry));
+    EXPECT_EQ(entry.score, 42);
+
+    // A table of another size can't attach to the same segment
+    TranspositionTable other(2);
+    EXPECT_FALSE(other.AttachShared(name));
+
+    second.Resize(1);
+    EXPECT_FALSE(second.IsShared());
+    EXPECT_FALSE(second.Probe(987654321, entry));
+
+    shm_unlink(name.c_str());
+}
+
+TEST(TranspositionTableTest, EnginesShareWork) {
+    std::string name = segmentName();
+    shm_unlink(name.c_str());
+
+    std::string boardName = "Board";
+    std::string position = "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8";
+    SearchLimits limits;
+    limits.depth = 4;
+
+    Engine first;
+    ASSERT_TRUE(first.SetOption("SharedHash", name));
+    Board board(boardName, position);
+    SearchResult cold = first.Search(board, limits);
+
+    // A second engine (another worker) finds the first one's results
+    Engine second;
+    ASSERT_TRUE(second.SetOption("SharedHash", name));
+    SearchResult warm = second.Search(board, limits);
+    EXPECT_EQ(warm.bestMove, cold.bestMove);
+    EXPECT_LT(warm.nodes, cold.nodes / 2);
+
+    shm_unlink(name.c_str());
+}
+
+TEST(TranspositionTableTest, SnapshotRoundTrip) {
+    std::string path = "/tmp/chessengine-test-" + std::to_string(getpid()) + ".snap";
+    std::string boardName = "Board";
+    std::string position = "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8";
+    Board board(boardName, position);
+    SearchLimits limits;
+    limits.depth = 4;
+
+    Engine first;
+    first.SetOption("Hash", "1");
+    SearchResult cold = first.Search(board, limits);
+    ASSERT_TRUE(first.SaveSnapshot(path));
+
+    // A restarted engine answers the same request from the restored cache
+    Engine second;
+    second.SetOption("Hash", "2");
+    ASSERT_TRUE(second.LoadSnapshot(path));
+    SearchResult warm = second.Search(board, limits);
+    EXPECT_EQ(warm.bestMove, cold.bestMove);
+    EXPECT_EQ(warm.score, cold.score);
+    EXPECT_EQ(warm.nodes, 0u);
+
+    // The restored table helps with a position the cache doesn't hold
+    board.MakeMove(cold.bestMove);
+    limits.depth = 3;
+    Engine empty;
+    EXPECT_LT(second.Search(board, limits).nodes, empty.Search(board, limits).nodes);
+
+    // Any damage is caught before it is loaded
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(200);
+        file.put('\x5a');
+    }
+    Engine third;
+    EXPECT_FALSE(third.LoadSnapshot(path));
+    EXPECT_FALSE(third.LoadSnapshot(path + ".missing"));
+
+    std::remove(path.c_str());
+}
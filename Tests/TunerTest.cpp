@@ -0,0 +1,79 @@
+/**
+ * @file TunerTest.cpp
+ * @author John Korreck
+ */
+
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Engine.h"
+#include "Match.h"
+#include "PawnTable.h"
+#include "Tuner.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+TEST(TunerTest, FeaturesMatchTheEvaluation) {
+    Engine engine;
+    PawnTable pawns;
+    std::vector<double> weights = CurrentWeights();
+    std::vector<std::string> positions = DefaultOpenings();
+    positions.push_back("8/5pk1/6p1/8/3R4/6P1/5PK1/2r5 w - - 0 40");
+
+    for (const std::string& fen : positions) {
+        std::string name = "Board";
+        std::string position = fen;
+        Board board(name, position);
+        EvalFeatures features;
+        ExtractFeatures(board, pawns, features);
+
+        TuningSet set;
+        set.Add(features, 0.5);
+        // Control is summed before it is scaled down, so the engine may round it off
+        EXPECT_NEAR(set.Evaluate(0, weights.data()), engine.EvaluateBoard(board), 1.0) << fen;
+    }
+}
+
+TEST(TunerTest, TuningLowersTheError) {
+    // Each opening as a draw, and again with a knight missing as a win for the other side
+    std::string path = "/tmp/chessengine-test-" + std::to_string(getpid()) + ".epd";
+    {
+        std::ofstream file(path);
+        for (const std::string& fen : DefaultOpenings()) {
+            std::string blackDown = fen;
+            std::string whiteDown = fen;
+            blackDown[blackDown.find('n')] = '1';
+            whiteDown[whiteDown.find('N')] = '1';
+            file << fen << " [0.5]\n" << blackDown << " c9 \"1-0\";\n" << whiteDown << " 0-1\n";
+        }
+        file << "not a position\n";
+    }
+
+    TuningSet set;
+    ASSERT_TRUE(set.Load(path, 2));
+    std::remove(path.c_str());
+    ASSERT_EQ(set.Size(), DefaultOpenings().size() * 3);
+
+    TunerSettings settings;
+    settings.batchSize = 8;
+    settings.threads = 2;
+    Tuner tuner(set, CurrentWeights(), settings);
+    tuner.FitScale();
+    double before = tuner.Error();
+    for (int epoch = 0; epoch < 20; epoch++) {
+        tuner.Epoch();
+    }
+    EXPECT_LT(tuner.Error(), before);
+
+    std::string header = "/tmp/chessengine-test-" + std::to_string(getpid()) + ".h";
+    ASSERT_TRUE(WriteWeightsHeader(header, CurrentWeights()));
+    std::ifstream written(header);
+    std::stringstream text;
+    text << written.rdbuf();
+    std::remove(header.c_str());
+    EXPECT_NE(text.str().find("pieceValues[7] = {0, 100, 300, 300, 500, 900, 0};"), std::string::npos);
+    EXPECT_NE(text.str().find("controlWeights[7] = {0, 5, 10, 5, 5, 5, 3};"), std::string::npos);
+}
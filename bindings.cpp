@@ -3,19 +3,306 @@
  * @author John Korreck
  */
 
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <cstring>
+#include "AllocationTracker.h"
 #include "Engine.h"
 #include "Board.h"
+#include "FeaturePlanes.h"
+#include "GameSession.h"
+#include "PackedPosition.h"
+#include "SearchScheduler.h"
 
 namespace py = pybind11;
 
+// A new (count, 18, 8, 8) array when out is None, else out itself
+static py::object PlaneArray(size_t count, py::object out, const std::string& dtype) {
+    if (!out.is_none()) return out;
+    std::vector<py::ssize_t> shape = {static_cast<py::ssize_t>(count), FeaturePlaneCount, 8, 8};
+    if (dtype == "uint8") return py::array_t<uint8_t>(shape);
+    if (dtype == "float32") return py::array_t<float>(shape);
+    throw py::value_error("dtype must be 'uint8' or 'float32'");
+}
+
+// Checks out is a writable, C-contiguous (count, 18, 8, 8) uint8 or float32 buffer; bytes tells which
+static py::buffer_info PlaneBuffer(size_t count, const py::buffer& out, bool& bytes) {
+    py::buffer_info info = out.request(true);
+    std::vector<py::ssize_t> shape = {static_cast<py::ssize_t>(count), FeaturePlaneCount, 8, 8};
+    if (info.shape != shape) {
+        throw py::value_error("out must have shape (n, 18, 8, 8) for n positions");
+    }
+    py::ssize_t stride = info.itemsize;
+    for (int dim = 3; dim >= 0; dim--) {
+        if (info.strides[dim] != stride) throw py::value_error("out must be C-contiguous");
+        stride *= info.shape[dim];
+    }
+
+    bytes = info.format == py::format_descriptor<uint8_t>::format();
+    if (!bytes && info.format != py::format_descriptor<float>::format()) {
+        throw py::value_error("out must be uint8 or float32");
+    }
+    return info;
+}
+
+// Encodes in place; a FEN that can't be read raises rather than becoming an all-zero sample
+static void EncodeInto(const std::vector<std::string>& fens, const py::buffer& out, int threads) {
+    bool bytes;
+    py::buffer_info info = PlaneBuffer(fens.size(), out, bytes);
+    size_t bad = fens.size();
+    {
+        py::gil_scoped_release release;
+        size_t invalid = bytes ? EncodeFens(fens, static_cast<uint8_t*>(info.ptr), threads)
+                               : EncodeFens(fens, static_cast<float*>(info.ptr), threads);
+        // Rare enough to find the first one again afterwards
+        std::vector<uint8_t> scratch(invalid > 0 ? FeatureSize : 0);
+        for (size_t i = 0; i < fens.size() && invalid > 0 && bad == fens.size(); i++) {
+            if (!EncodeFen(fens[i], scratch.data())) bad = i;
+        }
+    }
+    if (bad < fens.size()) {
+        throw py::value_error("malformed FEN at index " + std::to_string(bad) + ": " + fens[bad]);
+    }
+}
+
+static void EncodeInto(const std::vector<const Board*>& boards, const py::buffer& out) {
+    bool bytes;
+    py::buffer_info info = PlaneBuffer(boards.size(), out, bytes);
+    for (const Board* board : boards) {
+        if (!board) throw py::value_error("boards must all be Board objects");
+    }
+    py::gil_scoped_release release;
+    for (size_t i = 0; i < boards.size(); i++) {
+        if (bytes) {
+            EncodeBoard(*boards[i], static_cast<uint8_t*>(info.ptr) + i * FeatureSize);
+        } else {
+            EncodeBoard(*boards[i], static_cast<float*>(info.ptr) + i * FeatureSize);
+        }
+    }
+}
+
+static py::bytes PackedBytes(const PackedPosition& packed) {
+    return py::bytes(reinterpret_cast<const char*>(&packed), sizeof(packed));
+}
+
 PYBIND11_MODULE(chessengine, m) {
     m.doc() = "Python bindings for C++ Chess Engine";
 
+    m.attr("FEATURE_PLANES") = FeaturePlaneCount;
+    m.def("allocation_tracking", &AllocationTrackingEnabled);
+    m.def("encode_fens", [](const std::vector<std::string>& fens, py::object out, const std::string& dtype,
+                            int threads) -> py::object {
+        out = PlaneArray(fens.size(), out, dtype);
+        EncodeInto(fens, out.cast<py::buffer>(), threads);
+        return out;
+    }, py::arg("fens"), py::arg("out") = py::none(), py::arg("dtype") = "float32", py::arg("threads") = 0);
+    m.def("encode_boards", [](const std::vector<const Board*>& boards, py::object out,
+                              const std::string& dtype) -> py::object {
+        out = PlaneArray(boards.size(), out, dtype);
+        EncodeInto(boards, out.cast<py::buffer>());
+        return out;
+    }, py::arg("boards"), py::arg("out") = py::none(), py::arg("dtype") = "float32");
+
+    // Positions as 32-byte records, for storage and for passing between processes
+    m.attr("PACKED_POSITION_BYTES") = sizeof(PackedPosition);
+    m.def("pack_fen", [](const std::string& fen) {
+        PackedPosition packed;
+        if (!PackFen(fen, packed)) throw py::value_error("malformed FEN: " + fen);
+        return PackedBytes(packed);
+    }, py::arg("fen"));
+    m.def("unpack_fen", [](const py::bytes& data) {
+        std::string raw = data;
+        if (raw.size() != sizeof(PackedPosition)) throw py::value_error("a packed position is 32 bytes");
+        PackedPosition packed;
+        std::memcpy(&packed, raw.data(), sizeof(packed));
+        return UnpackFen(packed);
+    }, py::arg("data"));
+    m.def("pack_fens", [](const std::vector<std::string>& fens) {
+        std::string raw(fens.size() * sizeof(PackedPosition), '\0');
+        size_t bad = fens.size();
+        {
+            py::gil_scoped_release release;
+            PackedPosition packed;
+            for (size_t i = 0; i < fens.size() && bad == fens.size(); i++) {
+                if (!PackFen(fens[i], packed)) bad = i;
+                std::memcpy(&raw[i * sizeof(packed)], &packed, sizeof(packed));
+            }
+        }
+        if (bad < fens.size()) throw py::value_error("malformed FEN: " + fens[bad]);
+        return py::bytes(raw);
+    }, py::arg("fens"));
+    m.def("unpack_fens", [](const py::bytes& data) {
+        std::string raw = data;
+        if (raw.size() % sizeof(PackedPosition) != 0) {
+            throw py::value_error("packed positions are 32 bytes each");
+        }
+        std::vector<std::string> fens(raw.size() / sizeof(PackedPosition));
+        {
+            py::gil_scoped_release release;
+            PackedPosition packed;
+            for (size_t i = 0; i < fens.size(); i++) {
+                std::memcpy(&packed, &raw[i * sizeof(packed)], sizeof(packed));
+                fens[i] = UnpackFen(packed);
+            }
+        }
+        return fens;
+    }, py::arg("data"));
+
     py::class_<Board>(m, "Board")
         .def(py::init<std::string&, std::string&>());
 
+    py::class_<LimitDecision>(m, "LimitDecision")
+        .def_readonly("adaptive", &LimitDecision::adaptive)
+        .def_readonly("movetime_ms", &LimitDecision::moveTimeMs)
+        .def_readonly("nodes", &LimitDecision::nodes)
+        .def_readonly("queued", &LimitDecision::queued)
+        .def_readonly("nps", &LimitDecision::nps)
+        .def_readonly("p99_ms", &LimitDecision::p99Ms);
+
+    py::class_<SearchResult>(m, "SearchResult")
+        .def_property_readonly("best_move", [](const SearchResult& result) {
+            return result.bestMove.IsNull() ? std::string() : result.bestMove.ToString();
+        })
+        .def_readonly("score", &SearchResult::score)
+        .def_readonly("depth", &SearchResult::depth)
+        .def_readonly("nodes", &SearchResult::nodes)
+        .def_readonly("time_ms", &SearchResult::timeMs)
+        .def_readonly("stopped", &SearchResult::stopped)
+        .def_readonly("decision", &SearchResult::decision)
+        .def_property_readonly("allocations", [](const SearchResult& result) {
+            return result.allocated.allocations;
+        })
+        .def_property_readonly("allocated_bytes", [](const SearchResult& result) {
+            return result.allocated.bytes;
+        })
+        .def_property_readonly("lines", [](const SearchResult& result) {
+            // (move, score, pv) per line, best first
+            py::list lines;
+            for (const PvLine& line : result.lines) {
+                py::list pv;
+                for (Move move : line.pv) {
+                    pv.append(move.ToString());
+                }
+                lines.append(py::make_tuple(line.move.ToString(), line.score, pv));
+            }
+            return lines;
+        });
+
+    // Searches release the GIL so another Python thread can call stop()
     py::class_<Engine>(m, "Engine")
         .def(py::init<>())
-        .def("find_best_move", &Engine::FindBestMove);
-}
\ No newline at end of file
+        .def("find_best_move", &Engine::FindBestMove, py::call_guard<py::gil_scoped_release>())
+        .def("search", [](Engine& engine, Board& board, int depth, int64_t moveTimeMs, int multiPv) {
+            SearchLimits limits;
+            limits.depth = depth;
+            limits.moveTimeMs = moveTimeMs;
+            limits.multiPv = multiPv;
+            return engine.Search(board, limits);
+        }, py::arg("board"), py::arg("depth") = 64, py::arg("movetime_ms") = 0, py::arg("multipv") = 1,
+           py::call_guard<py::gil_scoped_release>())
+        .def("stop", &Engine::Stop)
+        .def("save_snapshot", &Engine::SaveSnapshot, py::call_guard<py::gil_scoped_release>())
+        .def("load_snapshot", &Engine::LoadSnapshot, py::call_guard<py::gil_scoped_release>())
+        .def("set_option", &Engine::SetOption);
+
+    // Handles wait with the GIL released; results are copied out once done
+    py::class_<SearchJob, std::shared_ptr<SearchJob>>(m, "SearchJob")
+        .def("done", &SearchJob::IsDone)
+        .def("wait", &SearchJob::Wait, py::call_guard<py::gil_scoped_release>())
+        .def("result", [](const SearchJob& job) {
+            SearchResult result;
+            {
+                py::gil_scoped_release release;
+                result = job.Result();
+            }
+            return result;
+        })
+        .def("cancel", &SearchJob::Cancel)
+        // Iterations completed since the last call, for a streamed search; waits up to timeout_ms for one
+        .def("iterations", [](SearchJob& job, int64_t timeoutMs) {
+            py::gil_scoped_release release;
+            return job.TakeIterations(std::chrono::milliseconds(timeoutMs));
+        }, py::arg("timeout_ms") = 0)
+        .def_property_readonly("priority", &SearchJob::Priority);
+
+    py::class_<SearchScheduler>(m, "SearchScheduler")
+        .def(py::init<int, size_t>(), py::arg("threads") = 1, py::arg("hash_mb") = 16)
+        // With adaptive=True the load controller picks the budgets, and None means "too busy"
+        .def("submit", [](SearchScheduler& scheduler, const std::string& fen, int depth, int64_t moveTimeMs,
+                          int multiPv, int priority, bool adaptive, bool stream) -> std::shared_ptr<SearchJob> {
+            SearchLimits limits;
+            limits.depth = depth;
+            limits.moveTimeMs = moveTimeMs;
+            limits.multiPv = multiPv;
+            LimitDecision decision;
+            if (adaptive && !scheduler.Plan(limits, decision)) return nullptr;
+            return scheduler.Submit(fen, limits, priority, decision, stream);
+        }, py::arg("fen"), py::arg("depth") = 64, py::arg("movetime_ms") = 0, py::arg("multipv") = 1,
+           py::arg("priority") = 0, py::arg("adaptive") = false, py::arg("stream") = false)
+        .def("set_latency_target", [](SearchScheduler& scheduler, int64_t targetMs, int64_t minBudgetMs) {
+            scheduler.Controller().SetTarget(targetMs, minBudgetMs);
+        }, py::arg("target_ms"), py::arg("min_budget_ms") = 20)
+        .def_property_readonly("nps", [](SearchScheduler& scheduler) { return scheduler.Controller().Nps(); })
+        .def_property_readonly("p99_ms", [](SearchScheduler& scheduler) {
+            return scheduler.Controller().P99Ms();
+        })
+        .def("pending", &SearchScheduler::Pending)
+        .def_property_readonly("threads", &SearchScheduler::Threads)
+        .def("save_snapshot", &SearchScheduler::SaveSnapshot, py::call_guard<py::gil_scoped_release>())
+        .def("load_snapshot", &SearchScheduler::LoadSnapshot, py::call_guard<py::gil_scoped_release>())
+        .def("set_option", &SearchScheduler::SetOption);
+
+    py::enum_<GameState>(m, "GameState")
+        .value("ONGOING", GameState::Ongoing)
+        .value("CHECKMATE", GameState::Checkmate)
+        .value("STALEMATE", GameState::Stalemate)
+        .value("REPETITION", GameState::Repetition)
+        .value("FIFTY_MOVES", GameState::FiftyMoves);
+
+    // Sessions keep their scheduler alive; a session is used by one caller at a time
+    py::class_<GameSession>(m, "GameSession")
+        .def(py::init<SearchScheduler&, const std::string&>(), py::arg("scheduler"),
+             py::arg("fen") = std::string(GameSession::StartPosition), py::keep_alive<1, 2>())
+        .def("set_pondering", &GameSession::SetPondering)
+        .def_property_readonly("pondering", &GameSession::IsPondering)
+        .def("push", &GameSession::Push)
+        .def("pop", &GameSession::Pop)
+        .def("go", [](GameSession& session, int depth, int64_t moveTimeMs, int multiPv, int priority,
+                      bool adaptive) -> std::shared_ptr<SearchJob> {
+            SearchLimits limits;
+            limits.depth = depth;
+            limits.moveTimeMs = moveTimeMs;
+            limits.multiPv = multiPv;
+            LimitDecision decision;
+            if (adaptive && !session.GetScheduler().Plan(limits, decision)) return nullptr;
+            return session.Go(limits, priority, decision);
+        }, py::arg("depth") = 64, py::arg("movetime_ms") = 0, py::arg("multipv") = 1, py::arg("priority") = 0,
+           py::arg("adaptive") = false)
+        .def("result", &GameSession::Result, py::call_guard<py::gil_scoped_release>())
+        .def("best_move", [](GameSession& session, int depth, int64_t moveTimeMs, int multiPv) {
+            SearchLimits limits;
+            limits.depth = depth;
+            limits.moveTimeMs = moveTimeMs;
+            limits.multiPv = multiPv;
+            return session.BestMove(limits);
+        }, py::arg("depth") = 64, py::arg("movetime_ms") = 0, py::arg("multipv") = 1,
+           py::call_guard<py::gil_scoped_release>())
+        .def("state", &GameSession::State)
+        .def("fen", &GameSession::Fen)
+        .def("packed", [](const GameSession& session) { return PackedBytes(session.GetBoard().Pack()); })
+        .def_property_readonly("moves", [](const GameSession& session) {
+            py::list moves;
+            for (Move move : session.Moves()) {
+                moves.append(move.ToString());
+            }
+            return moves;
+        })
+        .def_property_readonly("expected_line", [](const GameSession& session) {
+            py::list moves;
+            for (Move move : session.ExpectedLine()) {
+                moves.append(move.ToString());
+            }
+            return moves;
+        });
+}
@@ -0,0 +1,273 @@
+"""Replays a JSONL request log against the service and reports latency percentiles.
+
+Each log line is a JSON object with the position to search, and optionally when it
+arrived (seconds, any origin):
+
+    {"fen": "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", "ts": 12.5}
+
+Requests go to a running server (--url), to a server started here from main.py
+(--start-server), or straight to the C++ scheduler in this process (--direct).
+They are sent at a fixed --rate, at the recorded arrival times (--speed scales
+them), or otherwise as fast as --concurrency allows. With a rate or timestamps,
+latency is measured from when each request was due, so a backed-up server
+can't hide its queueing.
+
+Save a run with --json and compare a later one against it with --compare:
+
+    python loadtest.py traffic.jsonl --start-server --rate 20 --json before.json
+    python loadtest.py traffic.jsonl --start-server --rate 20 --compare before.json
+"""
+
+import argparse
+import http.client
+import json
+import os
+import socket
+import subprocess
+import sys
+import threading
+import time
+import urllib.parse
+from collections import Counter, defaultdict
+from concurrent.futures import ThreadPoolExecutor
+
+PERCENTILES = [50, 90, 99, 99.9]
+
+
+def load_log(path, limit):
+    requests = []
+    with open(path) as log:
+        for line in log:
+            line = line.strip()
+            if not line:
+                continue
+            entry = json.loads(line)
+            if "fen" not in entry:
+                continue
+            requests.append(entry)
+            if limit and len(requests) >= limit:
+                break
+    return requests
+
+
+def percentile(values, p):
+    # Nearest rank, so p99.9 of a short run is its slowest request rather than a guess
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    rank = max(1, int(-(-len(ordered) * p // 100)))
+    return ordered[min(rank, len(ordered)) - 1]
+
+
+class HttpTarget:
+    def __init__(self, url):
+        parsed = urllib.parse.urlparse(url)
+        self.host = parsed.hostname
+        self.port = parsed.port or 80
+        self.local = threading.local()
+
+    def connection(self):
+        # One keep-alive connection per worker thread
+        if not hasattr(self.local, "connection"):
+            self.local.connection = http.client.HTTPConnection(self.host, self.port, timeout=120)
+        return self.local.connection
+
+    def search(self, fen):
+        body = json.dumps({"fen": fen})
+        try:
+            connection = self.connection()
+            connection.request("POST", "/bestmove", body, {"Content-Type": "application/json"})
+            response = connection.getresponse()
+            payload = response.read()
+        except (OSError, http.client.HTTPException):
+            del self.local.connection
+            return "error", {}
+        if response.status != 200:
+            return str(response.status), {}
+        return "ok", json.loads(payload).get("stats", {})
+
+
+class DirectTarget:
+    def __init__(self, threads, target_ms):
+        import chessengine
+        self.scheduler = chessengine.SearchScheduler(threads=threads)
+        self.scheduler.set_latency_target(target_ms, 20)
+
+    def search(self, fen):
+        job = self.scheduler.submit(fen, 64, adaptive=True)
+        if job is None:
+            return "503", {}
+        job.wait()
+        result = job.result()
+        return "ok", {"depth": result.depth, "nodes": result.nodes, "time_ms": result.time_ms}
+
+
+def free_port():
+    with socket.socket() as probe:
+        probe.bind(("127.0.0.1", 0))
+        return probe.getsockname()[1]
+
+
+def start_server(extra_env):
+    port = free_port()
+    env = dict(os.environ)
+    env.setdefault("CHESS_RATE_LIMIT", "1000000/minute")
+    env.update(extra_env)
+    server = subprocess.Popen(
+        [sys.executable, "-m", "uvicorn", "main:app", "--host", "127.0.0.1", "--port", str(port)],
+        cwd=os.path.dirname(os.path.abspath(__file__)), env=env,
+        stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+    deadline = time.monotonic() + 30
+    while time.monotonic() < deadline:
+        if server.poll() is not None:
+            raise SystemExit("server exited during startup")
+        try:
+            socket.create_connection(("127.0.0.1", port), timeout=0.5).close()
+            return server, f"http://127.0.0.1:{port}"
+        except OSError:
+            time.sleep(0.1)
+    server.kill()
+    raise SystemExit("server didn't start within 30s")
+
+
+def schedule(requests, rate, speed):
+    """Seconds after the start at which each request is due, or None to send when a worker is free."""
+    if rate > 0:
+        return [i / rate for i in range(len(requests))]
+    if speed > 0 and all("ts" in entry for entry in requests):
+        start = requests[0]["ts"]
+        return [(entry["ts"] - start) / speed for entry in requests]
+    return [None] * len(requests)
+
+
+def replay(target, requests, due, concurrency):
+    results = []
+    lock = threading.Lock()
+    slots = threading.Semaphore(concurrency)
+
+    def run(entry, due_at, start):
+        try:
+            status, stats = target.search(entry["fen"])
+            latency_ms = (time.monotonic() - (due_at if due_at is not None else start)) * 1000
+            with lock:
+                results.append((entry["fen"], status, latency_ms, stats))
+        finally:
+            slots.release()
+
+    begin = time.monotonic()
+    with ThreadPoolExecutor(max_workers=concurrency) as pool:
+        for entry, offset in zip(requests, due):
+            due_at = None
+            if offset is not None:
+                due_at = begin + offset
+                time.sleep(max(0.0, due_at - time.monotonic()))
+            slots.acquire()
+            pool.submit(run, entry, due_at, time.monotonic())
+    return results, time.monotonic() - begin
+
+
+def summarise(results, elapsed):
+    latencies = [latency for _, status, latency, _ in results if status == "ok"]
+    positions = defaultdict(list)
+    for fen, status, latency, stats in results:
+        if status == "ok":
+            positions[fen].append((latency, stats))
+
+    per_position = {}
+    for fen, runs in positions.items():
+        per_position[fen] = {
+            "count": len(runs),
+            "p50_ms": percentile([latency for latency, _ in runs], 50),
+            "max_ms": max(latency for latency, _ in runs),
+            "depth": sum(stats.get("depth", 0) for _, stats in runs) / len(runs),
+            "nodes": sum(stats.get("nodes", 0) for _, stats in runs) / len(runs),
+        }
+
+    return {
+        "requests": len(results),
+        "elapsed_s": elapsed,
+        "throughput_rps": len(latencies) / elapsed if elapsed > 0 else 0.0,
+        "status": dict(Counter(status for _, status, _, _ in results)),
+        "latency_ms": {f"p{p:g}": percentile(latencies, p) for p in PERCENTILES},
+        "mean_depth": sum(stats.get("depth", 0) for _, s, _, stats in results if s == "ok") / max(1, len(latencies)),
+        "positions": per_position,
+    }
+
+
+def report(summary, top, baseline=None):
+    def delta(now, before):
+        if not before:
+            return ""
+        return f"  ({(now - before) / before * 100:+.1f}%)"
+
+    base_latency = baseline["latency_ms"] if baseline else {}
+    print(f"requests   {summary['requests']} in {summary['elapsed_s']:.1f}s, "
+          f"status {summary['status']}")
+    print(f"throughput {summary['throughput_rps']:.2f} req/s"
+          + delta(summary["throughput_rps"], baseline and baseline["throughput_rps"]))
+    for name, value in summary["latency_ms"].items():
+        print(f"{name:<10} {value:9.1f} ms" + delta(value, base_latency.get(name)))
+    print(f"mean depth {summary['mean_depth']:.1f}"
+          + delta(summary["mean_depth"], baseline and baseline["mean_depth"]))
+
+    if top:
+        print(f"\nslowest positions (p50 latency, mean depth and nodes):")
+        slowest = sorted(summary["positions"].items(), key=lambda item: -item[1]["p50_ms"])[:top]
+        for fen, stats in slowest:
+            print(f"  {stats['p50_ms']:8.1f} ms  x{stats['count']:<4} depth {stats['depth']:4.1f}  "
+                  f"nodes {stats['nodes']:10.0f}  {fen}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", help="JSONL request log")
+    target = parser.add_mutually_exclusive_group(required=True)
+    target.add_argument("--url", help="running server, e.g. http://127.0.0.1:8000")
+    target.add_argument("--start-server", action="store_true", help="start main.py under uvicorn for the run")
+    target.add_argument("--direct", action="store_true", help="call the C++ scheduler in this process")
+    parser.add_argument("--rate", type=float, default=0, help="requests per second (default: recorded times)")
+    parser.add_argument("--speed", type=float, default=1.0, help="replay recorded times this much faster")
+    parser.add_argument("--concurrency", type=int, default=16, help="requests in flight at most")
+    parser.add_argument("--limit", type=int, default=0, help="replay only the first N requests")
+    parser.add_argument("--threads", type=int, default=os.cpu_count() or 1, help="search threads for --direct")
+    parser.add_argument("--target-ms", type=int, default=1000, help="latency target for --direct")
+    parser.add_argument("--env", action="append", default=[], help="NAME=value for a started server")
+    parser.add_argument("--positions", type=int, default=10, help="slowest positions to list")
+    parser.add_argument("--json", help="write the summary here")
+    parser.add_argument("--compare", help="summary from an earlier run to compare against")
+    args = parser.parse_args()
+
+    requests = load_log(args.log, args.limit)
+    if not requests:
+        raise SystemExit(f"no requests with a fen in {args.log}")
+
+    server = None
+    if args.direct:
+        target = DirectTarget(args.threads, args.target_ms)
+    else:
+        url = args.url
+        if args.start_server:
+            server, url = start_server(dict(item.split("=", 1) for item in args.env))
+        target = HttpTarget(url)
+
+    try:
+        results, elapsed = replay(target, requests, schedule(requests, args.rate, args.speed), args.concurrency)
+    finally:
+        if server:
+            server.terminate()
+            server.wait()
+
+    summary = summarise(results, elapsed)
+    baseline = None
+    if args.compare:
+        with open(args.compare) as previous:
+            baseline = json.load(previous)
+    report(summary, args.positions, baseline)
+    if args.json:
+        with open(args.json, "w") as output:
+            json.dump(summary, output, indent=2)
+
+
+if __name__ == "__main__":
+    main()
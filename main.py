@@ -1,8 +1,16 @@
-from fastapi import FastAPI, Request
+from fastapi import FastAPI, HTTPException, Request
+from fastapi.concurrency import run_in_threadpool
 from fastapi.middleware.cors import CORSMiddleware
+from fastapi.responses import StreamingResponse
 from pydantic import BaseModel
 from slowapi import Limiter, _rate_limit_exceeded_handler
 from slowapi.errors import RateLimitExceeded
+from collections import OrderedDict
+from typing import Optional
+import asyncio
+import json
+import os
+import uuid
 import chessengine
 
 app = FastAPI()
@@ -28,11 +36,190 @@ app.add_exception_handler(RateLimitExceeded, _rate_limit_exceeded_handler)
 class MoveRequest(BaseModel):
     fen: str
 
-engine = chessengine.Engine()
+class SessionRequest(BaseModel):
+    fen: Optional[str] = None
+
+class SessionMoveRequest(BaseModel):
+    move: str
+
+# Searches are time-sliced on a fixed pool of threads, most urgent first
+scheduler = chessengine.SearchScheduler(threads=int(os.environ.get("CHESS_THREADS", os.cpu_count() or 1)))
+
+# Search budgets follow the load so that requests finish within the latency target:
+# the whole target when idle, a share of the threads under bursts, and 503 beyond that
+TARGET_P99_MS = int(os.environ.get("CHESS_TARGET_P99_MS", os.environ.get("CHESS_MOVE_TIME_MS", "1000")))
+MIN_BUDGET_MS = int(os.environ.get("CHESS_MIN_BUDGET_MS", "20"))
+MAX_DEPTH = int(os.environ.get("CHESS_MAX_DEPTH", "64"))
+RATE_LIMIT = os.environ.get("CHESS_RATE_LIMIT", "10/minute")
+scheduler.set_latency_target(TARGET_P99_MS, MIN_BUDGET_MS)
+
+# Transposition table size, optionally shared by every worker process on the machine
+hash_mb = os.environ.get("CHESS_HASH_MB")
+if hash_mb:
+    scheduler.set_option("Hash", hash_mb)
+shared_hash = os.environ.get("CHESS_SHARED_HASH")
+if shared_hash:
+    scheduler.set_option("HugePages", os.environ.get("CHESS_HUGE_PAGES", "false"))
+    if not scheduler.set_option("SharedHash", shared_hash):
+        print(f"Could not attach shared hash {shared_hash}; using a private table")
+
+# Optional NNUE evaluator, memory-mapped once at startup
+eval_file = os.environ.get("CHESS_EVAL_FILE")
+if eval_file and scheduler.set_option("EvalFile", eval_file):
+    scheduler.set_option("UseNNUE", "true")
+
+# Warm caches across restarts: load at startup, save periodically and on shutdown
+SNAPSHOT_PATH = os.environ.get("CHESS_SNAPSHOT")
+SNAPSHOT_INTERVAL = int(os.environ.get("CHESS_SNAPSHOT_INTERVAL", "300"))
+
+async def save_snapshot():
+    await run_in_threadpool(scheduler.save_snapshot, SNAPSHOT_PATH)
+
+async def save_snapshots_periodically():
+    while True:
+        await asyncio.sleep(SNAPSHOT_INTERVAL)
+        await save_snapshot()
+
+@app.on_event("startup")
+async def load_snapshot():
+    if SNAPSHOT_PATH:
+        scheduler.load_snapshot(SNAPSHOT_PATH)
+        if SNAPSHOT_INTERVAL > 0:
+            app.state.snapshot_task = asyncio.create_task(save_snapshots_periodically())
+
+@app.on_event("shutdown")
+async def store_snapshot():
+    if SNAPSHOT_PATH:
+        await save_snapshot()
+
+async def wait_for_search(request: Request, job):
+    search = asyncio.ensure_future(run_in_threadpool(job.wait))
+    # Stop burning CPU for a client that has gone away. Other requests may share the
+    # search, so it only stops once they have all cancelled.
+    while not search.done():
+        await asyncio.wait({search}, timeout=0.05)
+        if not search.done() and await request.is_disconnected():
+            job.cancel()
+            break
+    await search
+
+def search_stats(result):
+    decision = result.decision
+    stats = {
+        "depth": result.depth,
+        "nodes": result.nodes,
+        "time_ms": result.time_ms,
+        "movetime_ms": decision.movetime_ms,
+        "node_budget": decision.nodes,
+        "queued": decision.queued,
+    }
+    # Only the instrumentation build counts allocations
+    if chessengine.allocation_tracking():
+        stats["allocations"] = result.allocations
+        stats["allocated_bytes"] = result.allocated_bytes
+    return stats
+
+def server_busy():
+    return HTTPException(status_code=503, detail="Server busy, try again shortly")
 
 @app.post("/bestmove")
-@limiter.limit("10/minute")
+@limiter.limit(RATE_LIMIT)
 async def best_move(request: Request, move_request: MoveRequest):
-    board = chessengine.Board("Board", move_request.fen)
-    move = engine.find_best_move(board, 3)
-    return {"best_move": move}
+    job = scheduler.submit(move_request.fen, MAX_DEPTH, adaptive=True)
+    if job is None:
+        raise server_busy()
+    await wait_for_search(request, job)
+    result = job.result()
+    return {"best_move": result.best_move, "stats": search_stats(result)}
+
+# Analysis streamed while it deepens; the client picks its own depth and time, up to this
+MAX_ANALYSIS_MS = int(os.environ.get("CHESS_MAX_ANALYSIS_MS", "30000"))
+
+def iteration_event(result):
+    nps = result.nodes * 1000 // result.time_ms if result.time_ms > 0 else 0
+    lines = result.lines
+    update = {
+        "depth": result.depth,
+        "score": result.score,
+        "best_move": result.best_move,
+        "pv": lines[0][2] if lines else [],
+        "nodes": result.nodes,
+        "nps": nps,
+        "time_ms": result.time_ms,
+    }
+    return f"event: iteration\ndata: {json.dumps(update)}\n\n"
+
+@app.get("/analyze")
+@limiter.limit(RATE_LIMIT)
+async def analyze(request: Request, fen: str, depth: int = MAX_DEPTH, movetime_ms: int = MAX_ANALYSIS_MS):
+    """Server-Sent Events: an `iteration` event per completed depth, then `done` with the move.
+    Closing the connection stops the search."""
+    depth = max(1, min(depth, MAX_DEPTH))
+    movetime_ms = max(1, min(movetime_ms, MAX_ANALYSIS_MS))
+    job = scheduler.submit(fen, depth, movetime_ms, stream=True)
+
+    async def events():
+        try:
+            while True:
+                done = job.done()
+                for result in await run_in_threadpool(job.iterations, 50):
+                    yield iteration_event(result)
+                if done:
+                    break
+                if await request.is_disconnected():
+                    return
+            result = job.result()
+            summary = {"best_move": result.best_move, "score": result.score, "stats": search_stats(result)}
+            yield f"event: done\ndata: {json.dumps(summary)}\n\n"
+        finally:
+            if not job.done():
+                job.cancel()
+
+    return StreamingResponse(events(), media_type="text/event-stream",
+                             headers={"Cache-Control": "no-cache", "X-Accel-Buffering": "no"})
+
+# Games played move by move, so searches see the history; least recently used evicted first
+MAX_SESSIONS = int(os.environ.get("CHESS_MAX_SESSIONS", "1000"))
+# Think on the expected reply while the opponent is moving
+PONDER = os.environ.get("CHESS_PONDER", "true").lower() in ("1", "true")
+sessions = OrderedDict()
+
+def get_session(session_id: str):
+    if session_id not in sessions:
+        raise HTTPException(status_code=404, detail="Unknown session")
+    sessions.move_to_end(session_id)
+    return sessions[session_id]
+
+@app.post("/session")
+@limiter.limit(RATE_LIMIT)
+async def create_session(request: Request, session_request: SessionRequest):
+    if session_request.fen:
+        session = chessengine.GameSession(scheduler, session_request.fen)
+    else:
+        session = chessengine.GameSession(scheduler)
+    session.set_pondering(PONDER)
+    session_id = uuid.uuid4().hex
+    sessions[session_id] = (session, asyncio.Lock())
+    while len(sessions) > MAX_SESSIONS:
+        sessions.popitem(last=False)
+    return {"session_id": session_id, "fen": session.fen()}
+
+@app.post("/session/{session_id}/move")
+async def push_move(session_id: str, move_request: SessionMoveRequest):
+    session, lock = get_session(session_id)
+    async with lock:
+        if not session.push(move_request.move):
+            raise HTTPException(status_code=400, detail="Illegal move")
+        return {"fen": session.fen(), "state": session.state().name.lower()}
+
+@app.post("/session/{session_id}/bestmove")
+@limiter.limit(RATE_LIMIT)
+async def session_best_move(request: Request, session_id: str):
+    session, lock = get_session(session_id)
+    async with lock:
+        job = session.go(MAX_DEPTH, adaptive=True)
+        if job is None:
+            raise server_busy()
+        await wait_for_search(request, job)
+        result = session.result()
+    return {"best_move": result.best_move, "state": session.state().name.lower(), "stats": search_stats(result)}
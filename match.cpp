@@ -0,0 +1,159 @@
+/**
+ * @file match.cpp
+ * @author John Korreck
+ *
+ * Plays one engine configuration against another and reports the Elo
+ * difference, stopping once the SPRT decides. With --uci it is instead this
+ * engine as a UCI program, so a build can be matched against another build.
+ *
+ *   match --first engine --second "uci:./old/match --uci" --tc 10+0.1 --concurrency 8
+ *   match --first engine:UseNNUE=true,EvalFile=net.nnue --second engine --sprt 0 5
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "Match.h"
+#include "Uci.h"
+
+static void Usage() {
+    std::cerr <<
+        "usage: match --uci\n"
+        "       match --first SPEC --second SPEC [options]\n"
+        "\n"
+        "  SPEC is engine, engine:Name=value,... (this engine with options) or uci:COMMAND\n"
+        "\n"
+        "  --games N              most games to play (default 1000)\n"
+        "  --concurrency N        games at once (default: one per core)\n"
+        "  --tc BASE+INC          time control in seconds (default 10+0.1)\n"
+        "  --depth N, --nodes N   fixed limits per move instead of a clock\n"
+        "  --openings FILE        FEN/EPD suite (default: a few common openings)\n"
+        "  --sprt ELO0 ELO1 [ALPHA BETA]   hypotheses (default 0 5 0.05 0.05)\n"
+        "  --no-sprt              play every game\n"
+        "  --resign SCORE MOVES   adjudicate wins (default 1000 3)\n"
+        "  --draw SCORE MOVES FROM   adjudicate draws (default 10 8 40)\n"
+        "  --max-moves N          draw after this many moves (default 300)\n";
+}
+
+static const char* ResultText(const GameRecord& game) {
+    switch (game.outcome) {
+        case GameOutcome::WhiteWins: return "1-0";
+        case GameOutcome::BlackWins: return "0-1";
+        default: return "1/2-1/2";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string first;
+    std::string second;
+    MatchSettings settings;
+    settings.concurrency = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                Usage();
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--uci") {
+            RunUci(std::cin, std::cout);
+            return 0;
+        } else if (arg == "--first") {
+            first = next();
+        } else if (arg == "--second") {
+            second = next();
+        } else if (arg == "--games") {
+            settings.games = std::atoi(next().c_str());
+        } else if (arg == "--concurrency") {
+            settings.concurrency = std::max(1, std::atoi(next().c_str()));
+        } else if (arg == "--tc") {
+            std::string tc = next();
+            size_t plus = tc.find('+');
+            settings.baseMs = static_cast<int64_t>(std::atof(tc.substr(0, plus).c_str()) * 1000);
+            settings.incrementMs = plus == std::string::npos ? 0 :
+                                   static_cast<int64_t>(std::atof(tc.substr(plus + 1).c_str()) * 1000);
+        } else if (arg == "--depth") {
+            settings.depth = std::atoi(next().c_str());
+            settings.baseMs = 0;
+        } else if (arg == "--nodes") {
+            settings.nodes = std::strtoull(next().c_str(), nullptr, 10);
+            settings.baseMs = 0;
+        } else if (arg == "--openings") {
+            std::string path = next();
+            settings.openings = LoadOpenings(path);
+            if (settings.openings.empty()) {
+                std::cerr << "no openings in " << path << "\n";
+                return 1;
+            }
+        } else if (arg == "--sprt") {
+            settings.sprt = true;
+            settings.elo0 = std::atof(next().c_str());
+            settings.elo1 = std::atof(next().c_str());
+            if (i + 2 < argc && argv[i + 1][0] != '-') {
+                settings.alpha = std::atof(next().c_str());
+                settings.beta = std::atof(next().c_str());
+            }
+        } else if (arg == "--no-sprt") {
+            settings.sprt = false;
+        } else if (arg == "--resign") {
+            settings.resignScore = std::atoi(next().c_str());
+            settings.resignMoves = std::atoi(next().c_str());
+        } else if (arg == "--draw") {
+            settings.drawScore = std::atoi(next().c_str());
+            settings.drawMoves = std::atoi(next().c_str());
+            settings.drawFromMove = std::atoi(next().c_str());
+        } else if (arg == "--max-moves") {
+            settings.maxMoves = std::atoi(next().c_str());
+        } else {
+            Usage();
+            return 2;
+        }
+    }
+
+    PlayerFactory firstPlayer = ParsePlayer(first);
+    PlayerFactory secondPlayer = ParsePlayer(second);
+    if (!firstPlayer || !secondPlayer) {
+        Usage();
+        return 2;
+    }
+
+    Match match(firstPlayer, secondPlayer, settings);
+    const Sprt& sprt = match.GetSprt();
+    MatchScore score = match.Run([&](const GameRecord& game, const MatchScore& total) {
+        std::printf("Game %lld: %s %s (%s)  +%lld =%lld -%lld  Elo %.1f +/- %.1f",
+                    static_cast<long long>(total.Games()), game.firstPlayedWhite ? "first-second" : "second-first",
+                    ResultText(game), game.reason.c_str(), static_cast<long long>(total.wins),
+                    static_cast<long long>(total.draws), static_cast<long long>(total.losses),
+                    EloFromScore(total), EloErrorMargin(total));
+        if (settings.sprt) {
+            std::printf("  LLR %.2f [%.2f, %.2f]", sprt.Llr(total), sprt.LowerBound(), sprt.UpperBound());
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+    });
+
+    if (match.FailedWorkers() == settings.concurrency) {
+        std::cerr << "couldn't start the players\n";
+        return 1;
+    }
+
+    std::printf("\nFinished: %lld games, +%lld =%lld -%lld, Elo %.1f +/- %.1f\n",
+                static_cast<long long>(score.Games()), static_cast<long long>(score.wins),
+                static_cast<long long>(score.draws), static_cast<long long>(score.losses),
+                EloFromScore(score), EloErrorMargin(score));
+    if (settings.sprt) {
+        SprtDecision decision = match.Decision();
+        std::printf("SPRT (elo0 %.1f, elo1 %.1f): %s\n", sprt.Elo0(), sprt.Elo1(),
+                    decision == SprtDecision::AcceptH1 ? "H1 accepted, first is stronger" :
+                    decision == SprtDecision::AcceptH0 ? "H0 accepted, first isn't stronger by elo1" :
+                    "inconclusive");
+    }
+    return 0;
+}
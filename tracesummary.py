@@ -0,0 +1,159 @@
+"""Summarises a search trace written with the engine's TraceFile option.
+
+Shows where a search spent its nodes: the branching factor and cutoff rate at
+each ply, where in the move order cutoffs happen, and the subtrees searched in
+vain before a later move failed high. Good ordering cuts on the first move, so
+these point at the plies and positions where ordering or pruning can improve.
+
+    setoption name TraceFile value slow.trace    (UCI, or Engine.set_option in Python)
+    python tracesummary.py slow.trace
+"""
+
+import argparse
+import heapq
+import struct
+from collections import defaultdict
+
+MAGIC = b"CETRACE1"
+HEADER = struct.Struct("<8sII")
+RECORD = struct.Struct("<iiiIHBBBbBB")
+
+SEARCHED, TABLE_HIT, DRAW, TERMINAL, QUIESCENCE, SEE_PRUNED, ROOT = range(7)
+CUTOFF_BUCKETS = [(1, 1), (2, 2), (3, 3), (4, 5), (6, 10), (11, 255)]
+
+
+def move_name(raw):
+    if raw == 0:
+        return "-"
+
+    def square(index):
+        return "abcdefgh"[index % 8] + str(8 - index // 8)
+
+    text = square(raw & 63) + square((raw >> 6) & 63)
+    promotion = raw >> 12
+    return text + " pnbrq"[promotion] if promotion else text
+
+
+def read_trace(path):
+    with open(path, "rb") as trace:
+        data = trace.read()
+    if len(data) < HEADER.size:
+        raise SystemExit(f"{path} is too short to be a trace")
+    magic, version, record_bytes = HEADER.unpack_from(data)
+    if magic != MAGIC or record_bytes != RECORD.size:
+        raise SystemExit(f"{path} is not a version {version} search trace this tool can read")
+    usable = (len(data) - HEADER.size) // RECORD.size * RECORD.size
+    return RECORD.iter_unpack(data[HEADER.size:HEADER.size + usable])
+
+
+class Summary:
+    def __init__(self, top):
+        self.top = top
+        self.kinds = defaultdict(lambda: defaultdict(int))   # ply -> kind -> count
+        self.interior = defaultdict(int)                     # ply -> searched nodes
+        self.moves = defaultdict(int)                        # ply -> moves searched
+        self.cutoffs = defaultdict(int)                      # ply -> nodes that failed high
+        self.first_cutoffs = defaultdict(int)
+        self.cutoff_positions = defaultdict(int)             # position in move order -> count
+        self.wasted = defaultdict(int)                       # ply -> nodes before the cutoff move
+        self.wasted_subtrees = []                            # min-heap of the largest `top`
+        self.iterations = []                                 # (depth, nodes, moves)
+        self.total_nodes = 0
+
+    def add(self, node, children):
+        alpha, beta, result, nodes, move, moves, cutoff, ply, depth, kind, flags = node
+        if kind == ROOT:
+            self.iterations.append((depth, nodes, moves))
+            self.total_nodes += nodes
+            return
+        self.kinds[ply][kind] += 1
+        if kind != SEARCHED:
+            return
+
+        self.interior[ply] += 1
+        self.moves[ply] += moves
+        if not cutoff:
+            return
+        self.cutoffs[ply] += 1
+        self.cutoff_positions[cutoff] += 1
+        if cutoff == 1:
+            self.first_cutoffs[ply] += 1
+            return
+
+        # Everything searched before the move that failed high was spent for nothing
+        before = [child for child in children[:cutoff - 1] if child[9] != SEE_PRUNED]
+        self.wasted[ply] += sum(child[3] for child in before)
+        for child in before:
+            if self.top == 0 or (len(self.wasted_subtrees) == self.top and child[3] <= self.wasted_subtrees[0][0]):
+                continue
+            entry = (child[3], ply + 1, child[8], move_name(move), move_name(child[4]),
+                     move_name(children[cutoff - 1][4]), cutoff)
+            if len(self.wasted_subtrees) < self.top:
+                heapq.heappush(self.wasted_subtrees, entry)
+            else:
+                heapq.heapreplace(self.wasted_subtrees, entry)
+
+
+def summarise(records, top):
+    summary = Summary(top)
+    waiting = defaultdict(list)
+    for node in records:
+        ply = node[7]
+        children = waiting.pop(ply + 1, [])
+        summary.add(node, children)
+        if node[9] == ROOT:
+            waiting.clear()
+        else:
+            waiting[ply].append(node)
+    return summary
+
+
+def percent(part, whole):
+    return 100.0 * part / whole if whole else 0.0
+
+
+def report(summary):
+    print("iterations")
+    for depth, nodes, moves in summary.iterations:
+        print(f"  depth {depth:3}  {nodes:12} nodes  {moves:3} root moves")
+    if not summary.iterations:
+        print("  none completed")
+        return
+
+    print("\nply      nodes  searched  branching  cutoff%  first%   tt hit  pruned    qsearch  wasted%")
+    for ply in sorted(summary.kinds):
+        kinds = summary.kinds[ply]
+        count = sum(count for kind, count in kinds.items() if kind != SEE_PRUNED)
+        interior = summary.interior[ply]
+        branching = summary.moves[ply] / interior if interior else 0.0
+        print(f"{ply:3} {count:10} {interior:9} {branching:10.2f} {percent(summary.cutoffs[ply], interior):8.1f} "
+              f"{percent(summary.first_cutoffs[ply], summary.cutoffs[ply]):7.1f} {kinds[TABLE_HIT]:8} "
+              f"{kinds[SEE_PRUNED]:7} {kinds[QUIESCENCE]:10} {percent(summary.wasted[ply], summary.total_nodes):8.2f}")
+
+    cutoffs = sum(summary.cutoff_positions.values())
+    print("\ncutoff position in move order")
+    for low, high in CUTOFF_BUCKETS:
+        count = sum(n for position, n in summary.cutoff_positions.items() if low <= position <= high)
+        label = str(low) if low == high else f"{low}-{high}" if high < 255 else f"{low}+"
+        print(f"  {label:>6}  {count:10}  {percent(count, cutoffs):5.1f}%")
+
+    wasted = sum(summary.wasted.values())
+    print(f"\nwasted before a later cutoff: {wasted} of {summary.total_nodes} nodes "
+          f"({percent(wasted, summary.total_nodes):.1f}%)")
+    if summary.wasted_subtrees:
+        print("largest wasted subtrees:")
+        for nodes, ply, depth, parent, move, cut_by, cutoff in sorted(summary.wasted_subtrees, reverse=True):
+            print(f"  {nodes:10} nodes  ply {ply:2}  depth {depth:2}  after {parent:<6} {move:<6} "
+                  f"searched before {cut_by} cut off at #{cutoff}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("trace", help="file written by the TraceFile option")
+    parser.add_argument("--top", type=int, default=10, help="wasted subtrees to list")
+    args = parser.parse_args()
+    report(summarise(read_trace(args.trace), args.top))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,118 @@
+/**
+ * @file tune.cpp
+ * @author John Korreck
+ *
+ * Tunes the hand-written evaluation's weights on labelled positions and writes
+ * them out as a new EvalWeights.h. Rebuild with it in place, then check the
+ * result with the match runner before committing it.
+ *
+ *   tune positions.epd --output ChessEngineLib/EvalWeights.h --epochs 100
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "Tuner.h"
+
+static void Usage() {
+    std::cerr <<
+        "usage: tune POSITIONS [options]\n"
+        "\n"
+        "  POSITIONS              one FEN or EPD per line, followed by the result:\n"
+        "                         1-0, 0-1, 1/2-1/2, or [1.0], [0.5], [0.0]\n"
+        "\n"
+        "  --output FILE          header to write (default EvalWeights.h)\n"
+        "  --epochs N             passes over the positions (default 100)\n"
+        "  --batch N              positions per step, 0 for all (default 16384)\n"
+        "  --rate X               Adam step size in centipawns (default 1)\n"
+        "  --scale X              sigmoid scale instead of fitting one to the current weights\n"
+        "  --threads N            default: one per core\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string positions;
+    std::string output = "EvalWeights.h";
+    int epochs = 100;
+    double scale = 0;
+    TunerSettings settings;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                Usage();
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--output") {
+            output = next();
+        } else if (arg == "--epochs") {
+            epochs = std::atoi(next().c_str());
+        } else if (arg == "--batch") {
+            settings.batchSize = std::strtoull(next().c_str(), nullptr, 10);
+        } else if (arg == "--rate") {
+            settings.learningRate = std::atof(next().c_str());
+        } else if (arg == "--scale") {
+            scale = std::atof(next().c_str());
+        } else if (arg == "--threads") {
+            settings.threads = std::atoi(next().c_str());
+        } else if (positions.empty() && arg[0] != '-') {
+            positions = arg;
+        } else {
+            Usage();
+            return 2;
+        }
+    }
+    if (positions.empty()) {
+        Usage();
+        return 2;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto seconds = [](Clock::time_point since) {
+        return std::chrono::duration<double>(Clock::now() - since).count();
+    };
+
+    auto start = Clock::now();
+    TuningSet set;
+    if (!set.Load(positions, settings.threads)) {
+        std::cerr << "can't read " << positions << "\n";
+        return 1;
+    }
+    if (set.Size() == 0) {
+        std::cerr << "no labelled positions in " << positions << "\n";
+        return 1;
+    }
+    std::printf("Loaded %zu positions in %.1fs\n", set.Size(), seconds(start));
+
+    Tuner tuner(set, CurrentWeights(), settings);
+    if (scale > 0) {
+        tuner.SetScale(scale);
+    } else {
+        tuner.FitScale();
+    }
+    double initial = tuner.Error();
+    std::printf("Scale %.4f, error %.6f\n", tuner.Scale(), initial);
+    std::fflush(stdout);
+
+    start = Clock::now();
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        tuner.Epoch();
+        if (epoch % 10 == 0 || epoch == epochs) {
+            std::printf("Epoch %d: error %.6f (%.1fs)\n", epoch, tuner.Error(), seconds(start));
+            std::fflush(stdout);
+        }
+    }
+
+    if (!WriteWeightsHeader(output, tuner.Weights())) {
+        std::cerr << "can't write " << output << "\n";
+        return 1;
+    }
+    std::printf("Error %.6f -> %.6f, weights written to %s\n", initial, tuner.Error(), output.c_str());
+    return 0;
+}